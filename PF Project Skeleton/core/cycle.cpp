@@ -0,0 +1,115 @@
+#include "cycle.h"
+#include "simulation_state.h"
+#include "state_hash.h"
+#include "snapshot.h"
+#include "trains.h"
+#include <cstdlib>
+
+// ============================================================================
+// CYCLE.CPP - Livelock detection
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// BRENT STATE
+// ----------------------------------------------------------------------------
+// The "tortoise" is a saved state; every tick is compared against it. When
+// the distance to it reaches the current power of two it moves forward.
+// ----------------------------------------------------------------------------
+static unsigned char* TortoiseSnapshot = NULL;
+static int TortoiseBytes = 0;
+static unsigned long long TortoiseHash = 0;
+static bool HasTortoise = false;
+static int BrentPower = 1;
+static int BrentLength = 0;
+
+static int CycleLength = 0;   // > 0 once a cycle is confirmed
+static int CycleFoundTick = -1;
+
+// ----------------------------------------------------------------------------
+// INITIALIZE / RESET
+// ----------------------------------------------------------------------------
+void initializeCycleDetection() {
+    resetCycleDetection();
+}
+
+void resetCycleDetection() {
+    HasTortoise = false;
+    BrentPower = 1;
+    BrentLength = 0;
+    CycleLength = 0;
+    CycleFoundTick = -1;
+}
+
+// ----------------------------------------------------------------------------
+// Makes the current state the tortoise. Its buffer grows when a level with
+// more switches needs a larger snapshot. Returns false if out of memory.
+// ----------------------------------------------------------------------------
+static bool saveTortoise(unsigned long long hash) {
+    int bytes = getSnapshotSize();
+    if (bytes > TortoiseBytes) {
+        unsigned char* grown = (unsigned char*)realloc(TortoiseSnapshot, bytes);
+        if (!grown) return false;
+        TortoiseSnapshot = grown;
+        TortoiseBytes = bytes;
+    }
+    saveSnapshot(TortoiseSnapshot);
+    TortoiseHash = hash;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// UPDATE CYCLE DETECTION
+// ----------------------------------------------------------------------------
+void updateCycleDetection() {
+    if (CycleLength > 0) return;
+
+    // Pending spawns make the future depend on the tick number, and with no
+    // train on the track the run is simply complete
+    if (getWaitingTrainCount() > 0) {
+        HasTortoise = false;
+        return;
+    }
+    int active = ActiveTrainCount;
+    // Halt zones run on timers and weather draws depend on the tick, so the
+    // state cannot repeat while either is in play
+    if (active == 0 || ActiveHaltZones > 0 || GameWeather != WEATHER_NORMAL) {
+        HasTortoise = false;
+        return;
+    }
+
+    unsigned long long hash = getStateHash();
+    if (!HasTortoise) {
+        if (!saveTortoise(hash)) return;
+        HasTortoise = true;
+        BrentPower = 1;
+        BrentLength = 0;
+        return;
+    }
+
+    BrentLength++;
+    if (hash == TortoiseHash && sameStateAsSnapshot(TortoiseSnapshot)) {
+        CycleLength = BrentLength;
+        CycleFoundTick = CurrentTick;
+        return;
+    }
+    if (BrentLength == BrentPower) {
+        HasTortoise = saveTortoise(hash);
+        BrentPower *= 2;
+        BrentLength = 0;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// QUERIES
+// ----------------------------------------------------------------------------
+bool isLivelocked() {
+    return CycleLength > 0;
+}
+
+int getCycleLength() {
+    return CycleLength;
+}
+
+int getCycleStart() {
+    return CycleLength > 0 ? CycleFoundTick - 1 : -1;
+}
@@ -0,0 +1,44 @@
+#ifndef CYCLE_H
+#define CYCLE_H
+
+// ============================================================================
+// CYCLE.H - Livelock detection
+// ============================================================================
+// Brent's cycle finding on the per-tick state hash. A hash match is confirmed
+// against a full snapshot, so a reported cycle is a real repeat of the whole
+// state and the run can never leave it. Cost per tick is one 64-bit compare,
+// plus one snapshot each time the checked distance doubles.
+//
+// Detection only runs once every train has spawned, because pending spawns
+// depend on the tick number, which is not part of the state, and while at
+// least one train is still on the track.
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// SETUP
+// ----------------------------------------------------------------------------
+// Clear the detector (called when a simulation starts).
+void initializeCycleDetection();
+
+// Forget what was seen so far (call after an outside edit of the state).
+void resetCycleDetection();
+
+// ----------------------------------------------------------------------------
+// UPDATE
+// ----------------------------------------------------------------------------
+// Check the state at the end of a tick (called once per tick).
+void updateCycleDetection();
+
+// ----------------------------------------------------------------------------
+// QUERIES
+// ----------------------------------------------------------------------------
+// True once the state has provably repeated.
+bool isLivelocked();
+
+// Ticks per repetition (0 if no cycle was found).
+int getCycleLength();
+
+// Tick whose end state the cycle repeats (-1 if no cycle was found).
+int getCycleStart();
+
+#endif
@@ -1,10 +1,211 @@
 #include "grid.h"
 #include "simulation_state.h"
+#include "routing.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 // ============================================================================
 // GRID.CPP - Grid utilities
 // ============================================================================
 
+// Character of each class (switches use their chunk's switch ID block,
+// other symbols the detail row)
+static const char TileClassChars[16] = { '\0', ' ', '-', '|', '/', '\\', '+', 'S', 'D', '=' };
+
+// Slots GridChunks, detail rows GridDetail and switch ID blocks GridSwitchIds
+// have room for
+static int GridChunksAllocated = 0;
+static int GridDetailRowsAllocated = 0;
+static int GridSwitchBlocksAllocated = 0;
+
+// GridDetailRow holds a detail row + 1 per map row, and every map row can
+// need one
+#if MAX_ROWS > 255
+#error "GridDetailRow stores detail row + 1 in an unsigned char"
+#endif
+
+// ----------------------------------------------------------------------------
+// Class of a map character.
+// ----------------------------------------------------------------------------
+static int classifyTile(char tile) {
+    switch (tile) {
+        case '\0': return TILE_VOID;
+        case ' ':  return TILE_EMPTY;
+        case '-':  return TILE_HORIZONTAL;
+        case '|':  return TILE_VERTICAL;
+        case '/':  return TILE_SLASH;
+        case '\\': return TILE_BACKSLASH;
+        case '+':  return TILE_CROSSING;
+        case 'S':  return TILE_SPAWN;
+        case 'D':  return TILE_DEST;
+        case '=':  return TILE_SAFETY;
+        case SWITCH_NAMED_TILE: return TILE_SWITCH;
+    }
+    return (tile >= 'A' && tile <= 'Z') ? TILE_SWITCH : TILE_OTHER;
+}
+
+// ----------------------------------------------------------------------------
+// Gives a chunk a slot. Its cells start as ' ' inside the level and '\0'
+// outside, as an unallocated chunk reads.
+// ----------------------------------------------------------------------------
+static int allocateChunk(int chunkRow, int chunkCol) {
+    reserveChunkSlots(GridChunkCount + 1);
+    int chunk = GridChunkCount++;
+    GridChunkDir[chunkRow][chunkCol] = (short)chunk;
+    GridChunkRow[chunk] = chunkRow;
+    GridChunkCol[chunk] = chunkCol;
+    for (int cell = 0; cell < GRID_CHUNK * GRID_CHUNK; cell++) {
+        int r = (chunkRow << GRID_CHUNK_SHIFT) + (cell >> GRID_CHUNK_SHIFT);
+        int c = (chunkCol << GRID_CHUNK_SHIFT) + (cell & (GRID_CHUNK - 1));
+        int tileClass = (r < LevelNumRows && c < LevelNumCols) ? TILE_EMPTY : TILE_VOID;
+        unsigned char& packed = GridChunks[chunk][cell >> 1];
+        if (cell & 1) packed = (unsigned char)((packed & 0x0F) | (tileClass << 4));
+        else packed = (unsigned char)tileClass;
+    }
+    return chunk;
+}
+
+// ----------------------------------------------------------------------------
+// CHUNK SLOTS
+// ----------------------------------------------------------------------------
+void reserveChunkSlots(int count) {
+    if (count <= GridChunksAllocated) return;
+    unsigned char (*grown)[GRID_CHUNK_BYTES] = (unsigned char (*)[GRID_CHUNK_BYTES])
+        realloc(GridChunks, sizeof(GridChunks[0]) * count);
+    if (!grown) {
+        printf("Error: Not enough memory for the map\n");
+        exit(1);
+    }
+    GridChunks = grown;
+    GridChunksAllocated = count;
+}
+
+// ----------------------------------------------------------------------------
+// DETAIL ROWS
+// ----------------------------------------------------------------------------
+void reserveDetailRows(int count) {
+    if (count <= GridDetailRowsAllocated) return;
+    unsigned char (*grown)[MAX_COLS] = (unsigned char (*)[MAX_COLS])
+        realloc(GridDetail, sizeof(GridDetail[0]) * count);
+    if (!grown) {
+        printf("Error: Not enough memory for the map\n");
+        exit(1);
+    }
+    GridDetail = grown;
+    GridDetailRowsAllocated = count;
+}
+
+// ----------------------------------------------------------------------------
+// SWITCH ID BLOCKS
+// ----------------------------------------------------------------------------
+void reserveSwitchBlocks(int count) {
+    if (count <= GridSwitchBlocksAllocated) return;
+    short (*grown)[GRID_CHUNK * GRID_CHUNK] = (short (*)[GRID_CHUNK * GRID_CHUNK])
+        realloc(GridSwitchIds, sizeof(GridSwitchIds[0]) * count);
+    if (!grown) {
+        printf("Error: Not enough memory for switch IDs\n");
+        exit(1);
+    }
+    GridSwitchIds = grown;
+    GridSwitchBlocksAllocated = count;
+}
+
+// ----------------------------------------------------------------------------
+// Stores the switch of cell (r, c) in its chunk's block, giving the chunk a
+// block (all -1) first if it has none. The chunk must be allocated.
+// ----------------------------------------------------------------------------
+static void writeSwitchId(int r, int c, int idx) {
+    int chunk = GridChunkDir[r >> GRID_CHUNK_SHIFT][c >> GRID_CHUNK_SHIFT];
+    if (GridChunkSwitches[chunk] == 0) {
+        reserveSwitchBlocks(GridSwitchBlocksUsed + 1);
+        memset(GridSwitchIds[GridSwitchBlocksUsed], 0xFF, sizeof(GridSwitchIds[0]));
+        GridChunkSwitches[chunk] = (short)(++GridSwitchBlocksUsed);
+    }
+    int cell = ((r & (GRID_CHUNK - 1)) << GRID_CHUNK_SHIFT) | (c & (GRID_CHUNK - 1));
+    GridSwitchIds[GridChunkSwitches[chunk] - 1][cell] = (short)idx;
+}
+
+// ----------------------------------------------------------------------------
+// Switch of a switch cell (-1 for an '@' no switch was named for).
+// ----------------------------------------------------------------------------
+static int readSwitchId(int r, int c) {
+    int chunk = GridChunkDir[r >> GRID_CHUNK_SHIFT][c >> GRID_CHUNK_SHIFT];
+    int cell = ((r & (GRID_CHUNK - 1)) << GRID_CHUNK_SHIFT) | (c & (GRID_CHUNK - 1));
+    return GridSwitchIds[GridChunkSwitches[chunk] - 1][cell];
+}
+
+void setSwitchIndex(int r, int c, int idx) {
+    writeSwitchId(r, c, idx);
+}
+
+// ----------------------------------------------------------------------------
+// GET / SET TILE
+// ----------------------------------------------------------------------------
+char getTile(int r, int c) {
+    int tileClass = getTileClass(r, c);
+    if (tileClass < TILE_SWITCH) return TileClassChars[tileClass];
+    if (tileClass == TILE_SWITCH) {
+        int id = readSwitchId(r, c);
+        return (id >= 0 && id < SWITCH_LETTERS) ? (char)('A' + id) : SWITCH_NAMED_TILE;
+    }
+    return (char)GridDetail[GridDetailRow[r] - 1][c];
+}
+
+void setTile(int r, int c, char tile) {
+    int tileClass = classifyTile(tile);
+    if (tileClass == TILE_OTHER) {
+        // The row gets a detail row the first time it needs one
+        if (GridDetailRow[r] == 0) {
+            reserveDetailRows(GridDetailRowsUsed + 1);
+            memset(GridDetail[GridDetailRowsUsed], 0, MAX_COLS);
+            GridDetailRow[r] = (unsigned char)(++GridDetailRowsUsed);
+        }
+        GridDetail[GridDetailRow[r] - 1][c] = (unsigned char)tile;
+    }
+
+    int chunkRow = r >> GRID_CHUNK_SHIFT;
+    int chunkCol = c >> GRID_CHUNK_SHIFT;
+    int chunk = GridChunkDir[chunkRow][chunkCol];
+    if (chunk < 0) {
+        if (tileClass == TILE_EMPTY) return; // Already ' '
+        chunk = allocateChunk(chunkRow, chunkCol);
+    }
+
+    int cell = ((r & (GRID_CHUNK - 1)) << GRID_CHUNK_SHIFT) | (c & (GRID_CHUNK - 1));
+    int shift = (cell & 1) << 2;
+    unsigned char& packed = GridChunks[chunk][cell >> 1];
+    packed = (unsigned char)((packed & ~(0x0F << shift)) | (tileClass << shift));
+
+    // A letter is its own switch; '@' waits for the level to name it
+    if (tileClass == TILE_SWITCH) {
+        writeSwitchId(r, c, tile == SWITCH_NAMED_TILE ? -1 : tile - 'A');
+    } else if (GridChunkSwitches[chunk] > 0) {
+        GridSwitchIds[GridChunkSwitches[chunk] - 1][cell] = -1;
+    }
+}
+
+void getTileRow(int r, char* out) {
+    memset(out, ' ', LevelNumCols);
+    int chunkRow = r >> GRID_CHUNK_SHIFT;
+    for (int chunkCol = 0; chunkCol < GRID_CHUNK_COLS; chunkCol++) {
+        if (GridChunkDir[chunkRow][chunkCol] < 0) continue;
+        int first = chunkCol << GRID_CHUNK_SHIFT;
+        int end = first + GRID_CHUNK < LevelNumCols ? first + GRID_CHUNK : LevelNumCols;
+        for (int c = first; c < end; c++) out[c] = getTile(r, c);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// CHUNK BOUNDS
+// ----------------------------------------------------------------------------
+void getChunkBounds(int chunk, int& firstRow, int& firstCol, int& endRow, int& endCol) {
+    firstRow = GridChunkRow[chunk] << GRID_CHUNK_SHIFT;
+    firstCol = GridChunkCol[chunk] << GRID_CHUNK_SHIFT;
+    endRow = firstRow + GRID_CHUNK < LevelNumRows ? firstRow + GRID_CHUNK : LevelNumRows;
+    endCol = firstCol + GRID_CHUNK < LevelNumCols ? firstCol + GRID_CHUNK : LevelNumCols;
+}
+
 // ----------------------------------------------------------------------------
 // Check if a position is inside the grid.
 // ----------------------------------------------------------------------------
@@ -23,49 +224,34 @@ bool isTrackTile( int r, int c ) {
     // 1. Safety Check
     if (!isInBounds(r, c)) return false;
     
-    // 2. Get the character
-    char tile = TheGrid[r][c];
-
-    // 3. Logic Check
-    // Standard tracks
-    if (tile == '-' || tile == '|' || tile == '/' || tile == '\\' || tile == '+') return true;
-    
-    // Stations and Safety
-    if (tile == 'S' || tile == 'D' || tile == '=') return true;
-    
-    // Switches (A-Z)
-    if (tile >= 'A' && tile <= 'Z') return true;
-    
-    return false;
+    // 2. Track, stations, safety tiles and switches
+    return (TILE_TRACK_MASK >> getTileClass(r, c)) & 1;
 }
 
 // ----------------------------------------------------------------------------
 // Check if a tile is a switch.
 // ----------------------------------------------------------------------------
-// Returns true if the tile is 'A'..'Z'.
+// Returns true if the tile is 'A'..'Z' or a named switch cell.
 // ----------------------------------------------------------------------------
 bool isSwitchTile( int r , int c) {
     if (!isInBounds(r, c)) return false;
-    char tile = TheGrid[r][c];
-    if (tile == 'S' || tile == 'D') {
-    return false; 
-}
-    return (tile >= 'A' && tile <= 'Z');
+    return getTileClass(r, c) == TILE_SWITCH; // 'S' and 'D' are stations
 }
 
 // ----------------------------------------------------------------------------
 // Get switch index from character.
 // ----------------------------------------------------------------------------
-// Maps 'A'..'Z' to 0..25, else -1.
+// Maps 'A'..'Z' to 0..25 and named switch cells to their switch, else -1.
+// Like the letters they are, 'S' and 'D' tiles map to 18 and 3.
 // ----------------------------------------------------------------------------
 int getSwitchIndex(int r , int c) {
 
     if (!isInBounds(r, c)) 
         return -1;
-    char tile = TheGrid[r][c];
-    if (tile >= 'A' && tile <= 'Z') {
-        return tile - 'A';
-    }
+    int tileClass = getTileClass(r, c);
+    if (tileClass == TILE_SWITCH) return readSwitchId(r, c);
+    if (tileClass == TILE_SPAWN) return 'S' - 'A';
+    if (tileClass == TILE_DEST) return 'D' - 'A';
     return -1;
 
 }
@@ -77,7 +263,7 @@ int getSwitchIndex(int r , int c) {
 // ----------------------------------------------------------------------------
 bool isSpawnPoint( int r , int c) {
     if (!isInBounds(r, c)) return false;
-    return TheGrid[r][c] == 'S';
+    return getTileClass(r, c) == TILE_SPAWN;
 }
 
 
@@ -89,7 +275,7 @@ bool isSpawnPoint( int r , int c) {
 // ----------------------------------------------------------------------------
 bool isDestinationPoint( int r , int c) {
     if (!isInBounds(r, c)) return false;
-    return TheGrid[r][c] == 'D';
+    return getTileClass(r, c) == TILE_DEST;
 }
 
 // ----------------------------------------------------------------------------
@@ -100,17 +286,19 @@ bool isDestinationPoint( int r , int c) {
 bool toggleSafetyTile( int r , int c ) {
      if (!isInBounds(r, c)) return false;
     
-    char current = TheGrid[r][c];
+    int current = getTileClass(r, c);
 
     // 1. If it is currently a Safety Tile, change it into a normal tile otherwise when you toggle normal tile turns to safety.
-    if (current == '=') {
+    if (current == TILE_SAFETY) {
         
-        TheGrid[r][c] = '-';
+        setTile(r, c, '-');
+        invalidateRoutes();
         return true;
     }
     
-    if (current == '-' || current == '|') {
-        TheGrid[r][c] = '=';
+    if (current == TILE_HORIZONTAL || current == TILE_VERTICAL) {
+        setTile(r, c, '=');
+        invalidateRoutes();
         return true;
     }
     // safety tile is placed on only normal track
@@ -1,24 +1,93 @@
 #ifndef GRID_H
 #define GRID_H
 
+#include "simulation_state.h"
+
 // ============================================================================
 // GRID.H - Grid manipulation functions
 // ============================================================================
 // Functions for working with the 2D grid map.
 // ============================================================================
 
+// ----------------------------------------------------------------------------
+// TILE CLASSES (the 4-bit code stored per cell)
+// ----------------------------------------------------------------------------
+#define TILE_VOID       0   // '\0' (outside the loaded level)
+#define TILE_EMPTY      1   // ' '
+#define TILE_HORIZONTAL 2   // '-'
+#define TILE_VERTICAL   3   // '|'
+#define TILE_SLASH      4   // '/'
+#define TILE_BACKSLASH  5   // '\\'
+#define TILE_CROSSING   6   // '+'
+#define TILE_SPAWN      7   // 'S'
+#define TILE_DEST       8   // 'D'
+#define TILE_SAFETY     9   // '='
+#define TILE_SWITCH     10  // 'A'-'Z' except S and D, and '@' (switch in GridSwitchIds)
+#define TILE_OTHER      11  // Any other symbol (kept in the detail row)
+
+// Classes trains can move on, as a bit mask
+#define TILE_TRACK_MASK ((1 << TILE_HORIZONTAL) | (1 << TILE_VERTICAL) | (1 << TILE_SLASH) | \
+                         (1 << TILE_BACKSLASH) | (1 << TILE_CROSSING) | (1 << TILE_SPAWN) | \
+                         (1 << TILE_DEST) | (1 << TILE_SAFETY) | (1 << TILE_SWITCH))
+
+// ----------------------------------------------------------------------------
+// TILE ACCESS (0 <= r < MAX_ROWS, 0 <= c < MAX_COLS; no level bounds check,
+// callers test isInBounds() first)
+// ----------------------------------------------------------------------------
+// Class of a cell. Cells of unallocated chunks are ' ' inside the level.
+inline int getTileClass(int r, int c) {
+    int chunk = GridChunkDir[r >> GRID_CHUNK_SHIFT][c >> GRID_CHUNK_SHIFT];
+    if (chunk < 0) return (r < LevelNumRows && c < LevelNumCols) ? TILE_EMPTY : TILE_VOID;
+    int cell = ((r & (GRID_CHUNK - 1)) << GRID_CHUNK_SHIFT) | (c & (GRID_CHUNK - 1));
+    return (GridChunks[chunk][cell >> 1] >> ((cell & 1) << 2)) & 0x0F;
+}
+
+// Original map character of a cell, for I/O and drawing.
+char getTile(int r, int c);
+
+// Store a map character (classified and packed). Storing anything but ' '
+// allocates the cell's chunk. LevelNumRows/Cols must already be set.
+void setTile(int r, int c, char tile);
+
+// Characters of map row r (LevelNumCols of them, not terminated). Only the
+// allocated chunks of that row are read.
+void getTileRow(int r, char* out);
+
+// ----------------------------------------------------------------------------
+// CHUNK ITERATION
+// ----------------------------------------------------------------------------
+// Loops that only care about non-empty cells visit the allocated chunks
+// (GridChunkCount of them, in allocation order) instead of the whole map:
+//   for (int k = 0; k < GridChunkCount; k++) {
+//       int r0, c0, r1, c1;
+//       getChunkBounds(k, r0, c0, r1, c1);
+//       for (int r = r0; r < r1; r++) for (int c = c0; c < c1; c++) ...
+//   }
+// Bounds are clipped to the level (end row / col exclusive).
+void getChunkBounds(int chunk, int& firstRow, int& firstCol, int& endRow, int& endCol);
+
 // Check if a position is within grid bounds
 bool isInBounds( int r , int c);//gives if the row and column are inside map
 
 // Check if a tile is a track (can trains move on it?)
 bool isTrackTile( int r, int c );//tells us if the tile allows movement
 
-// Check if a tile is a switch (A-Z)
+// Check if a tile is a switch (A-Z or a named '@' cell)
 bool isSwitchTile( int r , int c);//tells if the current tile is a switch
 
-// Get the switch index (0-25) from a switch character (A-Z)
+// Get the switch index of a cell (0-25 for A-Z, 26+ for named switches, -1
+// for none)
 int getSwitchIndex( int r , int c);// gives 0 for A and 25 for Z
 
+// Make switch cell (r, c) part of switch idx (a named switch on its '@').
+void setSwitchIndex(int r, int c, int idx);
+
+// Make room for count chunk slots, detail rows and switch ID blocks (setTile
+// takes them as needed).
+void reserveChunkSlots(int count);
+void reserveDetailRows(int count);
+void reserveSwitchBlocks(int count);
+
 // Check if a position is a spawn point
 bool isSpawnPoint( int r , int c); //checks for S tile
 
@@ -0,0 +1,297 @@
+#include "heatmap.h"
+#include "simulation_state.h"
+#include "grid.h"
+#include <cstdio>
+#include <cstdlib>
+
+// ============================================================================
+// HEATMAP.CPP - Congestion heatmap
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// COUNTERS
+// ----------------------------------------------------------------------------
+// All-time totals and totals for the selected window, per layer and cell.
+static int HeatTotal[HEAT_LAYERS][MAX_ROWS][MAX_COLS];
+static int HeatWindowCount[HEAT_LAYERS][MAX_ROWS][MAX_COLS];
+static int HeatWindowTicks = 0; // 0 = all time
+
+// ----------------------------------------------------------------------------
+// EVENT RING
+// ----------------------------------------------------------------------------
+// Events of the last HEAT_MAX_WINDOW ticks in tick order. Each event enters
+// once and leaves the selected window once, so expiry is O(1) amortised.
+// A tick has at most one hold per train and one flip per entered switch,
+// and entering takes a train, so 2 events per train bound a tick.
+//
+// An event is one 32-bit record: the low 16 bits of its tick, then its layer,
+// row and column. Kept events are at most HEAT_MAX_WINDOW + 1 ticks old, so
+// their age is the wrapped difference of the low bits.
+#define HEAT_RING_SIZE (HEAT_MAX_WINDOW * 2 * MAX_TRAINS)
+#define HEAT_TICK_MASK 0xFFFF
+#define HEAT_CELL_BITS 7
+#define HEAT_CELL_MASK ((1 << HEAT_CELL_BITS) - 1)
+#if MAX_ROWS > (1 << HEAT_CELL_BITS) || MAX_COLS > (1 << HEAT_CELL_BITS) || HEAT_LAYERS > 4
+#error "Heat events have no room for the map size or layer count"
+#endif
+static unsigned int HeatEvent[HEAT_RING_SIZE];
+static int HeatRingHead = 0;      // Oldest kept event
+static int HeatRingCount = 0;     // Events kept
+static int HeatRingInWindow = 0;  // Newest events that are inside the selected window
+
+// Slot of the oldest event still inside the selected window
+static int heatWindowStart() {
+    return (HeatRingHead + HeatRingCount - HeatRingInWindow) % HEAT_RING_SIZE;
+}
+
+static unsigned int packHeatEvent(int layer, int r, int c) {
+    return ((unsigned int)(CurrentTick & HEAT_TICK_MASK) << 16) |
+           (unsigned int)((layer << (2 * HEAT_CELL_BITS)) | (r << HEAT_CELL_BITS) | c);
+}
+
+// Ticks since the event was recorded
+static int getHeatEventAge(unsigned int event) {
+    return (CurrentTick - (int)(event >> 16)) & HEAT_TICK_MASK;
+}
+
+// Window count of the event's layer and cell
+static int& getHeatEventCount(unsigned int event) {
+    return HeatWindowCount[(event >> (2 * HEAT_CELL_BITS)) & 3]
+                          [(event >> HEAT_CELL_BITS) & HEAT_CELL_MASK][event & HEAT_CELL_MASK];
+}
+
+// All-time count of the event's layer and cell
+static int& getHeatEventTotal(unsigned int event) {
+    return HeatTotal[(event >> (2 * HEAT_CELL_BITS)) & 3]
+                    [(event >> HEAT_CELL_BITS) & HEAT_CELL_MASK][event & HEAT_CELL_MASK];
+}
+
+// ----------------------------------------------------------------------------
+// EVENT HISTORY
+// ----------------------------------------------------------------------------
+// With the timeline on, every event is also kept here with its full tick, in
+// tick order, so a seek can rebuild the counters for the tick it lands on.
+// Events past the current tick stay after a seek back, because playing those
+// ticks again records the same events; only an input that starts a new
+// future drops them. Ticks from HeatHistoryEnd on are not in it yet.
+// ----------------------------------------------------------------------------
+static bool HeatHistoryOn = false;
+static bool HeatHistoryLost = false;  // Out of memory: seeks clear the heatmap
+static int* HeatHistoryTick = NULL;
+static unsigned int* HeatHistoryEvent = NULL;
+static int HeatHistoryCount = 0;
+static int HeatHistoryAllocated = 0;
+static int HeatHistoryEnd = 0;
+
+static void appendHeatHistory(unsigned int event) {
+    if (!HeatHistoryOn || HeatHistoryLost || CurrentTick < HeatHistoryEnd) return;
+    if (HeatHistoryCount == HeatHistoryAllocated) {
+        int count = HeatHistoryAllocated > 0 ? HeatHistoryAllocated * 2 : 4096;
+        int* ticks = (int*)realloc(HeatHistoryTick, sizeof(int) * count);
+        if (ticks) HeatHistoryTick = ticks;
+        unsigned int* events = (unsigned int*)realloc(HeatHistoryEvent, sizeof(unsigned int) * count);
+        if (events) HeatHistoryEvent = events;
+        if (!ticks || !events) {
+            HeatHistoryLost = true;
+            return;
+        }
+        HeatHistoryAllocated = count;
+    }
+    HeatHistoryTick[HeatHistoryCount] = CurrentTick;
+    HeatHistoryEvent[HeatHistoryCount] = event;
+    HeatHistoryCount++;
+}
+
+// ----------------------------------------------------------------------------
+// Adds an event to the ring, dropping the oldest one if the ring is full (it
+// is older than any window).
+// ----------------------------------------------------------------------------
+static void pushHeatEvent(unsigned int event) {
+    if (HeatRingCount == HEAT_RING_SIZE) {
+        if (HeatRingInWindow == HeatRingCount) {
+            getHeatEventCount(HeatEvent[HeatRingHead])--;
+            HeatRingInWindow--;
+        }
+        HeatRingHead = (HeatRingHead + 1) % HEAT_RING_SIZE;
+        HeatRingCount--;
+    }
+    HeatEvent[(HeatRingHead + HeatRingCount) % HEAT_RING_SIZE] = event;
+    HeatRingCount++;
+}
+
+// ----------------------------------------------------------------------------
+// Clears every counter and the event ring.
+// ----------------------------------------------------------------------------
+void initializeHeatmap() {
+    for (int l = 0; l < HEAT_LAYERS; l++) {
+        for (int r = 0; r < MAX_ROWS; r++) {
+            for (int c = 0; c < MAX_COLS; c++) {
+                HeatTotal[l][r][c] = 0;
+                HeatWindowCount[l][r][c] = 0;
+            }
+        }
+    }
+    HeatRingHead = 0;
+    HeatRingCount = 0;
+    HeatRingInWindow = 0;
+    HeatHistoryOn = false;
+    HeatHistoryLost = false;
+    HeatHistoryCount = 0;
+    HeatHistoryEnd = 0;
+}
+
+// ----------------------------------------------------------------------------
+// HEAT HISTORY FOR SEEKING
+// ----------------------------------------------------------------------------
+void startHeatHistory() {
+    HeatHistoryOn = true;
+    HeatHistoryLost = false;
+    HeatHistoryCount = 0;
+    HeatHistoryEnd = CurrentTick;
+}
+
+void truncateHeatHistory(int tick) {
+    while (HeatHistoryCount > 0 && HeatHistoryTick[HeatHistoryCount - 1] >= tick) HeatHistoryCount--;
+    if (HeatHistoryEnd > tick) HeatHistoryEnd = tick;
+}
+
+// ----------------------------------------------------------------------------
+// Recounts totals and the ring from the events before CurrentTick, then the
+// selected window from the ring. O(events recorded), only run on a seek.
+// ----------------------------------------------------------------------------
+bool rebuildHeatmap() {
+    for (int l = 0; l < HEAT_LAYERS; l++)
+        for (int r = 0; r < LevelNumRows; r++)
+            for (int c = 0; c < LevelNumCols; c++)
+                HeatTotal[l][r][c] = 0;
+    HeatRingHead = 0;
+    HeatRingCount = 0;
+    HeatRingInWindow = 0;
+
+    bool exact = HeatHistoryOn && !HeatHistoryLost;
+    for (int k = 0; exact && k < HeatHistoryCount && HeatHistoryTick[k] < CurrentTick; k++) {
+        unsigned int event = HeatHistoryEvent[k];
+        getHeatEventTotal(event)++;
+        if (CurrentTick - HeatHistoryTick[k] <= HEAT_MAX_WINDOW) pushHeatEvent(event);
+    }
+    setHeatWindow(HeatWindowTicks);
+    return exact;
+}
+
+// ----------------------------------------------------------------------------
+// Selects the window and rebuilds its counts from the event ring.
+// ----------------------------------------------------------------------------
+// Only runs when the user changes the window, never per tick.
+// ----------------------------------------------------------------------------
+void setHeatWindow(int ticks) {
+    if (ticks < 0) ticks = 0;
+    if (ticks > HEAT_MAX_WINDOW) ticks = HEAT_MAX_WINDOW;
+    HeatWindowTicks = ticks;
+
+    for (int l = 0; l < HEAT_LAYERS; l++)
+        for (int r = 0; r < LevelNumRows; r++)
+            for (int c = 0; c < LevelNumCols; c++)
+                HeatWindowCount[l][r][c] = 0;
+
+    // Walk the ring from newest to oldest until an event is outside the window
+    HeatRingInWindow = 0;
+    if (ticks == 0) return;
+    for (int k = HeatRingCount - 1; k >= 0; k--) {
+        unsigned int event = HeatEvent[(HeatRingHead + k) % HEAT_RING_SIZE];
+        if (getHeatEventAge(event) > ticks) break;
+        getHeatEventCount(event)++;
+        HeatRingInWindow++;
+    }
+}
+
+int getHeatWindow() {
+    return HeatWindowTicks;
+}
+
+// ----------------------------------------------------------------------------
+// Counts one event on a cell.
+// ----------------------------------------------------------------------------
+void recordHeat(int layer, int r, int c) {
+    if (layer < 0 || layer >= HEAT_LAYERS) return;
+    if (r < 0 || r >= LevelNumRows || c < 0 || c >= LevelNumCols) return;
+
+    HeatTotal[layer][r][c]++;
+    unsigned int event = packHeatEvent(layer, r, c);
+    pushHeatEvent(event);
+    appendHeatHistory(event);
+
+    if (HeatWindowTicks > 0) {
+        HeatWindowCount[layer][r][c]++;
+        HeatRingInWindow++;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Expires events that left the window or the ring.
+// ----------------------------------------------------------------------------
+// Called after CurrentTick advances. The window covers ticks
+// [CurrentTick - N, CurrentTick - 1].
+// ----------------------------------------------------------------------------
+void advanceHeatmapTick() {
+    if (CurrentTick > HeatHistoryEnd) HeatHistoryEnd = CurrentTick;
+    while (HeatRingInWindow > 0) {
+        unsigned int event = HeatEvent[heatWindowStart()];
+        if (getHeatEventAge(event) <= HeatWindowTicks) break;
+        getHeatEventCount(event)--;
+        HeatRingInWindow--;
+    }
+    while (HeatRingCount > HeatRingInWindow && getHeatEventAge(HeatEvent[HeatRingHead]) > HEAT_MAX_WINDOW) {
+        HeatRingHead = (HeatRingHead + 1) % HEAT_RING_SIZE;
+        HeatRingCount--;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Event count on a cell for the selected window.
+// ----------------------------------------------------------------------------
+int getHeatValue(int layer, int r, int c) {
+    if (layer < 0 || layer >= HEAT_LAYERS) return 0;
+    if (r < 0 || r >= LevelNumRows || c < 0 || c >= LevelNumCols) return 0;
+    if (HeatWindowTicks == 0) return HeatTotal[layer][r][c];
+    return HeatWindowCount[layer][r][c];
+}
+
+// ----------------------------------------------------------------------------
+// Largest value of a layer (used to normalise colours).
+// ----------------------------------------------------------------------------
+int getHeatMax(int layer) {
+    // Trains only ever stand on track, so only allocated chunks can be hot
+    int best = 0;
+    for (int k = 0; k < GridChunkCount; k++) {
+        int r0, c0, r1, c1;
+        getChunkBounds(k, r0, c0, r1, c1);
+        for (int r = r0; r < r1; r++) {
+            for (int c = c0; c < c1; c++) {
+                int v = getHeatValue(layer, r, c);
+                if (v > best) best = v;
+            }
+        }
+    }
+    return best;
+}
+
+// ----------------------------------------------------------------------------
+// Writes a layer as a binary PGM (P5), brightest = hottest cell.
+// ----------------------------------------------------------------------------
+bool exportHeatmapPGM(const char* filename, int layer) {
+    FILE* f = fopen(filename, "wb");
+    if (!f) return false;
+
+    int maxValue = getHeatMax(layer);
+    fprintf(f, "P5\n%d %d\n255\n", LevelNumCols, LevelNumRows);
+    for (int r = 0; r < LevelNumRows; r++) {
+        unsigned char row[MAX_COLS];
+        for (int c = 0; c < LevelNumCols; c++) {
+            int v = getHeatValue(layer, r, c);
+            row[c] = (unsigned char)(maxValue > 0 ? v * 255 / maxValue : 0);
+        }
+        fwrite(row, 1, LevelNumCols, f);
+    }
+    fclose(f);
+    return true;
+}
@@ -0,0 +1,71 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+// ============================================================================
+// HEATMAP.H - Congestion heatmap
+// ============================================================================
+// Per-cell counters of where trains are held back and where switches flip.
+// Every event costs O(1) to record and O(1) to expire, so the cost does not
+// grow with the length of the run.
+// ============================================================================
+
+// HEAT LAYERS
+#define HEAT_HOLD 0    // Train held in place by collision priority
+#define HEAT_FLIP 1    // Switch flipped on this cell
+#define HEAT_LAYERS 2
+
+// Longest selectable "last N ticks" window
+#define HEAT_MAX_WINDOW 1024
+
+// ----------------------------------------------------------------------------
+// SETUP
+// ----------------------------------------------------------------------------
+// Clear all counters (called when a simulation starts).
+void initializeHeatmap();
+
+// Select the window: 0 = all time, N = last N ticks (clamped to HEAT_MAX_WINDOW).
+void setHeatWindow(int ticks);
+
+// Currently selected window (0 = all time).
+int getHeatWindow();
+
+// ----------------------------------------------------------------------------
+// SEEKING
+// ----------------------------------------------------------------------------
+// Keep every event from now on so seeks can rebuild the counters (called by
+// the timeline at the start of a run).
+void startHeatHistory();
+
+// Forget kept events from tick on (an input changed the future).
+void truncateHeatHistory(int tick);
+
+// Rebuild all counters for CurrentTick after a checkpoint was restored.
+// Returns false if there is no history (out of memory, or never started):
+// the counters are then cleared and start from CurrentTick.
+bool rebuildHeatmap();
+
+// ----------------------------------------------------------------------------
+// RECORDING
+// ----------------------------------------------------------------------------
+// Count one event of the given layer on cell (r, c) at CurrentTick.
+void recordHeat(int layer, int r, int c);
+
+// Expire events that fell out of the window (called once per tick).
+void advanceHeatmapTick();
+
+// ----------------------------------------------------------------------------
+// QUERIES
+// ----------------------------------------------------------------------------
+// Event count on a cell for the selected window.
+int getHeatValue(int layer, int r, int c);
+
+// Largest cell value of a layer for the selected window.
+int getHeatMax(int layer);
+
+// ----------------------------------------------------------------------------
+// EXPORT
+// ----------------------------------------------------------------------------
+// Write a layer as a binary PGM image (one pixel per cell, scaled to 0-255).
+bool exportHeatmapPGM(const char* filename, int layer);
+
+#endif
@@ -1,6 +1,8 @@
 #include "io.h"
 #include "simulation_state.h"
 #include "grid.h"
+#include "log_writer.h"
+#include "thread_pool.h"
 #include <fstream>
 #include <cstring>
 #include <cstdio>
@@ -13,49 +15,88 @@ using namespace std;
 // ============================================================================
 
 // ----------------------------------------------------------------------------
-// LOAD LEVEL FILE
-// ----------------------------------------------------------------------------
-// Load a .lvl file into global state.
+// Reads the "AT col row" (1-based) that follows a switch name other than a
+// single letter, and gives that switch the next table entry. Returns its
+// index, or -1 with the rest of the line skipped if it cannot be added.
 // ----------------------------------------------------------------------------
-bool loadLevelFile(const char* filename) {
-    // 1. Reset Global State
-    initializeSimulationState();
-
-    // 2. Open File
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        printf("Error: Could not open file %s\n", filename);
-        return false;
+static int addNamedSwitch(FILE* file, const char* name) {
+    char at[8];
+    int col, row;
+    const char* problem = NULL;
+    if (fscanf(file, "%7s %d %d", at, &col, &row) != 3 || strcmp(at, "AT") != 0) problem = "expected AT col row";
+    else if (strlen(name) >= SWITCH_NAME_LENGTH) problem = "name too long";
+    else if (SwitchCount >= MAX_SWITCHES) problem = "too many switches";
+    for (int i = SWITCH_LETTERS; !problem && i < SwitchCount; i++) {
+        if (strcmp(SwitchName[i], name) == 0) problem = "name used twice";
+    }
+    if (problem) {
+        printf("Warning: switch %s skipped (%s)\n", name, problem);
+        int c;
+        while ((c = fgetc(file)) != '\n' && c != EOF);
+        return -1;
     }
+    int idx = SwitchCount++;
+    strcpy(SwitchName[idx], name);
+    SwitchRow[idx] = row - 1;
+    SwitchCol[idx] = col - 1;
+    return idx;
+}
 
+// ----------------------------------------------------------------------------
+// LOAD LEVEL STREAM
+// ----------------------------------------------------------------------------
+// Parse level text from an open stream into the (already reset) global state.
+// ----------------------------------------------------------------------------
+static bool loadLevelStream(FILE* file) {
     char key[128];
     int mode = 0; // 0=Header, 1=Switches, 2=Trains
 
     // 3. Read Word by Word
-    while (fscanf(file, "%s", key) == 1) {
+    while (fscanf(file, "%127s", key) == 1) {
         
         // KEYWORD DETECTION 
         
         if (strcmp(key, "NAME:") == 0) {
-            char c;
-            while ((c = fgetc(file)) != '\n' && c != EOF);            
+            // The name is either on the same line or on the next one
+            int c;
+            int len = 0;
+            while ((c = fgetc(file)) != '\n' && c != EOF) {
+                if (len < MAX_NAME_LENGTH - 1 && (len > 0 || c != ' ') && c != '\r') LevelName[len++] = (char)c;
+            }
+            if (len == 0 && c != EOF) {
+                while ((c = fgetc(file)) != '\n' && c != EOF) {
+                    if (len < MAX_NAME_LENGTH - 1 && c != '\r') LevelName[len++] = (char)c;
+                }
+            }
+            LevelName[len] = '\0';
             continue;
         }
+        // The map is stored for at most MAX_ROWS x MAX_COLS cells
         if (strcmp(key, "ROWS:") == 0) { 
-            fscanf(file, "%d", &LevelNumRows); 
+            int rows;
+            if (fscanf(file, "%d", &rows) != 1 || rows <= 0 || rows > MAX_ROWS) {
+                printf("Error: ROWS must be 1 to %d\n", MAX_ROWS);
+                return false;
+            }
+            LevelNumRows = rows;
             continue; 
         }
         if (strcmp(key, "COLS:") == 0) { 
-            fscanf(file, "%d", &LevelNumCols); 
+            int cols;
+            if (fscanf(file, "%d", &cols) != 1 || cols <= 0 || cols > MAX_COLS) {
+                printf("Error: COLS must be 1 to %d\n", MAX_COLS);
+                return false;
+            }
+            LevelNumCols = cols;
             continue; 
         }
         if (strcmp(key, "SEED:") == 0) {
             fscanf(file, "%d", &GameSeed);
-            srand(GameSeed); continue; 
+            continue; 
         }
         if (strcmp(key, "WEATHER:") == 0) {
             char w[32]; 
-            fscanf(file, "%s", w);
+            fscanf(file, "%31s", w);
             if (strcmp(w, "RAIN") == 0) 
                 GameWeather = WEATHER_RAIN;
             else if(strcmp(w, "FOG") == 0)
@@ -91,18 +132,11 @@ bool loadLevelFile(const char* filename) {
                     break;
                 }
 
-                for (int col = 0; col < LevelNumCols; col++) {
-                    if (col < idx) {
-                        char val = buffer[col];
-                        // Filter visible characters only
-                        if (val >= 33 && val <= 126) {
-                            TheGrid[r][col] = val;
-                        } else {
-                            TheGrid[r][col] = ' ';
-                        }
-                    } else {
-                        TheGrid[r][col] = ' ';
-                    }
+                // Filter visible characters only (the rest stays ' ', which
+                // allocates nothing)
+                for (int col = 0; col < LevelNumCols && col < idx; col++) {
+                    char val = buffer[col];
+                    if (val >= 33 && val <= 126) setTile(r, col, val);
                 }
             }
             continue;
@@ -121,33 +155,36 @@ bool loadLevelFile(const char* filename) {
 
         // Parse Switch
         if (mode == 1) {
-            // key is the switch letter
+            // key is the switch letter, or the name of a named switch
+            int idx = -1;
             if( key[0] >= 'A' && key[0] <= 'Z' && key[1] == '\0') {
                 char letter = key[0];
-                int idx = letter - 'A';
+                idx = letter - 'A';
+            } else {
+                idx = addNamedSwitch(file, key);
+            }
 
-                if (idx >= 0 && idx < MAX_SWITCHES) {
-                    SwitchExists[idx] = true;
+            if (idx >= 0 && idx < MAX_SWITCHES) {
+                SwitchExists[idx] = true;
 
-                    char modeStr[32];
-                    fscanf(file, "%s", modeStr);
-                    
-                    if (strcmp(modeStr, "GLOBAL") == 0) 
-                        SwitchLogicMode[idx] = MODE_GLOBAL;
-                    else 
-                        SwitchLogicMode[idx] = MODE_PER_DIR;
+                char modeStr[32];
+                fscanf(file, "%31s", modeStr);
+                
+                if (strcmp(modeStr, "GLOBAL") == 0) 
+                    SwitchLogicMode[idx] = MODE_GLOBAL;
+                else 
+                    SwitchLogicMode[idx] = MODE_PER_DIR;
 
-                    fscanf(file, "%d", &SwitchCurrentState[idx]);
+                fscanf(file, "%d", &SwitchCurrentState[idx]);
 
-                    // Reading 4 K-values
-                   for(int k=0; k<4; k++) {
-                    fscanf(file, "%d", &SwitchFlipThresholds[idx][k]);
-                }
+                // Reading 4 K-values
+               for(int k=0; k<4; k++) {
+                fscanf(file, "%d", &SwitchFlipThresholds[idx][k]);
+            }
 
-                // Skip the labels at the end of the line (e.g. "LEFT RIGHT")
-                char c;
-                while ((c = fgetc(file)) != '\n' && c != EOF); 
-                }
+            // Skip the labels at the end of the line (e.g. "LEFT RIGHT")
+            char c;
+            while ((c = fgetc(file)) != '\n' && c != EOF); 
             }
         }
         else if (mode == 2) {
@@ -167,6 +204,15 @@ bool loadLevelFile(const char* filename) {
                     TrainStartCol[TotalScheduledTrains] = rawCol - 1;
                     TrainStartRow[TotalScheduledTrains] = rawRow - 1;
 
+                    // Optional destination "destCol destRow" at the end of the line
+                    char rest[128];
+                    int destCol, destRow;
+                    if (fgets(rest, sizeof(rest), file) &&
+                        sscanf(rest, "%d %d", &destCol, &destRow) == 2) {
+                        TrainDestCol[TotalScheduledTrains] = destCol - 1;
+                        TrainDestRow[TotalScheduledTrains] = destRow - 1;
+                    }
+
                     TrainIsActive[TotalScheduledTrains] = false;
                     TotalScheduledTrains++;
                 }
@@ -174,80 +220,332 @@ bool loadLevelFile(const char* filename) {
         }
     }
 
-    fclose(file);
+    // Destinations must be 'D' tiles, otherwise the train takes any 'D'
+    for (int i = 0; i < TotalScheduledTrains; i++) {
+        if (TrainDestRow[i] < 0 && TrainDestCol[i] < 0) continue;
+        if (!isDestinationPoint(TrainDestRow[i], TrainDestCol[i])) {
+            printf("Warning: train %d destination (%d, %d) is not a D tile, using any D\n",
+                   i, TrainDestCol[i] + 1, TrainDestRow[i] + 1);
+            TrainDestRow[i] = -1;
+            TrainDestCol[i] = -1;
+        }
+    }
+
+    // Named switches take over the '@' cell their AT names
+    for (int idx = SWITCH_LETTERS; idx < SwitchCount; idx++) {
+        int r = SwitchRow[idx];
+        int c = SwitchCol[idx];
+        if (isInBounds(r, c) && getTileClass(r, c) == TILE_SWITCH && getSwitchIndex(r, c) < 0) {
+            setSwitchIndex(r, c, idx);
+        } else {
+            printf("Warning: switch %s is not on a free '%c' cell at (%d, %d), ignored\n",
+                   SwitchName[idx], SWITCH_NAMED_TILE, c + 1, r + 1);
+            SwitchExists[idx] = false;
+            SwitchRow[idx] = -1;
+            SwitchCol[idx] = -1;
+        }
+    }
+
+    // Remember where each switch sits on the map (its first cell in reading
+    // order, whichever chunk it is found in first)
+    for (int k = 0; k < GridChunkCount; k++) {
+        int r0, c0, r1, c1;
+        getChunkBounds(k, r0, c0, r1, c1);
+        for (int r = r0; r < r1; r++) {
+            for (int c = c0; c < c1; c++) {
+                int idx = getSwitchIndex(r, c);
+                if (idx < 0) continue;
+                if (SwitchRow[idx] < 0 || r < SwitchRow[idx] ||
+                    (r == SwitchRow[idx] && c < SwitchCol[idx])) {
+                    SwitchRow[idx] = r;
+                    SwitchCol[idx] = c;
+                }
+            }
+        }
+    }
     return true;
 }
+
 // ----------------------------------------------------------------------------
-// INITIALIZE LOG FILES
+// LOAD LEVEL FILE
 // ----------------------------------------------------------------------------
-// Create/clear CSV logs with headers.
+// Load a .lvl file into global state.
 // ----------------------------------------------------------------------------
-void initializeLogFiles() {
-       // Open files in "w" (write) mode to clear them
-    FILE* fTrace = fopen("out/trace.csv", "w");
-    if (fTrace) {
-        fprintf(fTrace, "Tick,TrainID,X,Y,Direction,State\n");
-        fclose(fTrace);
+bool loadLevelFile(const char* filename) {
+    // 1. Reset Global State
+    initializeSimulationState();
+
+    // 2. Open File
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        printf("Error: Could not open file %s\n", filename);
+        return false;
+    }
+
+    // 3. Parse
+    bool ok = loadLevelStream(file);
+    fclose(file);
+    return ok;
+}
+
+// ----------------------------------------------------------------------------
+// LOAD LEVEL BUFFER
+// ----------------------------------------------------------------------------
+// Same as loadLevelFile for level text already in memory (no temp file).
+// ----------------------------------------------------------------------------
+bool loadLevelBuffer(const char* text, int length) {
+    initializeSimulationState();
+    if (!text || length <= 0) {
+        printf("Error: Empty level buffer\n");
+        return false;
+    }
+
+    FILE* file = fmemopen(const_cast<char*>(text), (size_t)length, "r");
+    if (!file) {
+        printf("Error: Could not read level buffer\n");
+        return false;
+    }
+    bool ok = loadLevelStream(file);
+    fclose(file);
+    return ok;
+}
+// ----------------------------------------------------------------------------
+// SAVE LEVEL FILE
+// ----------------------------------------------------------------------------
+// Write the loaded level back out in .lvl format, using the current switch
+// settings. Trains are written with their scheduled spawn data.
+// ----------------------------------------------------------------------------
+bool saveLevelFile(const char* filename) {
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        printf("Error: Could not write file %s\n", filename);
+        return false;
+    }
+
+    const char* weatherName = "NORMAL";
+    if (GameWeather == WEATHER_RAIN) weatherName = "RAIN";
+    else if (GameWeather == WEATHER_FOG) weatherName = "FOG";
+
+    fprintf(file, "NAME:\n%s\n\n", LevelName);
+    fprintf(file, "ROWS:\n%d\n\n", LevelNumRows);
+    fprintf(file, "COLS:\n%d\n\n", LevelNumCols);
+    fprintf(file, "SEED:\n%d\n\n", GameSeed);
+    fprintf(file, "WEATHER:\n%s\n\n", weatherName);
+
+    fprintf(file, "MAP:\n");
+    for (int r = 0; r < LevelNumRows; r++) {
+        char row[MAX_COLS + 1];
+        getTileRow(r, row);
+        for (int c = 0; c < LevelNumCols; c++) {
+            if (row[c] < 33 || row[c] > 126) row[c] = ' ';
+        }
+        row[LevelNumCols] = '\n';
+        fwrite(row, 1, LevelNumCols + 1, file);
     }
 
-    FILE* fSwitches = fopen("out/switches.csv", "w");
-    if (fSwitches) {
-        fprintf(fSwitches, "Tick,Switch,Mode,State\n");
-        fclose(fSwitches);
+    fprintf(file, "\nSWITCHES:\n");
+    for (int i = 0; i < SwitchCount; i++) {
+        if (!SwitchExists[i]) continue;
+        fprintf(file, "%s ", SwitchName[i]);
+        if (i >= SWITCH_LETTERS) fprintf(file, "AT %d %d ", SwitchCol[i] + 1, SwitchRow[i] + 1);
+        fprintf(file, "%s %d %d %d %d %d STRAIGHT TURN\n",
+                SwitchLogicMode[i] == MODE_GLOBAL ? "GLOBAL" : "PER_DIR",
+                SwitchCurrentState[i],
+                SwitchFlipThresholds[i][0], SwitchFlipThresholds[i][1],
+                SwitchFlipThresholds[i][2], SwitchFlipThresholds[i][3]);
     }
 
-    FILE* fSignals = fopen("out/signals.csv", "w");
-    if (fSignals) {
-        fprintf(fSignals, "Tick,Switch,Signal\n");
-        fclose(fSignals);
+    // File coordinates are 1-based
+    fprintf(file, "\nTRAINS:\n");
+    for (int i = 0; i < TotalScheduledTrains; i++) {
+        fprintf(file, "%d %d %d %d %d", TrainSpawnTicks[i],
+                TrainStartCol[i] + 1, TrainStartRow[i] + 1,
+                TrainStartDir[i], TrainColorCode[i]);
+        if (TrainDestRow[i] >= 0) {
+            fprintf(file, " %d %d", TrainDestCol[i] + 1, TrainDestRow[i] + 1);
+        }
+        fprintf(file, "\n");
     }
+
+    return fclose(file) == 0;
+}
+
+// ----------------------------------------------------------------------------
+// LOG LEVELS
+// ----------------------------------------------------------------------------
+// ConfiguredLevel is what the user asked for; LogLevel is what runs. They
+// differ only while logging is switched off (batch tools, seeking), when no
+// log file is created or appended to. hash.csv is off unless asked for.
+// ----------------------------------------------------------------------------
+int LogLevel[LOG_STREAMS] = { LOG_FULL, LOG_FULL, LOG_FULL, LOG_OFF };
+int LogSampleEvery[LOG_STREAMS] = { 1, 1, 1, 1 };
+static int ConfiguredLevel[LOG_STREAMS] = { LOG_FULL, LOG_FULL, LOG_FULL, LOG_OFF };
+static bool LoggingEnabled = true;
+
+static const char* LogStreamNames[LOG_STREAMS] = { "trace", "switches", "signals", "hash" };
+
+void setLogLevel(int stream, int level, int sampleEvery) {
+    if (stream < 0 || stream >= LOG_STREAMS) return;
+    // Every hash row is a change, so "events" is the same as "full" there
+    if (stream == LOG_STREAM_HASH && level == LOG_EVENTS) level = LOG_FULL;
+    ConfiguredLevel[stream] = level;
+    LogSampleEvery[stream] = sampleEvery > 0 ? sampleEvery : 1;
+    if (LoggingEnabled) LogLevel[stream] = level;
+}
+
+void setLoggingEnabled(bool enabled) {
+    LoggingEnabled = enabled;
+    for (int s = 0; s < LOG_STREAMS; s++) {
+        LogLevel[s] = enabled ? ConfiguredLevel[s] : LOG_OFF;
+    }
+}
+
+bool isLoggingEnabled() {
+    return LoggingEnabled;
+}
+
+void setHashLogEnabled(bool enabled) {
+    setLogLevel(LOG_STREAM_HASH, enabled ? LOG_FULL : LOG_OFF, 1);
+}
+
+// ----------------------------------------------------------------------------
+// PARSE LOG LEVELS
+// ----------------------------------------------------------------------------
+// Items are separated by commas: <stream>=off|events|full|sampled:<N>.
+// ----------------------------------------------------------------------------
+bool parseLogLevels(const char* spec) {
+    if (strcmp(spec, "off") == 0) spec = "all=off";
+
+    char item[64];
+    while (*spec) {
+        int len = 0;
+        while (spec[len] && spec[len] != ',') len++;
+        if (len >= (int)sizeof(item)) len = sizeof(item) - 1;
+        strncpy(item, spec, len);
+        item[len] = '\0';
+        spec += len;
+        if (*spec == ',') spec++;
+
+        char* value = strchr(item, '=');
+        if (!value) {
+            printf("Error: log setting '%s' needs <stream>=<level>\n", item);
+            return false;
+        }
+        *value++ = '\0';
+
+        int level = -1;
+        int every = 1;
+        if (strcmp(value, "off") == 0) level = LOG_OFF;
+        else if (strcmp(value, "events") == 0) level = LOG_EVENTS;
+        else if (strcmp(value, "full") == 0) level = LOG_FULL;
+        else if (sscanf(value, "sampled:%d", &every) == 1 && every > 0) level = LOG_SAMPLED;
+        if (level < 0) {
+            printf("Error: unknown log level '%s' (off, events, full, sampled:N)\n", value);
+            return false;
+        }
+
+        bool found = false;
+        for (int s = 0; s < LOG_STREAMS; s++) {
+            if (strcmp(item, "all") == 0 || strcmp(item, LogStreamNames[s]) == 0) {
+                setLogLevel(s, level, every);
+                found = true;
+            }
+        }
+        if (!found) {
+            printf("Error: unknown log stream '%s' (trace, switches, signals, hash, all)\n", item);
+            return false;
+        }
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// INITIALIZE LOG FILES
+// ----------------------------------------------------------------------------
+// Create/clear CSV logs with headers. They stay open; rows are written by the
+// background writer (log_writer.cpp).
+// ----------------------------------------------------------------------------
+void initializeLogFiles() {
+    bool open[LOG_STREAMS];
+    bool any = false;
+    for (int s = 0; s < LOG_STREAMS; s++) {
+        open[s] = LogLevel[s] != LOG_OFF;
+        any = any || open[s];
+    }
+    if (any) openLogStreams(open);
 }
 
 // ----------------------------------------------------------------------------
 // LOG TRAIN TRACE
 // ----------------------------------------------------------------------------
-// Append tick, train id, position, direction, state to trace.csv.
+// Queue tick, train id, position, direction, state for trace.csv.
 // ----------------------------------------------------------------------------
 void logTrainTrace(int tick, int trainId, int x, int y, int dir, const char *state) {
-    FILE* f = fopen("out/trace.csv", "a"); // "a" = append
-    if (f) {
-        // Direction names for readability (Optional)
-        const char* dirName = "UP";
-        if (dir == 1) dirName = "RIGHT";
-        else if (dir == 2) dirName = "DOWN";
-        else if (dir == 3) dirName = "LEFT";
+    if (LogLevel[LOG_STREAM_TRACE] == LOG_OFF) return;
+    pushLogRecord(LOG_STREAM_TRACE, tick, trainId, x, y, dir, state, 0);
+}
 
-        fprintf(f, "%d,%d,%d,%d,%s,%s\n", tick, trainId, x, y, dirName, state);
-        fclose(f);
+// ----------------------------------------------------------------------------
+// LOG TRAIN TRACE ROWS
+// ----------------------------------------------------------------------------
+// Rows are written straight into reserved log ring slots, trains split over
+// the pool; a batch is at most half the ring.
+// ----------------------------------------------------------------------------
+static const int* TraceRowTrains = NULL;
+static int TraceRowTick = 0;
+static int TraceRowFirst = 0;
+
+static void fillTraceRows(int begin, int end, int worker) {
+    (void)worker;
+    for (int k = begin; k < end; k++) {
+        int i = TraceRowTrains[TraceRowFirst + k];
+        setLogRecord(k, LOG_STREAM_TRACE, TraceRowTick, i, TrainCurrentCol[i], TrainCurrentRow[i],
+                     TrainCurrentDir[i], "RUNNING", 0);
+    }
+}
+
+void logTrainTraceRows(int tick, const int* trains, int count) {
+    if (LogLevel[LOG_STREAM_TRACE] == LOG_OFF) return;
+    TraceRowTrains = trains;
+    TraceRowTick = tick;
+    for (int first = 0; first < count; first += LOG_RING_SIZE / 2) {
+        int rows = (count - first < LOG_RING_SIZE / 2) ? count - first : LOG_RING_SIZE / 2;
+        TraceRowFirst = first;
+        if (!reserveLogRecords(rows)) continue;
+        parallelFor(rows, getPoolGrain(POOL_TICK_GRAIN), fillTraceRows);
+        publishLogRecords();
     }
 }
 
 // ----------------------------------------------------------------------------
 // LOG SWITCH STATE
 // ----------------------------------------------------------------------------
-// Append tick, switch id/mode/state to switches.csv.
+// Queue tick, switch id/mode/state for switches.csv (the writer prints the
+// switch's name).
 // ----------------------------------------------------------------------------
-void logSwitchState(int tick, char switchId, const char *mode, int state) {
-    FILE* f = fopen("out/switches.csv", "a");
-    if (f) {
-        // State: 0 = Straight (usually), 1 = Turn
-        const char* stateStr = (state == 0) ? "Straight" : "Turn";
-        fprintf(f, "%d,%c,%s,%s\n", tick, switchId, mode, stateStr);
-        fclose(f);
-    }
+void logSwitchState(int tick, int switchId, const char *mode, int state) {
+    if (LogLevel[LOG_STREAM_SWITCH] == LOG_OFF) return;
+    pushLogRecord(LOG_STREAM_SWITCH, tick, switchId, state, 0, 0, mode, 0);
 }
 // ----------------------------------------------------------------------------
 // LOG SIGNAL STATE
 // ----------------------------------------------------------------------------
-// Append tick, switch id, signal color to signals.csv.
+// Queue tick, switch id, signal color for signals.csv.
 // ----------------------------------------------------------------------------
-void logSignalState(int tick, char switchId, const char *color) {
-    FILE* f = fopen("out/signals.csv", "a");
-    if (f) {
-        fprintf(f, "%d,%c,%s\n", tick, switchId, color);
-        fclose(f);
-    }
+void logSignalState(int tick, int switchId, const char *color) {
+    if (LogLevel[LOG_STREAM_SIGNAL] == LOG_OFF) return;
+    pushLogRecord(LOG_STREAM_SIGNAL, tick, switchId, 0, 0, 0, color, 0);
 }
+// ----------------------------------------------------------------------------
+// LOG STATE HASH
+// ----------------------------------------------------------------------------
+// Queue tick and end-of-tick state hash for hash.csv (if enabled).
+// ----------------------------------------------------------------------------
+void logStateHash(int tick, unsigned long long hash) {
+    if (LogLevel[LOG_STREAM_HASH] == LOG_OFF) return;
+    pushLogRecord(LOG_STREAM_HASH, tick, 0, 0, 0, 0, NULL, hash);
+}
+
 // ----------------------------------------------------------------------------
 // WRITE FINAL METRICS
 // ----------------------------------------------------------------------------
@@ -260,29 +558,9 @@ void writeMetrics() {
         fprintf(f, "==================\n");
         fprintf(f, "Total Trains Scheduled: %d\n", TotalScheduledTrains);
         // You can add more global counters here later (like TotalCrashes)
+        long long dropped = getDroppedLogRecords();
+        if (dropped > 0) fprintf(f, "Log Records Dropped: %lld\n", dropped);
         fprintf(f, "Simulation Ended.\n");
         fclose(f);
     }
 }
-
-void printGrid() {
-   printf("Tick: %d\n", CurrentTick);
-   for(int r = 0; r < LevelNumRows; r++) {
-     for(int c = 0; c < LevelNumCols; c++) {
-
-        bool trainHere = false;
-        for(int i = 0; i < TotalScheduledTrains; i++) {
-            if(TrainState[i] == 1 && TrainCurrentRow[i] == r && TrainCurrentCol[i] == c) {
-                printf("%d", i % 10);
-                trainHere = true;
-                break;
-            }
-        }
-        if(!trainHere) {
-            printf("%c", TheGrid[r][c]);
-        }
-     }
-      printf("\n");
-    }
-   printf("--------------------------\n");
-}
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef IO_H
 #define IO_H
 
+#include "log_writer.h"
+
 // ============================================================================
 // IO.H - Level I/O and logging
 // ============================================================================
@@ -11,27 +13,80 @@
 // Load a .lvl file.
 bool loadLevelFile(const char *filename);
 
+// Load level text held in memory (length bytes, same format as a .lvl file).
+bool loadLevelBuffer(const char *text, int length);
+
+// Write the current level (map, switch settings, trains) to a .lvl file.
+bool saveLevelFile(const char *filename);
+
 // ----------------------------------------------------------------------------
 // LOGGING
 // ----------------------------------------------------------------------------
+// LOG LEVELS (per LOG_STREAM_*, see log_writer.h)
+#define LOG_OFF     0   // No file, no rows
+#define LOG_EVENTS  1   // Only rows where something changed
+#define LOG_SAMPLED 2   // Every row, but only on every Nth tick
+#define LOG_FULL    3   // Every row of every tick
+
+// Level each stream is running at (LOG_OFF for all while logging is turned
+// off). Callers test it before building rows, so an off stream costs one
+// load per tick.
+extern int LogLevel[LOG_STREAMS];
+extern int LogSampleEvery[LOG_STREAMS];
+
+// True if stream writes its per-tick rows at tick (FULL, or a SAMPLED tick).
+inline bool isLogTick(int stream, int tick) {
+    return LogLevel[stream] == LOG_FULL ||
+           (LogLevel[stream] == LOG_SAMPLED && tick % LogSampleEvery[stream] == 0);
+}
+
+// For streams whose rows are events (switch flips): true if they are written
+// at tick (FULL, EVENTS, or a SAMPLED tick).
+inline bool isLogEventTick(int stream, int tick) {
+    return LogLevel[stream] == LOG_EVENTS || isLogTick(stream, tick);
+}
+
+// Set the level of one stream (sampleEvery is used by LOG_SAMPLED).
+void setLogLevel(int stream, int level, int sampleEvery);
+
+// Parse a --log spec such as "trace=events,signals=off,hash=sampled:100"
+// ("all=" sets every stream, "off" alone means all=off). Returns false and
+// prints the problem if the spec is invalid.
+bool parseLogLevels(const char *spec);
+
+// Turn all log file output off, or back to the configured levels.
+void setLoggingEnabled(bool enabled);
+
+// True unless logging was turned off.
+bool isLoggingEnabled();
+
+// Write the per-tick state hash to hash.csv (same as hash=full; off by default).
+void setHashLogEnabled(bool enabled);
+
 // Create/clear log files.
 void initializeLogFiles();
 
+// The log functions only queue a record; a background thread writes it.
+// String arguments must be literals (see log_writer.h).
+
 // Append train movement to trace.csv.
 void logTrainTrace(int tick, int trainId, int x, int y, int dir, const char *state);
 
+// Append a RUNNING row for each listed train (count of them, in list order).
+// On big fleets the rows are filled in by the thread pool.
+void logTrainTraceRows(int tick, const int* trains, int count);
+
 // Append switch state to switches.csv.
-void logSwitchState(int tick, char switchId, const char *mode, int state);
+void logSwitchState(int tick, int switchId, const char *mode, int state);
 
 // Append signal state to signals.csv.
-void logSignalState(int tick, char switchId, const char *color);
+void logSignalState(int tick, int switchId, const char *color);
+
+// Append the end-of-tick state hash to hash.csv.
+void logStateHash(int tick, unsigned long long hash);
 
 // Write final metrics to metrics.txt.
 void writeMetrics();
 
-// printGrid function to print character arrays 
-void printGrid();
-
-
 
 #endif
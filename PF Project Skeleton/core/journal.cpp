@@ -0,0 +1,260 @@
+#include "journal.h"
+#include "simulation_state.h"
+#include "simulation.h"
+#include "grid.h"
+#include "switches.h"
+#include "trains.h"
+#include "cycle.h"
+#include "timeline.h"
+#include <cstdio>
+#include <cstring>
+
+// ============================================================================
+// JOURNAL.CPP - Operator input journal and replay
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// RECORDING STATE
+// ----------------------------------------------------------------------------
+static FILE* JournalFile = NULL;
+static char JournalPath[512];
+static char JournalLevel[512];
+
+// ----------------------------------------------------------------------------
+// REPLAY STATE
+// ----------------------------------------------------------------------------
+// Loaded (or, while recording, performed) inputs in file order (ticks never
+// decrease).
+static int JournalTick[MAX_JOURNAL_EVENTS];
+static int JournalType[MAX_JOURNAL_EVENTS];
+static int JournalArgs[MAX_JOURNAL_EVENTS][JOURNAL_MAX_ARGS];
+static int JournalCount = 0;
+static int JournalNext = 0;      // First input not yet applied
+static int JournalEndTick = -1;
+static bool JournalFullWarned = false;
+
+// Record letter and argument count of each input type
+static const char JournalLetters[4] = { 'T', 'S', 'H', 'R' };
+static const int JournalArgCounts[4] = { 2, 2, 5, 4 };
+
+// ----------------------------------------------------------------------------
+// Performs one input without journaling it.
+// ----------------------------------------------------------------------------
+static bool performInput(int type, const int* args) {
+    bool changed = false;
+    if (type == JOURNAL_SAFETY_TILE) changed = toggleSafetyTile(args[0], args[1]);
+    else if (type == JOURNAL_SWITCH) changed = toggleSwitchState(args[0], args[1]);
+    else if (type == JOURNAL_HALT_RECT) changed = addHaltZoneRect(args[0], args[1], args[2], args[3], args[4]) >= 0;
+    else if (type == JOURNAL_HALT_RADIUS) changed = addHaltZoneRadius(args[0], args[1], args[2], args[3]) >= 0;
+
+    // The operator may have broken (or created) a loop
+    if (changed) resetCycleDetection();
+    return changed;
+}
+
+// ----------------------------------------------------------------------------
+// START JOURNAL
+// ----------------------------------------------------------------------------
+bool startJournal(const char* filename, const char* levelPath) {
+    closeJournal();
+    JournalFile = fopen(filename, "w");
+    if (!JournalFile) {
+        printf("Error: Could not write journal %s\n", filename);
+        return false;
+    }
+    snprintf(JournalPath, sizeof(JournalPath), "%s", filename);
+    snprintf(JournalLevel, sizeof(JournalLevel), "%s", levelPath);
+    JournalCount = 0;
+    JournalNext = 0;
+    JournalEndTick = -1;
+    fprintf(JournalFile, "LEVEL %s\n", levelPath);
+    fflush(JournalFile);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Writes one input record.
+// ----------------------------------------------------------------------------
+static void writeRecord(int tick, int type, const int* args) {
+    fprintf(JournalFile, "%d %c", tick, JournalLetters[type]);
+    for (int a = 0; a < JournalArgCounts[type]; a++) fprintf(JournalFile, " %d", args[a]);
+    fprintf(JournalFile, "\n");
+}
+
+// ----------------------------------------------------------------------------
+// Rewrites the journal file from the inputs in memory (after a rewound
+// session dropped its old future).
+// ----------------------------------------------------------------------------
+static void rewriteJournal() {
+    if (!JournalFile) return;
+    fclose(JournalFile);
+    JournalFile = fopen(JournalPath, "w");
+    if (!JournalFile) {
+        printf("Error: Could not rewrite journal %s\n", JournalPath);
+        return;
+    }
+    fprintf(JournalFile, "LEVEL %s\n", JournalLevel);
+    for (int e = 0; e < JournalCount; e++) writeRecord(JournalTick[e], JournalType[e], JournalArgs[e]);
+    fflush(JournalFile);
+}
+
+// ----------------------------------------------------------------------------
+// APPLY INPUT
+// ----------------------------------------------------------------------------
+// Inputs that change nothing (e.g. clicking empty ground) are not recorded.
+// Each record is flushed so the journal survives a crash of the app.
+//
+// Inputs are kept in memory too, so a seek can replay them. An input made
+// after seeking back starts a new future: inputs not yet re-applied and
+// checkpoints past this tick are dropped.
+// ----------------------------------------------------------------------------
+static bool performAndRecord(int type, const int* args) {
+    if (!performInput(type, args)) return false;
+    discardCheckpointsAfter(CurrentTick);
+    bool rewrite = JournalNext < JournalCount;
+    JournalCount = JournalNext;
+
+    if (JournalCount < MAX_JOURNAL_EVENTS) {
+        JournalTick[JournalCount] = CurrentTick;
+        JournalType[JournalCount] = type;
+        for (int a = 0; a < JournalArgCounts[type]; a++) JournalArgs[JournalCount][a] = args[a];
+        JournalCount++;
+        JournalNext = JournalCount;
+    } else if (!JournalFullWarned) {
+        JournalFullWarned = true;
+        printf("Warning: more than %d inputs, seeking back will not replay them\n", MAX_JOURNAL_EVENTS);
+    }
+
+    if (rewrite) {
+        rewriteJournal();
+    } else if (JournalFile) {
+        writeRecord(CurrentTick, type, args);
+        fflush(JournalFile);
+    }
+    return true;
+}
+
+bool applyInput(int type, int r, int c) {
+    if (type != JOURNAL_SAFETY_TILE && type != JOURNAL_SWITCH) return false;
+    int args[JOURNAL_MAX_ARGS] = { r, c, 0, 0, 0 };
+    return performAndRecord(type, args);
+}
+
+bool applyHaltRectInput(int top, int left, int bottom, int right, int ticks) {
+    int args[JOURNAL_MAX_ARGS] = { top, left, bottom, right, ticks };
+    return performAndRecord(JOURNAL_HALT_RECT, args);
+}
+
+bool applyHaltRadiusInput(int r, int c, int radius, int ticks) {
+    int args[JOURNAL_MAX_ARGS] = { r, c, radius, ticks, 0 };
+    return performAndRecord(JOURNAL_HALT_RADIUS, args);
+}
+
+// ----------------------------------------------------------------------------
+// CLOSE JOURNAL
+// ----------------------------------------------------------------------------
+void closeJournal() {
+    if (!JournalFile) return;
+    fprintf(JournalFile, "END %d\n", CurrentTick);
+    fclose(JournalFile);
+    JournalFile = NULL;
+}
+
+// ----------------------------------------------------------------------------
+// LOAD JOURNAL
+// ----------------------------------------------------------------------------
+bool loadJournal(const char* filename) {
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        printf("Error: Could not open journal %s\n", filename);
+        return false;
+    }
+
+    JournalCount = 0;
+    JournalNext = 0;
+    JournalEndTick = -1;
+
+    char line[512];
+    int lineNumber = 0;
+    bool ok = true;
+    while (fgets(line, sizeof(line), file)) {
+        lineNumber++;
+        if (strncmp(line, "LEVEL", 5) == 0 || line[0] == '\n' || line[0] == '#') continue;
+        if (sscanf(line, "END %d", &JournalEndTick) == 1) break;
+
+        int tick;
+        char letter;
+        int args[JOURNAL_MAX_ARGS] = { 0, 0, 0, 0, 0 };
+        int fields = sscanf(line, "%d %c %d %d %d %d %d", &tick, &letter,
+                            &args[0], &args[1], &args[2], &args[3], &args[4]);
+        int type = -1;
+        for (int t = 0; t < 4; t++) {
+            if (JournalLetters[t] == letter) type = t;
+        }
+        if (fields < 2 || type < 0 || fields != 2 + JournalArgCounts[type] ||
+            (JournalCount > 0 && tick < JournalTick[JournalCount - 1])) {
+            printf("Error: Bad journal record on line %d\n", lineNumber);
+            ok = false;
+            break;
+        }
+        if (JournalCount >= MAX_JOURNAL_EVENTS) {
+            printf("Error: Journal has more than %d inputs\n", MAX_JOURNAL_EVENTS);
+            ok = false;
+            break;
+        }
+        JournalTick[JournalCount] = tick;
+        JournalType[JournalCount] = type;
+        for (int a = 0; a < JOURNAL_MAX_ARGS; a++) JournalArgs[JournalCount][a] = args[a];
+        JournalCount++;
+    }
+
+    fclose(file);
+    if (!ok) JournalCount = 0;
+    return ok;
+}
+
+// ----------------------------------------------------------------------------
+// APPLY JOURNAL INPUTS
+// ----------------------------------------------------------------------------
+// Called right before simulateOneTick(), which is when the inputs originally
+// arrived.
+// ----------------------------------------------------------------------------
+void applyJournalInputs() {
+    while (JournalNext < JournalCount && JournalTick[JournalNext] <= CurrentTick) {
+        performInput(JournalType[JournalNext], JournalArgs[JournalNext]);
+        JournalNext++;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// REWIND JOURNAL
+// ----------------------------------------------------------------------------
+void rewindJournal() {
+    JournalNext = 0;
+    while (JournalNext < JournalCount && JournalTick[JournalNext] < CurrentTick) JournalNext++;
+}
+
+// ----------------------------------------------------------------------------
+// GET JOURNAL END TICK
+// ----------------------------------------------------------------------------
+int getJournalEndTick() {
+    return JournalEndTick;
+}
+
+// ----------------------------------------------------------------------------
+// RUN JOURNAL REPLAY
+// ----------------------------------------------------------------------------
+// Without an END record the replay runs until every train is done.
+// ----------------------------------------------------------------------------
+void runJournalReplay(int maxTicks) {
+    int endTick = JournalEndTick;
+    if (endTick < 0 || endTick > maxTicks) endTick = maxTicks;
+
+    while (CurrentTick < endTick) {
+        if (JournalEndTick < 0 && JournalNext >= JournalCount && isSimulationComplete()) break;
+        applyJournalInputs();
+        simulateOneTick();
+    }
+    // Inputs made after the last tick still change the final state
+    applyJournalInputs();
+}
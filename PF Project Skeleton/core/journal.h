@@ -0,0 +1,67 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+// ============================================================================
+// JOURNAL.H - Operator input journal and replay
+// ============================================================================
+// Every external input (safety tile clicks, switch toggles, halt zones) is
+// written with the tick it happened before, so a session can be re-run
+// headlessly and produce the same trace.csv. Recorded inputs also stay in
+// memory, so seeking within a session (timeline.h) replays them.
+//
+// File format (one record per line):
+//   LEVEL <path>
+//   <tick> T <row> <col>                          safety tile toggled
+//   <tick> S <row> <col>                          switch toggled
+//   <tick> H <top> <left> <bottom> <right> <n>    rectangle halted for n ticks
+//   <tick> R <row> <col> <radius> <n>             circle halted for n ticks
+//   END <tick>                                    session stopped after <tick> ticks
+// ============================================================================
+
+// INPUT TYPES
+#define JOURNAL_SAFETY_TILE 0
+#define JOURNAL_SWITCH 1
+#define JOURNAL_HALT_RECT 2
+#define JOURNAL_HALT_RADIUS 3
+#define JOURNAL_MAX_ARGS 5
+
+// Most inputs a replay can hold
+#define MAX_JOURNAL_EVENTS 65536
+
+// ----------------------------------------------------------------------------
+// RECORDING
+// ----------------------------------------------------------------------------
+// Start writing inputs to a journal file (levelPath is stored for reference).
+bool startJournal(const char* filename, const char* levelPath);
+
+// Perform a tile or switch toggle at CurrentTick and journal it if it
+// changed anything.
+bool applyInput(int type, int r, int c);
+
+// Add a halt zone at CurrentTick (journaled). Return false if it was refused.
+bool applyHaltRectInput(int top, int left, int bottom, int right, int ticks);
+bool applyHaltRadiusInput(int r, int c, int radius, int ticks);
+
+// Write the END record and close the journal.
+void closeJournal();
+
+// ----------------------------------------------------------------------------
+// REPLAY
+// ----------------------------------------------------------------------------
+// Read a journal for replay. Returns false if the file is missing or invalid.
+bool loadJournal(const char* filename);
+
+// Apply the loaded inputs that belong before the tick CurrentTick.
+void applyJournalInputs();
+
+// After the state was moved to an earlier tick: the next input to apply is
+// the first one at or after CurrentTick.
+void rewindJournal();
+
+// Tick count from the END record (-1 if the journal has none).
+int getJournalEndTick();
+
+// Re-run the loaded journal to its END tick (or maxTicks) at full speed.
+void runJournalReplay(int maxTicks);
+
+#endif
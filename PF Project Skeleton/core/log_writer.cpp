@@ -0,0 +1,362 @@
+#include "log_writer.h"
+#include "simulation_state.h"
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+// ============================================================================
+// LOG_WRITER.CPP - Background CSV log writer
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// RING
+// ----------------------------------------------------------------------------
+// Slot i of every array is one record. RingHead is only written by the
+// producer, RingTail and RingFlushed only by the writer; both count records
+// ever pushed / written, and wrap harmlessly. Switch and signal records carry
+// a copy of the switch name, taken when queued: a level load or snapshot
+// restore may rewrite SwitchName before the writer gets to them.
+// ----------------------------------------------------------------------------
+#define LOG_RING_MASK (LOG_RING_SIZE - 1)
+#define LOG_FILE_BUFFER (1 << 16)
+
+static int RingStream[LOG_RING_SIZE];
+static int RingTick[LOG_RING_SIZE];
+static int RingA[LOG_RING_SIZE];
+static int RingB[LOG_RING_SIZE];
+static int RingC[LOG_RING_SIZE];
+static int RingD[LOG_RING_SIZE];
+static const char* RingText[LOG_RING_SIZE];
+static unsigned long long RingValue[LOG_RING_SIZE];
+static char RingName[LOG_RING_SIZE][SWITCH_NAME_LENGTH];
+
+static std::atomic<unsigned int> RingHead(0);
+static std::atomic<unsigned int> RingTail(0);
+static std::atomic<unsigned int> RingFlushed(0);   // Written and fflush'ed
+static std::atomic<bool> WriterStop(false);
+static std::atomic<long long> DroppedRecords(0);
+
+// Batch reserved by reserveLogRecords and not yet published
+static unsigned int ReservedHead = 0;
+static int ReservedCount = 0;
+
+// ----------------------------------------------------------------------------
+// WAKE-UPS
+// ----------------------------------------------------------------------------
+// The writer sleeps on WriterWake while the ring is empty; the producer
+// sleeps on ProducerWake while it waits for room or a flush. Each sets its
+// flag before checking the ring a last time, and the other side only takes
+// the mutex to notify when it sees the flag after publishing, so no wake-up
+// is lost and a busy ring costs no locking. (Flags and ring counters use
+// sequentially consistent accesses so that one side always sees the other.)
+// ----------------------------------------------------------------------------
+static std::mutex WakeMutex;
+static std::condition_variable WriterWake;
+static std::condition_variable ProducerWake;
+static std::atomic<bool> WriterSleeping(false);
+static std::atomic<bool> ProducerSleeping(false);
+
+static int Backpressure = LOG_BLOCK;
+static std::thread* WriterThread = NULL;
+static bool ShutdownRegistered = false;
+
+// ----------------------------------------------------------------------------
+// FILES
+// ----------------------------------------------------------------------------
+// Opened and closed only by the simulation thread, while the writer is idle.
+// ----------------------------------------------------------------------------
+static FILE* LogFiles[LOG_STREAMS];
+static const char* LogPaths[LOG_STREAMS] = {
+    "out/trace.csv", "out/switches.csv", "out/signals.csv", "out/hash.csv"
+};
+static const char* LogHeaders[LOG_STREAMS] = {
+    "Tick,TrainID,X,Y,Direction,State\n",
+    "Tick,Switch,Mode,State\n",
+    "Tick,Switch,Signal\n",
+    "Tick,Hash\n"
+};
+
+// ----------------------------------------------------------------------------
+// Formats one record into its file (writer thread).
+// ----------------------------------------------------------------------------
+static void writeLogRecord(unsigned int slot) {
+    int stream = RingStream[slot];
+    FILE* f = LogFiles[stream];
+    if (!f) return;
+
+    if (stream == LOG_STREAM_TRACE) {
+        // Direction names for readability
+        const char* dirName = "UP";
+        if (RingD[slot] == 1) dirName = "RIGHT";
+        else if (RingD[slot] == 2) dirName = "DOWN";
+        else if (RingD[slot] == 3) dirName = "LEFT";
+        fprintf(f, "%d,%d,%d,%d,%s,%s\n", RingTick[slot], RingA[slot],
+                RingB[slot], RingC[slot], dirName, RingText[slot]);
+    } else if (stream == LOG_STREAM_SWITCH) {
+        // State: 0 = Straight (usually), 1 = Turn
+        const char* stateStr = (RingB[slot] == 0) ? "Straight" : "Turn";
+        fprintf(f, "%d,%s,%s,%s\n", RingTick[slot], RingName[slot], RingText[slot], stateStr);
+    } else if (stream == LOG_STREAM_SIGNAL) {
+        fprintf(f, "%d,%s,%s\n", RingTick[slot], RingName[slot], RingText[slot]);
+    } else if (stream == LOG_STREAM_HASH) {
+        fprintf(f, "%d,%016llx\n", RingTick[slot], RingValue[slot]);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Wakes the writer if it is asleep (after RingHead or WriterStop changed).
+// ----------------------------------------------------------------------------
+static void wakeLogWriter() {
+    if (!WriterSleeping.load()) return;
+    std::lock_guard<std::mutex> lock(WakeMutex);
+    WriterWake.notify_one();
+}
+
+// ----------------------------------------------------------------------------
+// Producer side: sleeps until ready() holds. The writer makes progress on
+// its own, so ready() only has to be checked after each batch it finishes.
+// ----------------------------------------------------------------------------
+static void waitForWriter(bool (*ready)()) {
+    if (ready()) return;
+    std::unique_lock<std::mutex> lock(WakeMutex);
+    ProducerSleeping.store(true);
+    while (!ready()) ProducerWake.wait(lock);
+    ProducerSleeping.store(false);
+}
+
+// ----------------------------------------------------------------------------
+// Writer thread: drains whatever is queued, flushes once per batch, and
+// sleeps while the ring is empty.
+// ----------------------------------------------------------------------------
+static void runLogWriter() {
+    while (true) {
+        unsigned int tail = RingTail.load(std::memory_order_relaxed);
+        unsigned int head = RingHead.load(std::memory_order_acquire);
+        if (tail == head) {
+            if (WriterStop.load(std::memory_order_acquire)) return;
+            std::unique_lock<std::mutex> lock(WakeMutex);
+            WriterSleeping.store(true);
+            while (RingHead.load() == tail && !WriterStop.load()) WriterWake.wait(lock);
+            WriterSleeping.store(false);
+            continue;
+        }
+        while (tail != head) {
+            writeLogRecord(tail & LOG_RING_MASK);
+            tail++;
+            RingTail.store(tail);
+        }
+        for (int s = 0; s < LOG_STREAMS; s++) {
+            if (LogFiles[s]) fflush(LogFiles[s]);
+        }
+        RingFlushed.store(tail);
+        if (ProducerSleeping.load()) {
+            std::lock_guard<std::mutex> lock(WakeMutex);
+            ProducerWake.notify_one();
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// OPEN LOG STREAMS
+// ----------------------------------------------------------------------------
+bool openLogStreams(const bool* open) {
+    flushLogWriter();
+    bool ok = true;
+    for (int s = 0; s < LOG_STREAMS; s++) {
+        if (LogFiles[s]) fclose(LogFiles[s]);
+        LogFiles[s] = NULL;
+        if (!open[s]) continue;
+
+        // "w+" clears the file from the previous run (and lets
+        // truncateLogStreams read it back)
+        LogFiles[s] = fopen(LogPaths[s], "w+");
+        if (!LogFiles[s]) {
+            ok = false;
+            continue;
+        }
+        setvbuf(LogFiles[s], NULL, _IOFBF, LOG_FILE_BUFFER);
+        fputs(LogHeaders[s], LogFiles[s]);
+        fflush(LogFiles[s]);
+    }
+
+    if (!WriterThread) {
+        WriterStop.store(false);
+        WriterThread = new std::thread(runLogWriter);
+        if (!ShutdownRegistered) atexit(shutdownLogWriter);
+        ShutdownRegistered = true;
+    }
+    return ok;
+}
+
+void setLogBackpressure(int mode) {
+    Backpressure = mode;
+}
+
+// ----------------------------------------------------------------------------
+// Tick of the first row starting at or after byte pos of a log file, whose
+// offset goes to rowStart. The header reads as tick -1 and the end of the
+// file as INT_MAX.
+// ----------------------------------------------------------------------------
+static int readRowTickAt(FILE* f, long pos, long end, long& rowStart) {
+    fseek(f, pos > 0 ? pos - 1 : 0, SEEK_SET);
+    if (pos > 0) {
+        int ch;
+        while ((ch = fgetc(f)) != '\n' && ch != EOF) {}
+    }
+    rowStart = ftell(f);
+    if (rowStart >= end) return INT_MAX;
+    int tick;
+    return fscanf(f, "%d", &tick) == 1 ? tick : -1;
+}
+
+// ----------------------------------------------------------------------------
+// TRUNCATE LOG STREAMS
+// ----------------------------------------------------------------------------
+// Rows are in tick order, so the cut is found by binary search over the
+// file's bytes (a few short reads however long the log is).
+// ----------------------------------------------------------------------------
+void truncateLogStreams(int tick) {
+    flushLogWriter();
+    for (int s = 0; s < LOG_STREAMS; s++) {
+        FILE* f = LogFiles[s];
+        if (!f) continue;
+        fseek(f, 0, SEEK_END);
+        long end = ftell(f);
+
+        long low = 0, high = end;
+        while (low < high) {
+            long mid = low + (high - low) / 2;
+            long rowStart;
+            if (readRowTickAt(f, mid, end, rowStart) >= tick) high = mid;
+            else low = mid + 1;
+        }
+        long cut;
+        readRowTickAt(f, low, end, cut);
+        fflush(f);
+        if (cut < end && ftruncate(fileno(f), cut) != 0) cut = end;
+        fseek(f, cut, SEEK_SET);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Stores one record in a ring slot (not yet visible to the writer).
+// ----------------------------------------------------------------------------
+static void fillRingSlot(unsigned int slot, int stream, int tick, int a, int b, int c, int d,
+                         const char* text, unsigned long long value) {
+    RingStream[slot] = stream;
+    RingTick[slot] = tick;
+    RingA[slot] = a;
+    RingB[slot] = b;
+    RingC[slot] = c;
+    RingD[slot] = d;
+    RingText[slot] = text;
+    RingValue[slot] = value;
+    if (stream == LOG_STREAM_SWITCH || stream == LOG_STREAM_SIGNAL) {
+        memcpy(RingName[slot], SwitchName[a], SWITCH_NAME_LENGTH);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Conditions the producer waits for: room for PendingCount more records, or
+// everything up to FlushTarget written and flushed.
+// ----------------------------------------------------------------------------
+static unsigned int PendingCount = 1;
+static unsigned int FlushTarget = 0;
+
+static bool hasRingRoom() {
+    unsigned int used = RingHead.load(std::memory_order_relaxed) - RingTail.load();
+    return used + PendingCount <= LOG_RING_SIZE;
+}
+
+static bool isFlushed() {
+    return (int)(FlushTarget - RingFlushed.load()) <= 0;
+}
+
+// ----------------------------------------------------------------------------
+// PUSH LOG RECORD
+// ----------------------------------------------------------------------------
+void pushLogRecord(int stream, int tick, int a, int b, int c, int d,
+                   const char* text, unsigned long long value) {
+    if (!WriterThread) return;
+    PendingCount = 1;
+    if (!hasRingRoom()) {
+        if (Backpressure == LOG_DROP) {
+            DroppedRecords.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        waitForWriter(hasRingRoom);
+    }
+
+    unsigned int head = RingHead.load(std::memory_order_relaxed);
+    fillRingSlot(head & LOG_RING_MASK, stream, tick, a, b, c, d, text, value);
+    RingHead.store(head + 1);
+    wakeLogWriter();
+}
+
+// ----------------------------------------------------------------------------
+// RECORD BATCHES
+// ----------------------------------------------------------------------------
+bool reserveLogRecords(int count) {
+    if (!WriterThread || count > LOG_RING_SIZE) return false;
+    PendingCount = (unsigned int)count;
+    if (!hasRingRoom()) {
+        if (Backpressure == LOG_DROP) {
+            DroppedRecords.fetch_add(count, std::memory_order_relaxed);
+            return false;
+        }
+        waitForWriter(hasRingRoom);
+    }
+    ReservedHead = RingHead.load(std::memory_order_relaxed);
+    ReservedCount = count;
+    return true;
+}
+
+void setLogRecord(int k, int stream, int tick, int a, int b, int c, int d,
+                  const char* text, unsigned long long value) {
+    fillRingSlot((ReservedHead + k) & LOG_RING_MASK, stream, tick, a, b, c, d, text, value);
+}
+
+void publishLogRecords() {
+    RingHead.store(ReservedHead + ReservedCount);
+    ReservedCount = 0;
+    wakeLogWriter();
+}
+
+// ----------------------------------------------------------------------------
+// FLUSH LOG WRITER
+// ----------------------------------------------------------------------------
+void flushLogWriter() {
+    if (!WriterThread) return;
+    FlushTarget = RingHead.load(std::memory_order_relaxed);
+    waitForWriter(isFlushed);
+}
+
+// ----------------------------------------------------------------------------
+// SHUTDOWN LOG WRITER
+// ----------------------------------------------------------------------------
+void shutdownLogWriter() {
+    if (!WriterThread) return;
+    flushLogWriter();
+    WriterStop.store(true);
+    wakeLogWriter();
+    WriterThread->join();
+    delete WriterThread;
+    WriterThread = NULL;
+
+    for (int s = 0; s < LOG_STREAMS; s++) {
+        if (LogFiles[s]) fclose(LogFiles[s]);
+        LogFiles[s] = NULL;
+    }
+    long long dropped = DroppedRecords.load();
+    if (dropped > 0) printf("Warning: %lld log records were dropped (ring full)\n", dropped);
+}
+
+long long getDroppedLogRecords() {
+    return DroppedRecords.load();
+}
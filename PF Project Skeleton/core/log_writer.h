@@ -0,0 +1,83 @@
+#ifndef LOG_WRITER_H
+#define LOG_WRITER_H
+
+// ============================================================================
+// LOG_WRITER.H - Background CSV log writer
+// ============================================================================
+// The tick loop only copies a fixed-size record (stream, tick, four ints, a
+// text pointer, one 64-bit value) into a single-producer / single-consumer
+// ring. A background thread formats the records and writes them to files
+// that stay open for the whole run, so fprintf and disk stalls never run on
+// the simulation thread.
+//
+// Text fields must point to string literals (or other storage that outlives
+// the run): only the pointer is queued. Switch names are copied instead. The
+// writer sleeps while the ring is empty and is woken by the next record.
+//
+// When the ring is full the producer either waits for the writer
+// (LOG_BLOCK, the default, nothing is lost) or drops the record and counts it
+// (LOG_DROP, the tick never waits).
+// ============================================================================
+
+// STREAMS (one output file each)
+#define LOG_STREAM_TRACE  0   // out/trace.csv
+#define LOG_STREAM_SWITCH 1   // out/switches.csv
+#define LOG_STREAM_SIGNAL 2   // out/signals.csv
+#define LOG_STREAM_HASH   3   // out/hash.csv
+#define LOG_STREAMS 4
+
+// BACKPRESSURE MODES
+#define LOG_BLOCK 0
+#define LOG_DROP  1
+
+// Records the ring holds (power of two)
+#define LOG_RING_SIZE 65536
+
+// ----------------------------------------------------------------------------
+// SETUP
+// ----------------------------------------------------------------------------
+// Finish pending records, then (re)create the log files of the streams with
+// open[stream] set, write their headers and start the writer thread if needed.
+bool openLogStreams(const bool* open);
+
+// Choose what happens when the ring is full (LOG_BLOCK or LOG_DROP).
+void setLogBackpressure(int mode);
+
+// Finish pending records, then cut every open log file before its first row
+// of tick or later (for a run rewound to tick, which logs them again).
+void truncateLogStreams(int tick);
+
+// ----------------------------------------------------------------------------
+// PRODUCER (simulation thread)
+// ----------------------------------------------------------------------------
+// Queue one record for a stream. Field meaning per stream:
+//   TRACE:  a = train, b = x, c = y, d = direction, text = state
+//   SWITCH: a = switch ID, b = state, text = mode
+//   SIGNAL: a = switch ID, text = colour
+//   HASH:   value = state hash
+void pushLogRecord(int stream, int tick, int a, int b, int c, int d,
+                   const char* text, unsigned long long value);
+
+// A batch of records filled by several threads. The simulation thread
+// reserves count slots (waiting for room like pushLogRecord; in LOG_DROP
+// mode the whole batch is dropped and false returned), any thread fills
+// slot k = 0 .. count - 1 with setLogRecord, and the simulation thread
+// hands the batch to the writer with publishLogRecords.
+bool reserveLogRecords(int count);
+void setLogRecord(int k, int stream, int tick, int a, int b, int c, int d,
+                  const char* text, unsigned long long value);
+void publishLogRecords();
+
+// ----------------------------------------------------------------------------
+// SYNCHRONISATION
+// ----------------------------------------------------------------------------
+// Wait until everything queued so far is written and flushed to the files.
+void flushLogWriter();
+
+// Flush, stop the thread and close the files (also runs at exit).
+void shutdownLogWriter();
+
+// Records lost in LOG_DROP mode since the start of the program.
+long long getDroppedLogRecords();
+
+#endif
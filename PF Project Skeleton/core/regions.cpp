@@ -0,0 +1,227 @@
+#include "regions.h"
+#include "simulation_state.h"
+#include "grid.h"
+#include "trains.h"
+#include "routing.h"
+#include "thread_pool.h"
+#include <cstring>
+
+// ============================================================================
+// REGIONS.CPP - Train phases of a tick, split by map region
+// ============================================================================
+
+// Follows setPoolMinItems() (thread_pool.h) when it is set
+#define REGION_PAIRWISE_TRAINS 32   // Up to this many active trains: test every pair
+#define REGION_MIN_BAND_ROWS 8      // Thinner bands would be mostly halo
+
+// ----------------------------------------------------------------------------
+// BANDS OF THE CURRENT TICK
+// ----------------------------------------------------------------------------
+// Band b covers rows RegionTop[b] .. RegionTop[b + 1] - 1 and holds trains
+// RegionTrains[RegionStart[b] .. RegionStart[b + 1] - 1], in index order.
+// ----------------------------------------------------------------------------
+static int RegionCount = 1;
+static int RegionTop[POOL_MAX_THREADS + 1];
+static int RegionStart[POOL_MAX_THREADS + 1];
+static int RegionTrains[MAX_TRAINS];
+static bool RegionUseCells = true;  // false: few trains, or one is off the map
+
+// Active trains standing on each cell, linked through CellNext (-1 = end).
+// Emptied again at the end of every tick.
+static int CellHead[MAX_ROWS][MAX_COLS];
+static int CellNext[MAX_TRAINS];
+static bool CellHeadsReady = false;
+
+// Groups of near trains (union-find) and whether a group reaches a halo
+static int GroupParent[MAX_TRAINS];
+static bool GroupInHalo[MAX_TRAINS];
+static bool TrainInHaloGroup[MAX_TRAINS];
+
+// Cells at most 2 steps away, where a conflicting train can stand
+static const int NearDr[13] = { -2, -1, -1, -1, 0, 0, 0, 0, 0, 1, 1, 1, 2 };
+static const int NearDc[13] = { 0, -1, 0, 1, -2, -1, 0, 1, 2, -1, 0, 1, 0 };
+
+// ----------------------------------------------------------------------------
+// Root of a train's group (path halving).
+// ----------------------------------------------------------------------------
+static int findGroup(int i) {
+    while (GroupParent[i] != i) {
+        GroupParent[i] = GroupParent[GroupParent[i]];
+        i = GroupParent[i];
+    }
+    return i;
+}
+
+// ----------------------------------------------------------------------------
+// Trains j > i standing within 2 cells of train i, on rows top .. bottom - 1,
+// in ascending order. Returns how many were stored.
+// ----------------------------------------------------------------------------
+static int collectNeighbours(int i, int top, int bottom, int* out) {
+    int count = 0;
+    int r = TrainCurrentRow[i];
+    int c = TrainCurrentCol[i];
+    for (int k = 0; k < 13; k++) {
+        int nr = r + NearDr[k];
+        int nc = c + NearDc[k];
+        if (nr < top || nr >= bottom || nc < 0 || nc >= LevelNumCols) continue;
+        for (int j = CellHead[nr][nc]; j >= 0; j = CellNext[j]) {
+            if (j <= i) continue;
+            int p = count++;
+            while (p > 0 && out[p - 1] > j) {
+                out[p] = out[p - 1];
+                p--;
+            }
+            out[p] = j;
+        }
+    }
+    return count;
+}
+
+// ----------------------------------------------------------------------------
+// Work of one band: plan its trains' moves, group near trains, and resolve
+// the groups that do not reach a halo.
+// ----------------------------------------------------------------------------
+static void runRegion(int band) {
+    int first = RegionStart[band];
+    int end = RegionStart[band + 1];
+    for (int k = first; k < end; k++) planTrainMove(RegionTrains[k]);
+    if (!RegionUseCells) return;
+
+    // Only this band's rows of the cell lists are touched
+    int top = RegionTop[band];
+    int bottom = RegionTop[band + 1];
+    for (int k = first; k < end; k++) {
+        int i = RegionTrains[k];
+        int r = TrainCurrentRow[i];
+        int c = TrainCurrentCol[i];
+        CellNext[i] = CellHead[r][c];
+        CellHead[r][c] = i;
+        GroupParent[i] = i;
+        GroupInHalo[i] = false;
+    }
+
+    int near[MAX_TRAINS];
+    for (int k = first; k < end; k++) {
+        int i = RegionTrains[k];
+        int count = collectNeighbours(i, top, bottom, near);
+        for (int n = 0; n < count; n++) {
+            int a = findGroup(i);
+            int b = findGroup(near[n]);
+            if (a != b) GroupParent[b] = a;
+        }
+    }
+
+    for (int k = first; k < end; k++) {
+        int i = RegionTrains[k];
+        int r = TrainCurrentRow[i];
+        if ((top > 0 && r < top + REGION_HALO) || (bottom < LevelNumRows && r >= bottom - REGION_HALO)) {
+            GroupInHalo[findGroup(i)] = true;
+        }
+    }
+
+    // Trains are in index order, so pairs come in the (i, j) order of
+    // detectCollisions()
+    for (int k = first; k < end; k++) {
+        int i = RegionTrains[k];
+        TrainInHaloGroup[i] = GroupInHalo[findGroup(i)];
+        if (TrainInHaloGroup[i]) continue;
+        int count = collectNeighbours(i, top, bottom, near);
+        for (int n = 0; n < count; n++) resolveCollisionPair(i, near[n]);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Pool loop body: one item per band.
+// ----------------------------------------------------------------------------
+static void runRegions(int begin, int end, int worker) {
+    (void)worker;
+    for (int band = begin; band < end; band++) runRegion(band);
+}
+
+// ----------------------------------------------------------------------------
+// Cuts the map into bands and sorts the active trains into them. Returns the
+// number of active trains.
+// ----------------------------------------------------------------------------
+static int splitIntoRegions() {
+    int active = ActiveTrainCount;
+    RegionUseCells = active > getPoolGrain(REGION_PAIRWISE_TRAINS);
+    for (int k = 0; k < active && RegionUseCells; k++) {
+        int i = ActiveTrainList[k];
+        if (!isInBounds(TrainCurrentRow[i], TrainCurrentCol[i])) RegionUseCells = false;
+    }
+
+    int threads = 1;
+    if (active >= getPoolGrain(POOL_TICK_GRAIN)) {
+        threads = getPoolThreads();
+        if (threads > LevelNumRows / REGION_MIN_BAND_ROWS) threads = LevelNumRows / REGION_MIN_BAND_ROWS;
+        if (threads < 1) threads = 1;
+    }
+
+    RegionCount = threads;
+    for (int b = 0; b <= RegionCount; b++) RegionTop[b] = b * LevelNumRows / RegionCount;
+    if (RegionCount == 1) {
+        memcpy(RegionTrains, ActiveTrainList, active * sizeof(int));
+        RegionStart[0] = 0;
+        RegionStart[1] = active;
+        return active;
+    }
+
+    // Counting sort by band keeps index order inside each band
+    int rowBand[MAX_ROWS];
+    for (int b = 0; b < RegionCount; b++) {
+        for (int r = RegionTop[b]; r < RegionTop[b + 1]; r++) rowBand[r] = b;
+    }
+    int counts[POOL_MAX_THREADS + 1];
+    for (int b = 0; b <= RegionCount; b++) counts[b] = 0;
+    int trainBand[MAX_TRAINS];
+    for (int k = 0; k < active; k++) {
+        int i = ActiveTrainList[k];
+        int r = TrainCurrentRow[i];
+        if (r < 0) r = 0;
+        if (r >= LevelNumRows) r = LevelNumRows - 1;
+        trainBand[i] = (r >= 0) ? rowBand[r] : 0;
+        counts[trainBand[i] + 1]++;
+    }
+    for (int b = 0; b < RegionCount; b++) counts[b + 1] += counts[b];
+    for (int b = 0; b <= RegionCount; b++) RegionStart[b] = counts[b];
+    for (int k = 0; k < active; k++) {
+        int i = ActiveTrainList[k];
+        RegionTrains[counts[trainBand[i]]++] = i;
+    }
+    return active;
+}
+
+// ----------------------------------------------------------------------------
+// PLAN TRAIN MOVES
+// ----------------------------------------------------------------------------
+void planTrainMoves() {
+    if (!CellHeadsReady) {
+        memset(CellHead, 0xFF, sizeof(CellHead));
+        CellHeadsReady = true;
+    }
+    int active = splitIntoRegions();
+
+    // Bands only read the route tables; build them before sharing out
+    if (RegionCount > 1) precomputeRoutes();
+    parallelFor(RegionCount, 1, runRegions);
+
+    // Few trains (cheaper to test every pair), or one off the map (no cell)
+    if (!RegionUseCells) {
+        detectCollisions();
+        return;
+    }
+
+    // Groups reaching a halo, now that every band's trains are listed
+    int near[MAX_TRAINS];
+    for (int k = 0; k < active; k++) {
+        int i = ActiveTrainList[k];
+        if (!TrainInHaloGroup[i]) continue;
+        int count = collectNeighbours(i, 0, LevelNumRows, near);
+        for (int n = 0; n < count; n++) resolveCollisionPair(i, near[n]);
+    }
+
+    for (int k = 0; k < active; k++) {
+        int i = RegionTrains[k];
+        CellHead[TrainCurrentRow[i]][TrainCurrentCol[i]] = -1;
+    }
+}
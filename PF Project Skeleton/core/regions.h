@@ -0,0 +1,32 @@
+#ifndef REGIONS_H
+#define REGIONS_H
+
+// ============================================================================
+// REGIONS.H - Train phases of a tick, split by map region
+// ============================================================================
+// Routing, emergency halts, weather and collision checks, done region by
+// region. The map is cut into horizontal bands, one per thread of the pool
+// (thread_pool.h), and a train belongs to the band of the row it stands on.
+//
+// A train moves at most one cell per tick, so two trains can only conflict
+// when they stand at most 2 cells apart. Conflicts are found through a list
+// of trains per cell instead of by testing every pair. Trains linked by such
+// near neighbours form a group; groups never affect each other, and checking
+// a group's pairs in (i, j) order gives exactly what detectCollisions() does
+// (lowest index wins a tie). A band resolves the groups that lie entirely
+// inside it. Groups with a train in the halo (the 2 rows next to another
+// band) are resolved on the calling thread once every band is done.
+// ============================================================================
+
+// Rows next to a band edge whose trains may conflict across it
+#define REGION_HALO 2
+
+// ----------------------------------------------------------------------------
+// PLAN TRAIN MOVES
+// ----------------------------------------------------------------------------
+// Plans the move of every active train (route, halt, weather) and resolves
+// conflicts between the planned moves. Same result as determineAllRoutes(),
+// applyEmergencyHalt(), applyWeatherEffects() and detectCollisions() in turn.
+void planTrainMoves();
+
+#endif
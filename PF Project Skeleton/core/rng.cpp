@@ -0,0 +1,50 @@
+#include "rng.h"
+
+// ============================================================================
+// RNG.CPP - Counter-based random numbers
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// splitmix64 finalizer: every input bit affects every output bit.
+// ----------------------------------------------------------------------------
+static unsigned long long scramble(unsigned long long x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// ----------------------------------------------------------------------------
+// RNG DRAW
+// ----------------------------------------------------------------------------
+// The seed is scrambled on its own first so nearby seeds give unrelated
+// sequences. Tick, id and stream fill one counter (32 + 20 + 12 bits); the
+// golden-ratio step keeps counter 0 away from the zero fixed point.
+// ----------------------------------------------------------------------------
+unsigned long long rngDraw(unsigned int seed, int tick, int id, int stream) {
+    unsigned long long key = scramble((unsigned long long)seed + 0x9e3779b97f4a7c15ULL);
+    unsigned long long counter = ((unsigned long long)(unsigned int)tick << 32) |
+                                 ((unsigned long long)(id & 0xFFFFF) << 12) |
+                                 (unsigned long long)(stream & 0xFFF);
+    return scramble(key ^ (counter * 0x9e3779b97f4a7c15ULL + 0x9e3779b97f4a7c15ULL));
+}
+
+// ----------------------------------------------------------------------------
+// RNG BELOW
+// ----------------------------------------------------------------------------
+// Multiply-shift of the top 32 bits instead of %, so small n stay unbiased
+// to within 2^-32.
+// ----------------------------------------------------------------------------
+int rngBelow(unsigned int seed, int tick, int id, int stream, int n) {
+    unsigned long long bits = rngDraw(seed, tick, id, stream) >> 32;
+    return (int)((bits * (unsigned long long)n) >> 32);
+}
+
+// ----------------------------------------------------------------------------
+// RNG CHANCE
+// ----------------------------------------------------------------------------
+bool rngChance(unsigned int seed, int tick, int id, int stream, int num, int den) {
+    return rngBelow(seed, tick, id, stream, den) < num;
+}
@@ -0,0 +1,31 @@
+#ifndef RNG_H
+#define RNG_H
+
+// ============================================================================
+// RNG.H - Counter-based random numbers
+// ============================================================================
+// A draw is a pure function of (seed, tick, id, stream): the key is packed
+// into one 64-bit counter and scrambled with the splitmix64 finalizer. There
+// is no hidden generator state, so results do not depend on the order trains
+// are processed in (or on threads), and a replay or a snapshot restore gets
+// the same numbers without saving anything. A draw is a few multiplies.
+// ============================================================================
+
+// STREAMS (one per kind of decision, so they never share numbers)
+#define RNG_STREAM_RAIN      1
+#define RNG_STREAM_FOG       2
+#define RNG_STREAM_OPTIMIZER 3
+
+// ----------------------------------------------------------------------------
+// DRAWS
+// ----------------------------------------------------------------------------
+// 64 random bits for the key.
+unsigned long long rngDraw(unsigned int seed, int tick, int id, int stream);
+
+// Uniform integer in [0, n) for the key (n > 0).
+int rngBelow(unsigned int seed, int tick, int id, int stream, int n);
+
+// True with probability num / den for the key.
+bool rngChance(unsigned int seed, int tick, int id, int stream, int num, int den);
+
+#endif
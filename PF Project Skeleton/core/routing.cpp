@@ -0,0 +1,394 @@
+#include "routing.h"
+#include "simulation_state.h"
+#include "grid.h"
+#include "trains.h"
+#include "thread_pool.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// ============================================================================
+// ROUTING.CPP - Shortest paths on the track graph
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// TRACK INDEX
+// ----------------------------------------------------------------------------
+// Track cells get compact ids; a state is a train on a track cell facing dir:
+// state = cellId * 4 + dir. Destinations ('D' tiles) are numbered too.
+// ----------------------------------------------------------------------------
+#define ROUTE_CELLS (MAX_ROWS * MAX_COLS)
+#define ROUTE_STATES (ROUTE_CELLS * 4)
+#define ROUTE_MAX_EDGES (ROUTE_STATES * 3)
+#define ROUTE_FAR 0xFFFF          // 16-bit "unreachable"
+#define ROUTE_SERIAL_WORK 200000  // Fewer state visits than this: one thread
+
+static int RouteCellId[MAX_ROWS][MAX_COLS];   // -1 = not track
+static int RouteNumStates = 0;
+static int RouteDestId[MAX_ROWS][MAX_COLS];   // -1 = not a 'D' tile
+static int RouteNumDests = 0;
+
+// ----------------------------------------------------------------------------
+// TRACK GRAPH
+// ----------------------------------------------------------------------------
+// Edges go from a state to the states one move later (a '+' has one edge per
+// usable exit). Reverse edges are stored packed (CSR) for the backwards BFS.
+// RouteArrival holds the destination a state's next move ends on, or -1.
+// The graph only changes when tiles do (edit, level load, restore).
+// ----------------------------------------------------------------------------
+static int RoutePredStart[ROUTE_STATES + 1];
+static int RoutePred[ROUTE_MAX_EDGES];
+static int RouteArrival[ROUTE_STATES];
+static bool RouteGraphValid = false;
+
+// ----------------------------------------------------------------------------
+// SWITCH EDGES
+// ----------------------------------------------------------------------------
+// Moves onto a switch are not in RoutePred: the BFS follows them with the
+// switch's state at the time, so a flip leaves the graph as it is. Switch
+// cells are listed grouped by switch (RouteSwitchStart[idx] up to
+// RouteSwitchStart[idx + 1]). Entry[d] is the state that moves onto the cell
+// facing d (-1 if none) and Turn[d] its exit in state 1 (state 0 keeps d).
+// ----------------------------------------------------------------------------
+static int RouteCellSwitch[ROUTE_CELLS];      // List position, -1 = no switch
+static int RouteSwitchStart[MAX_SWITCHES + 1];
+static int RouteSwitchCell[ROUTE_CELLS];
+static int RouteSwitchIdx[ROUTE_CELLS];
+static int RouteSwitchEntry[ROUTE_CELLS][4];
+static signed char RouteSwitchTurn[ROUTE_CELLS][4];
+
+// ----------------------------------------------------------------------------
+// DISTANCE TABLES
+// ----------------------------------------------------------------------------
+// Slot 0 = any 'D', slot 1 + k = destination k. Each slot is RouteNumStates
+// 16-bit entries, built on the first lookup after they went stale (see
+// precomputeRoutes). RouteSlotReady[slot] is 1 while the slot matches the
+// track and switches, 2 while it is listed for the next build.
+// ----------------------------------------------------------------------------
+static unsigned short* RouteTable = NULL;
+static unsigned char* RouteSlotReady = NULL;
+static int* RouteBuildList = NULL;
+static int RouteTableSlots = 0;
+
+// BFS queue of each pool worker
+static int* RouteQueue[POOL_MAX_THREADS];
+static int RouteQueueSize[POOL_MAX_THREADS];
+
+// ----------------------------------------------------------------------------
+// Switch state as it will be once queued flips are applied.
+// ----------------------------------------------------------------------------
+static int getEffectiveSwitchState(int idx) {
+    return SwitchFlipQueue[idx] ? 1 - SwitchCurrentState[idx] : SwitchCurrentState[idx];
+}
+
+// ----------------------------------------------------------------------------
+// Switch that decides the exit of track cell (r, c), or -1. Moves onto a 'D'
+// end the route and a '+' has its own exits, whatever getSwitchIndex() says.
+// ----------------------------------------------------------------------------
+static int getRouteSwitch(int r, int c) {
+    char tile = getTile(r, c);
+    if (tile == 'D' || tile == '+') return -1;
+    return getSwitchIndex(r, c);
+}
+
+// ----------------------------------------------------------------------------
+// Lists the states reachable in one move from (r, c, dir) that do not depend
+// on a switch. Returns how many were written to next[] (0 for a move onto a
+// switch, see SWITCH EDGES), or -1 if the move ends on a 'D' tile.
+// ----------------------------------------------------------------------------
+static int getRouteSuccessors(int r, int c, int dir, int next[3]) {
+    int dr, dc;
+    getDelta(dir, dr, dc);
+    int nr = r + dr;
+    int nc = c + dc;
+    if (!isTrackTile(nr, nc)) return 0; // Would crash
+    char tile = getTile(nr, nc);
+    if (tile == 'D') return -1;
+
+    int cell = RouteCellId[nr][nc];
+    if (tile == '+') {
+        // Same candidates as getSmartDirectionAtCrossing
+        int candidates[3] = { dir, (dir + 3) % 4, (dir + 1) % 4 };
+        int count = 0;
+        for (int k = 0; k < 3; k++) {
+            int er, ec;
+            getDelta(candidates[k], er, ec);
+            if (isTrackTile(nr + er, nc + ec)) next[count++] = cell * 4 + candidates[k];
+        }
+        return count;
+    }
+
+    if (RouteCellSwitch[cell] >= 0) return 0;
+    next[0] = cell * 4 + getNextDirection(nr, nc, dir, tile);
+    return 1;
+}
+
+// ----------------------------------------------------------------------------
+// Lists the switch cells grouped by switch, with their entries and turns.
+// ----------------------------------------------------------------------------
+static void buildRouteSwitches() {
+    for (int i = 0; i <= MAX_SWITCHES; i++) RouteSwitchStart[i] = 0;
+    for (int k = 0; k < GridChunkCount; k++) {
+        int r0, c0, r1, c1;
+        getChunkBounds(k, r0, c0, r1, c1);
+        for (int r = r0; r < r1; r++) {
+            for (int c = c0; c < c1; c++) {
+                int cell = RouteCellId[r][c];
+                if (cell < 0) continue;
+                int idx = getRouteSwitch(r, c);
+                RouteCellSwitch[cell] = -1;
+                if (idx >= 0) RouteSwitchStart[idx + 1]++;
+            }
+        }
+    }
+    for (int i = 0; i < MAX_SWITCHES; i++) RouteSwitchStart[i + 1] += RouteSwitchStart[i];
+
+    for (int k = 0; k < GridChunkCount; k++) {
+        int r0, c0, r1, c1;
+        getChunkBounds(k, r0, c0, r1, c1);
+        for (int r = r0; r < r1; r++) {
+            for (int c = c0; c < c1; c++) {
+                int cell = RouteCellId[r][c];
+                if (cell < 0) continue;
+                int idx = getRouteSwitch(r, c);
+                if (idx < 0) continue;
+                int pos = RouteSwitchStart[idx]++;
+                RouteCellSwitch[cell] = pos;
+                RouteSwitchCell[pos] = cell;
+                RouteSwitchIdx[pos] = idx;
+                for (int d = 0; d < 4; d++) {
+                    int dr, dc;
+                    getDelta(d, dr, dc);
+                    int pr = r - dr;
+                    int pc = c - dc;
+                    bool entry = isInBounds(pr, pc) && RouteCellId[pr][pc] >= 0;
+                    RouteSwitchEntry[pos][d] = entry ? RouteCellId[pr][pc] * 4 + d : -1;
+                    RouteSwitchTurn[pos][d] = (signed char)getSwitchExitDirection(r, c, d, 1);
+                }
+            }
+        }
+    }
+    // Filling advanced every start by its count; shift them back
+    for (int i = MAX_SWITCHES; i > 0; i--) RouteSwitchStart[i] = RouteSwitchStart[i - 1];
+    RouteSwitchStart[0] = 0;
+}
+
+// ----------------------------------------------------------------------------
+// Numbers track cells and destinations, builds the reverse edges and makes
+// room for the tables (all stale).
+// ----------------------------------------------------------------------------
+static void buildRouteGraph() {
+    // Only allocated chunks can hold track; cells are numbered chunk by chunk
+    int numCells = 0;
+    RouteNumDests = 0;
+    memset(RouteCellId, 0xFF, sizeof(RouteCellId));
+    memset(RouteDestId, 0xFF, sizeof(RouteDestId));
+    for (int k = 0; k < GridChunkCount; k++) {
+        int r0, c0, r1, c1;
+        getChunkBounds(k, r0, c0, r1, c1);
+        for (int r = r0; r < r1; r++) {
+            for (int c = c0; c < c1; c++) {
+                if (isTrackTile(r, c)) RouteCellId[r][c] = numCells++;
+                if (getTileClass(r, c) == TILE_DEST) RouteDestId[r][c] = RouteNumDests++;
+            }
+        }
+    }
+    RouteNumStates = numCells * 4;
+    buildRouteSwitches();
+
+    // Count predecessors of each state
+    for (int s = 0; s <= RouteNumStates; s++) RoutePredStart[s] = 0;
+    for (int k = 0; k < GridChunkCount; k++) {
+        int r0, c0, r1, c1;
+        getChunkBounds(k, r0, c0, r1, c1);
+        for (int r = r0; r < r1; r++) {
+            for (int c = c0; c < c1; c++) {
+                if (RouteCellId[r][c] < 0) continue;
+                for (int d = 0; d < 4; d++) {
+                    int next[3];
+                    int count = getRouteSuccessors(r, c, d, next);
+                    for (int n = 0; n < count; n++) RoutePredStart[next[n] + 1]++;
+                }
+            }
+        }
+    }
+    for (int s = 0; s < RouteNumStates; s++) RoutePredStart[s + 1] += RoutePredStart[s];
+
+    // Fill predecessor lists and note which moves arrive where
+    for (int k = 0; k < GridChunkCount; k++) {
+        int r0, c0, r1, c1;
+        getChunkBounds(k, r0, c0, r1, c1);
+        for (int r = r0; r < r1; r++) {
+            for (int c = c0; c < c1; c++) {
+                if (RouteCellId[r][c] < 0) continue;
+                for (int d = 0; d < 4; d++) {
+                    int state = RouteCellId[r][c] * 4 + d;
+                    int next[3];
+                    int count = getRouteSuccessors(r, c, d, next);
+                    RouteArrival[state] = -1;
+                    if (count < 0) {
+                        int dr, dc;
+                        getDelta(d, dr, dc);
+                        RouteArrival[state] = RouteDestId[r + dr][c + dc];
+                    }
+                    for (int n = 0; n < count; n++) {
+                        RoutePred[RoutePredStart[next[n]]++] = state;
+                    }
+                }
+            }
+        }
+    }
+    // Filling advanced every start by its count; shift them back
+    for (int s = RouteNumStates; s > 0; s--) RoutePredStart[s] = RoutePredStart[s - 1];
+    RoutePredStart[0] = 0;
+
+    int slots = 1 + RouteNumDests;
+    unsigned short* table = (unsigned short*)realloc(RouteTable,
+                            sizeof(unsigned short) * (size_t)slots * (RouteNumStates > 0 ? RouteNumStates : 1));
+    unsigned char* ready = (unsigned char*)realloc(RouteSlotReady, slots);
+    int* list = (int*)realloc(RouteBuildList, sizeof(int) * slots);
+    if (table) RouteTable = table;
+    if (ready) RouteSlotReady = ready;
+    if (list) RouteBuildList = list;
+    if (!table || !ready || !list) {
+        printf("Error: Not enough memory for route tables\n");
+        exit(1);
+    }
+    memset(RouteSlotReady, 0, slots);
+    RouteTableSlots = slots;
+    RouteGraphValid = true;
+}
+
+// ----------------------------------------------------------------------------
+// Backwards BFS for one slot on the given pool worker. Slot 0 starts from
+// every arriving move, slot 1 + k only from moves onto destination k (other
+// 'D' tiles end the route).
+// ----------------------------------------------------------------------------
+static void buildRouteSlot(int slot, int worker) {
+    if (RouteQueueSize[worker] < RouteNumStates) {
+        int* grown = (int*)realloc(RouteQueue[worker], sizeof(int) * RouteNumStates);
+        if (!grown) {
+            printf("Error: Not enough memory for route tables\n");
+            exit(1);
+        }
+        RouteQueue[worker] = grown;
+        RouteQueueSize[worker] = RouteNumStates;
+    }
+    int* queue = RouteQueue[worker];
+    unsigned short* dist = RouteTable + (long)slot * RouteNumStates;
+    int head = 0, tail = 0;
+    for (int s = 0; s < RouteNumStates; s++) {
+        bool seed = (slot == 0) ? RouteArrival[s] >= 0 : RouteArrival[s] == slot - 1;
+        dist[s] = seed ? 1 : ROUTE_FAR;
+        if (seed) queue[tail++] = s;
+    }
+    while (head < tail) {
+        int state = queue[head++];
+        unsigned short next = (unsigned short)(dist[state] + 1);
+        for (int p = RoutePredStart[state]; p < RoutePredStart[state + 1]; p++) {
+            int prev = RoutePred[p];
+            if (dist[prev] == ROUTE_FAR) {
+                dist[prev] = next;
+                queue[tail++] = prev;
+            }
+        }
+
+        // Moves onto a switch cell that leave it facing this state's dir
+        int sw = RouteCellSwitch[state >> 2];
+        if (sw < 0) continue;
+        int turned = getEffectiveSwitchState(RouteSwitchIdx[sw]);
+        for (int d = 0; d < 4; d++) {
+            int prev = RouteSwitchEntry[sw][d];
+            int exitDir = turned ? RouteSwitchTurn[sw][d] : d;
+            if (prev >= 0 && exitDir == (state & 3) && dist[prev] == ROUTE_FAR) {
+                dist[prev] = next;
+                queue[tail++] = prev;
+            }
+        }
+    }
+    RouteSlotReady[slot] = 1;
+}
+
+// ----------------------------------------------------------------------------
+// Pool body: builds the listed slots begin .. end - 1.
+// ----------------------------------------------------------------------------
+static void buildListedSlots(int begin, int end, int worker) {
+    for (int i = begin; i < end; i++) buildRouteSlot(RouteBuildList[i], worker);
+}
+
+// ----------------------------------------------------------------------------
+// Table lookup for one slot, built first if it is stale.
+// ----------------------------------------------------------------------------
+static int lookupRoute(int slot, int r, int c, int dir) {
+    if (!isInBounds(r, c) || dir < 0 || dir > 3) return ROUTE_UNREACHABLE;
+    if (!RouteGraphValid) buildRouteGraph();
+    int cell = RouteCellId[r][c];
+    if (cell < 0 || slot >= RouteTableSlots) return ROUTE_UNREACHABLE;
+    if (RouteSlotReady[slot] != 1) buildRouteSlot(slot, 0); // Calling thread
+    unsigned short d = RouteTable[(long)slot * RouteNumStates + cell * 4 + dir];
+    return d == ROUTE_FAR ? ROUTE_UNREACHABLE : d;
+}
+
+// ----------------------------------------------------------------------------
+// INVALIDATE / PRECOMPUTE
+// ----------------------------------------------------------------------------
+void invalidateRoutes() {
+    RouteGraphValid = false;
+}
+
+// A slot is unchanged by the switch if, at each of its cells, both exits of
+// every entry are equally far: the entering state's distance is then the same
+// either way, and so is everything routed through it.
+void invalidateSwitchRoutes(int idx) {
+    if (!RouteGraphValid || idx < 0 || idx >= MAX_SWITCHES) return;
+    for (int slot = 0; slot < RouteTableSlots; slot++) {
+        if (RouteSlotReady[slot] != 1) continue;
+        const unsigned short* dist = RouteTable + (long)slot * RouteNumStates;
+        for (int i = RouteSwitchStart[idx]; i < RouteSwitchStart[idx + 1]; i++) {
+            int base = RouteSwitchCell[i] * 4;
+            for (int d = 0; d < 4; d++) {
+                if (RouteSwitchEntry[i][d] < 0) continue;
+                if (dist[base + d] != dist[base + RouteSwitchTurn[i][d]]) RouteSlotReady[slot] = 0;
+            }
+        }
+    }
+}
+
+// Lists slot for the next build unless it is ready or listed already.
+static void listRouteSlot(int slot, int& count) {
+    if (RouteSlotReady[slot] != 0) return;
+    RouteSlotReady[slot] = 2;
+    RouteBuildList[count++] = slot;
+}
+
+// Only "any D" and the destinations of running trains; other slots wait for
+// their first lookup.
+void precomputeRoutes() {
+    if (!RouteGraphValid) buildRouteGraph();
+    int count = 0;
+    listRouteSlot(0, count);
+    for (int k = 0; k < ActiveTrainCount; k++) {
+        int t = ActiveTrainList[k];
+        if (TrainDestRow[t] < 0) continue;
+        listRouteSlot(1 + RouteDestId[TrainDestRow[t]][TrainDestCol[t]], count);
+    }
+    if (count == 0) return;
+    int grain = ((long)count * RouteNumStates < ROUTE_SERIAL_WORK) ? count : 1;
+    parallelFor(count, getPoolGrain(grain), buildListedSlots);
+}
+
+// ----------------------------------------------------------------------------
+// GET ROUTE DISTANCE
+// ----------------------------------------------------------------------------
+int getRouteDistance(int r, int c, int dir) {
+    return lookupRoute(0, r, c, dir);
+}
+
+int getTrainRouteDistance(int trainId, int r, int c, int dir) {
+    int slot = 0;
+    if (TrainDestRow[trainId] >= 0) {
+        if (!RouteGraphValid) buildRouteGraph();
+        slot = 1 + RouteDestId[TrainDestRow[trainId]][TrainDestCol[trainId]];
+    }
+    return lookupRoute(slot, r, c, dir);
+}
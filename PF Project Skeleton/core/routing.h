@@ -0,0 +1,46 @@
+#ifndef ROUTING_H
+#define ROUTING_H
+
+// ============================================================================
+// ROUTING.H - Shortest paths on the track graph
+// ============================================================================
+// For every (cell, direction) a train can be in, the number of ticks it needs
+// to reach a 'D' tile when following the track: curves, the current switch
+// states (with queued flips already applied) and the best exit at each '+'.
+//
+// There is one table for "any D" and one per 'D' tile, for trains that have
+// their own destination. Tables only cover track cells and store 16-bit
+// distances, so hundreds of destinations fit on a 100x100 map. Each is one
+// backwards BFS, built on its first lookup and cached so later lookups are
+// O(1). A tile edit makes every table stale; a switch change only the tables
+// whose routes it can alter. Destinations no train is heading for are never
+// built.
+// ============================================================================
+
+// Distance returned when no destination can be reached
+#define ROUTE_UNREACHABLE 1000000
+
+// ----------------------------------------------------------------------------
+// CACHE
+// ----------------------------------------------------------------------------
+// Mark every table stale (tile edited, level loaded, state restored).
+void invalidateRoutes();
+
+// Switch idx changed state, or a flip of it was queued or dropped.
+void invalidateSwitchRoutes(int idx);
+
+// Build the stale tables running trains use ("any D" and their own
+// destinations) now, spread over the thread pool. Lookups from pool workers
+// must not build, so call this before sharing out a loop that routes.
+void precomputeRoutes();
+
+// ----------------------------------------------------------------------------
+// QUERIES
+// ----------------------------------------------------------------------------
+// Ticks to the nearest 'D' for a train standing on (r, c) facing dir.
+int getRouteDistance(int r, int c, int dir);
+
+// Ticks to train trainId's own destination (any 'D' if it has none).
+int getTrainRouteDistance(int trainId, int r, int c, int dir);
+
+#endif
@@ -3,6 +3,11 @@
 #include "trains.h"
 #include "switches.h"
 #include "io.h"
+#include "heatmap.h"
+#include "state_hash.h"
+#include "cycle.h"
+#include "routing.h"
+#include "regions.h"
 #include <cstdlib>
 #include <ctime>
 
@@ -10,13 +15,69 @@
 // SIMULATION.CPP - Implementation of main simulation logic
 // ============================================================================
 
+// ----------------------------------------------------------------------------
+// TRACE EVENTS
+// ----------------------------------------------------------------------------
+// What trace.csv last said about each train, for the "events" log level.
+// ----------------------------------------------------------------------------
+static int TraceLoggedState[MAX_TRAINS];
+static int TraceLoggedDir[MAX_TRAINS];
+static int TraceListBuilds = -1;   // getTrainListBuilds() at the last event check
+
+// ----------------------------------------------------------------------------
+// Logs train i if its state or direction differs from what was logged.
+// ----------------------------------------------------------------------------
+static void logTrainEvent(int i) {
+    static const char* stateNames[4] = { "SCHEDULED", "RUNNING", "ARRIVED", "CRASHED" };
+    int state = TrainState[i];
+    if (state == TraceLoggedState[i] && (state != 1 || TrainCurrentDir[i] == TraceLoggedDir[i])) return;
+    logTrainTrace(CurrentTick, i, TrainCurrentCol[i], TrainCurrentRow[i],
+                  TrainCurrentDir[i], stateNames[state]);
+    TraceLoggedState[i] = state;
+    TraceLoggedDir[i] = TrainCurrentDir[i];
+}
+
+// ----------------------------------------------------------------------------
+// Logs spawns, turns, arrivals and crashes only. From one tick to the next
+// only running trains and trains that just finished can change, visited in
+// index order; after a load or restore every train is checked.
+// ----------------------------------------------------------------------------
+static void logTrainEvents() {
+    if (TraceListBuilds != getTrainListBuilds()) {
+        TraceListBuilds = getTrainListBuilds();
+        for (int i = 0; i < TotalScheduledTrains; i++) logTrainEvent(i);
+        return;
+    }
+    int a = 0, f = 0;
+    while (a < ActiveTrainCount || f < FinishedTrainCount) {
+        if (f >= FinishedTrainCount || (a < ActiveTrainCount && ActiveTrainList[a] < FinishedTrainList[f])) {
+            logTrainEvent(ActiveTrainList[a++]);
+        } else {
+            logTrainEvent(FinishedTrainList[f++]);
+        }
+    }
+}
+
 // ----------------------------------------------------------------------------
 // INITIALIZE SIMULATION
 // ----------------------------------------------------------------------------
 
 void initializeSimulation() {
     initializeLogFiles();
+    for (int i = 0; i < MAX_TRAINS; i++) {
+        TraceLoggedState[i] = 0;
+        TraceLoggedDir[i] = -1;
+    }
+    TraceListBuilds = -1;
     CurrentTick = 0;
+    initializeHeatmap();
+    rebuildTrainLists();
+    rebuildHaltIndex();
+    initializeStateHash();
+    initializeCycleDetection();
+    invalidateRoutes();
+    precomputeRoutes();
+    invalidateSignalLights();
     updateSignalLights();
 }
 
@@ -27,7 +88,8 @@ void initializeSimulation() {
 void simulateOneTick() {
    spawnTrainsForTick();
    
-   determineAllRoutes();
+   // Routes, halts, weather and collisions, region by region
+   planTrainMoves();
    
    moveAllTrains();
    
@@ -38,21 +100,19 @@ void simulateOneTick() {
    applyDeferredFlips();
 
    checkArrivals();
+
+   updateEmergencyHalt();
    
    updateSignalLights();
-   for (int i = 0; i < TotalScheduledTrains; i++) {
-        if (TrainState[i] == 1) { // 1 = Active
-            const char* stateStr = "RUNNING";
-            logTrainTrace(CurrentTick, i, 
-                          TrainCurrentCol[i], 
-                          TrainCurrentRow[i], 
-                          TrainCurrentDir[i], 
-                          stateStr);
-        }
-        else if (TrainState[i] == 2) {
-        }
-    }
+   if (isLogTick(LOG_STREAM_TRACE, CurrentTick)) {
+    logTrainTraceRows(CurrentTick, ActiveTrainList, ActiveTrainCount);
+   } else if (LogLevel[LOG_STREAM_TRACE] == LOG_EVENTS) {
+    logTrainEvents();
+   }
+    if (isLogTick(LOG_STREAM_HASH, CurrentTick)) logStateHash(CurrentTick, getStateHash());
     CurrentTick++;
+    advanceHeatmapTick();
+    updateCycleDetection();
 }
 
 // ----------------------------------------------------------------------------
@@ -60,10 +120,7 @@ void simulateOneTick() {
 // ----------------------------------------------------------------------------
 
 bool isSimulationComplete() {
-    for(int i=0; i< TotalScheduledTrains; i++) {
-        if(TrainState[i] == 0 || TrainState[i] == 1) {
-         return false;
-        }
-    }
- return true;
+    // Trains stuck in a repeating state will never finish
+    if (isLivelocked()) return true;
+    return ActiveTrainCount == 0 && getWaitingTrainCount() == 0;
 }
\ No newline at end of file
@@ -20,7 +20,7 @@ void initializeSimulation();
 // ----------------------------------------------------------------------------
 // UTILITY
 // ----------------------------------------------------------------------------
-// True if all trains are delivered or crashed.
+// True if all trains are delivered or crashed, or the run is livelocked.
 bool isSimulationComplete();
 
 #endif
@@ -10,7 +10,17 @@
 // ----------------------------------------------------------------------------
 int LevelNumRows = 0;
 int LevelNumCols = 0;
-char TheGrid[MAX_ROWS][MAX_COLS];
+short GridChunkDir[GRID_CHUNK_ROWS][GRID_CHUNK_COLS];
+unsigned char (*GridChunks)[GRID_CHUNK_BYTES] = NULL;
+int GridChunkRow[GRID_MAX_CHUNKS];
+int GridChunkCol[GRID_MAX_CHUNKS];
+int GridChunkCount = 0;
+unsigned char GridDetailRow[MAX_ROWS];
+unsigned char (*GridDetail)[MAX_COLS] = NULL;
+int GridDetailRowsUsed = 0;
+short GridChunkSwitches[GRID_MAX_CHUNKS];
+short (*GridSwitchIds)[GRID_CHUNK * GRID_CHUNK] = NULL;
+int GridSwitchBlocksUsed = 0;
 
 // ----------------------------------------------------------------------------
 // TRAINS
@@ -21,6 +31,8 @@ int TrainStartCol[MAX_TRAINS];
 int TrainStartRow[MAX_TRAINS];
 int TrainStartDir[MAX_TRAINS];
 int TrainColorCode[MAX_TRAINS];
+int TrainDestRow[MAX_TRAINS];
+int TrainDestCol[MAX_TRAINS];
 bool TrainIsActive[MAX_TRAINS];
 int TrainCurrentCol[MAX_TRAINS];
 int TrainCurrentRow[MAX_TRAINS];
@@ -29,6 +41,10 @@ int TrainNextCol[MAX_TRAINS];
 int TrainNextRow[MAX_TRAINS];
 int TrainNextDir[MAX_TRAINS];
 int TrainState[MAX_TRAINS];
+int ActiveTrainList[MAX_TRAINS];
+int ActiveTrainCount = 0;
+int FinishedTrainList[MAX_TRAINS];
+int FinishedTrainCount = 0;
 
 
 
@@ -36,12 +52,17 @@ int TrainState[MAX_TRAINS];
 // ----------------------------------------------------------------------------
 // SWITCHES
 // ----------------------------------------------------------------------------
+int SwitchCount = SWITCH_LETTERS;
+char SwitchName[MAX_SWITCHES][SWITCH_NAME_LENGTH];
 bool SwitchExists[MAX_SWITCHES];
 int SwitchCurrentState[MAX_SWITCHES];
 int SwitchLogicMode[MAX_SWITCHES];
 int SwitchFlipThresholds[MAX_SWITCHES][4];
 int SwitchCounters[MAX_SWITCHES][4];
 bool SwitchFlipQueue[MAX_SWITCHES];
+int SwitchRow[MAX_SWITCHES];
+int SwitchCol[MAX_SWITCHES];
+int SwitchSignal[MAX_SWITCHES];
 // ----------------------------------------------------------------------------
 // SPAWN AND DESTINATION POINTS
 // ----------------------------------------------------------------------------
@@ -49,6 +70,7 @@ bool SwitchFlipQueue[MAX_SWITCHES];
 // ----------------------------------------------------------------------------
 // SIMULATION PARAMETERS
 // ----------------------------------------------------------------------------
+char LevelName[MAX_NAME_LENGTH];
 int GameSeed = 0;
 int GameWeather = 0;
 int CurrentTick = 0;
@@ -59,6 +81,16 @@ int CurrentTick = 0;
 // ----------------------------------------------------------------------------
 // EMERGENCY HALT
 // ----------------------------------------------------------------------------
+bool HaltZoneActive[MAX_HALT_ZONES];
+int HaltZoneTop[MAX_HALT_ZONES];
+int HaltZoneLeft[MAX_HALT_ZONES];
+int HaltZoneBottom[MAX_HALT_ZONES];
+int HaltZoneRight[MAX_HALT_ZONES];
+int HaltZoneCenterRow[MAX_HALT_ZONES];
+int HaltZoneCenterCol[MAX_HALT_ZONES];
+int HaltZoneRadius[MAX_HALT_ZONES];
+int HaltZoneTimer[MAX_HALT_ZONES];
+int ActiveHaltZones = 0;
 
 // ============================================================================
 // INITIALIZE SIMULATION STATE
@@ -72,17 +104,68 @@ void initializeSimulationState() {
     LevelNumRows = 0;
     LevelNumCols = 0;
     TotalScheduledTrains = 0;
+    ActiveTrainCount = 0;
+    FinishedTrainCount = 0;
+    LevelName[0] = '\0';
     GameSeed = 0;
     GameWeather = WEATHER_NORMAL;
     CurrentTick = 0;
     
-    // Clears the Map
+    // Trains (a level loaded after another must not inherit its runs)
+    for (int i = 0; i < MAX_TRAINS; i++) {
+        TrainSpawnTicks[i] = 0;
+        TrainStartCol[i] = 0;
+        TrainStartRow[i] = 0;
+        TrainStartDir[i] = 0;
+        TrainColorCode[i] = 0;
+        TrainDestRow[i] = -1;
+        TrainDestCol[i] = -1;
+        TrainIsActive[i] = false;
+        TrainCurrentCol[i] = 0;
+        TrainCurrentRow[i] = 0;
+        TrainCurrentDir[i] = 0;
+        TrainNextCol[i] = 0;
+        TrainNextRow[i] = 0;
+        TrainNextDir[i] = 0;
+        TrainState[i] = 0;
+    }
+
+    ActiveHaltZones = 0;
+    for (int z = 0; z < MAX_HALT_ZONES; z++) {
+        HaltZoneActive[z] = false;
+        HaltZoneTop[z] = 0;
+        HaltZoneLeft[z] = 0;
+        HaltZoneBottom[z] = 0;
+        HaltZoneRight[z] = 0;
+        HaltZoneCenterRow[z] = 0;
+        HaltZoneCenterCol[z] = 0;
+        HaltZoneRadius[z] = 0;
+        HaltZoneTimer[z] = 0;
+    }
+
+    // Clears the Map (no chunks; class 0 = TILE_VOID)
+    memset(GridChunkDir, 0xFF, sizeof(GridChunkDir));
+    memset(GridChunkRow, 0, sizeof(GridChunkRow));
+    memset(GridChunkCol, 0, sizeof(GridChunkCol));
+    GridChunkCount = 0; // Slots stay allocated for the next level
+    memset(GridDetailRow, 0, sizeof(GridDetailRow));
+    GridDetailRowsUsed = 0; // Detail rows stay allocated for the next level
+    memset(GridChunkSwitches, 0, sizeof(GridChunkSwitches));
+    GridSwitchBlocksUsed = 0; // Blocks stay allocated for the next level
+    SwitchCount = SWITCH_LETTERS;
   for (int i = 0; i < MAX_SWITCHES; i++) {
+        memset(SwitchName[i], 0, SWITCH_NAME_LENGTH);
+        if (i < SWITCH_LETTERS) SwitchName[i][0] = (char)('A' + i);
         SwitchExists[i] = false;
         SwitchCurrentState[i] = 0;
         SwitchLogicMode[i] = 0;
+        SwitchFlipQueue[i] = false;
+        SwitchRow[i] = -1;
+        SwitchCol[i] = -1;
+        SwitchSignal[i] = SIGNAL_NONE;
         for (int k = 0; k < 4; k++) {
             SwitchFlipThresholds[i][k] = 0;
+            SwitchCounters[i][k] = 0;
         }
     }
 }
@@ -9,7 +9,7 @@
 #define MAX_ROWS 100
 #define MAX_COLS 100
 #define MAX_TRAINS 100
-#define MAX_SWITCHES 26
+#define MAX_SWITCHES 4096
 
 // DIRECTIONS
 #define DIR_UP    0
@@ -21,6 +21,8 @@
 #define WEATHER_NORMAL 0
 #define WEATHER_RAIN   1
 #define WEATHER_FOG    2
+#define RAIN_SLIP_CHANCE   5  // RAIN: a train loses about 1 move in 5
+#define FOG_CAUTION_CHANCE 3  // FOG: 1 in 3 waits before a switch or crossing
 
 // SWITCH MODES
 #define MODE_PER_DIR 0
@@ -28,9 +30,34 @@
 // ----------------------------------------------------------------------------
 // GRID CONSTANTS
 // ----------------------------------------------------------------------------
+// The map is stored packed (see grid.h for getTile / setTile): a 4-bit tile
+// class per cell, two cells per byte, in 32x32 chunks. A chunk gets a slot,
+// allocated then, only once it holds something other than ' '; the directory
+// maps chunk coordinates to slots (-1 = all empty). Other symbols need their
+// character, which is kept in a pool of detail rows that only map rows
+// holding such cells get. Switch cells instead hold the index of their switch
+// in a block of switch IDs, which only slots holding a switch cell get.
+// ----------------------------------------------------------------------------
+#define GRID_CHUNK_SHIFT 5
+#define GRID_CHUNK (1 << GRID_CHUNK_SHIFT)      // Cells per chunk side
+#define GRID_CHUNK_BYTES (GRID_CHUNK * GRID_CHUNK / 2)
+#define GRID_CHUNK_ROWS ((MAX_ROWS + GRID_CHUNK - 1) / GRID_CHUNK)
+#define GRID_CHUNK_COLS ((MAX_COLS + GRID_CHUNK - 1) / GRID_CHUNK)
+#define GRID_MAX_CHUNKS (GRID_CHUNK_ROWS * GRID_CHUNK_COLS)
+
 extern int LevelNumRows;              
 extern int LevelNumCols;              
-extern char TheGrid[MAX_ROWS][MAX_COLS]; 
+extern short GridChunkDir[GRID_CHUNK_ROWS][GRID_CHUNK_COLS];   // Slot of each chunk
+extern unsigned char (*GridChunks)[GRID_CHUNK_BYTES];          // Slots, grown on demand
+extern int GridChunkRow[GRID_MAX_CHUNKS];                      // Chunk coordinates of each slot
+extern int GridChunkCol[GRID_MAX_CHUNKS];
+extern int GridChunkCount;
+extern unsigned char GridDetailRow[MAX_ROWS];                  // Detail row + 1 (0 = none)
+extern unsigned char (*GridDetail)[MAX_COLS];                  // Detail rows, grown on demand
+extern int GridDetailRowsUsed;
+extern short GridChunkSwitches[GRID_MAX_CHUNKS];               // Switch ID block + 1 of each slot (0 = none)
+extern short (*GridSwitchIds)[GRID_CHUNK * GRID_CHUNK];        // Blocks, grown on demand (-1 = no switch)
+extern int GridSwitchBlocksUsed;
 
 // ----------------------------------------------------------------------------
 // TRAIN CONSTANTS
@@ -41,6 +68,8 @@ extern int TrainStartCol[MAX_TRAINS];
 extern int TrainStartRow[MAX_TRAINS];    
 extern int TrainStartDir[MAX_TRAINS];    
 extern int TrainColorCode[MAX_TRAINS];   
+extern int TrainDestRow[MAX_TRAINS];     // Assigned 'D' tile (-1 = any destination)
+extern int TrainDestCol[MAX_TRAINS];
 extern bool TrainIsActive[MAX_TRAINS];   
 extern int TrainCurrentCol[MAX_TRAINS];
 extern int TrainCurrentRow[MAX_TRAINS];
@@ -50,19 +79,43 @@ extern int TrainNextRow[MAX_TRAINS];
 extern int TrainNextDir[MAX_TRAINS];
 extern int TrainState[MAX_TRAINS]; // 0 for scheduled 1 for active 2 for arrived 3 for crashed
 
+// Running trains (TrainState 1) in index order, so the phases of a tick only
+// go through trains on the track. Kept up to date by spawnTrainsForTick()
+// and checkArrivals(); rebuildTrainLists() (trains.h) recomputes it after a
+// level load or snapshot restore.
+extern int ActiveTrainList[MAX_TRAINS];
+extern int ActiveTrainCount;
+// Trains that arrived or crashed in the last checkArrivals(), in index order
+extern int FinishedTrainList[MAX_TRAINS];
+extern int FinishedTrainCount;
+
 // ----------------------------------------------------------------------------
 // SWITCH CONSTANTS
 // ----------------------------------------------------------------------------
+// Switches 0-25 are the letters A-Z, written as that letter on the map.
+// Named switches (any other name in the SWITCHES: section) follow from 26 in
+// the order the level lists them; each sits on one '@' map cell. Entries
+// 0 .. SwitchCount - 1 are in use.
+// ----------------------------------------------------------------------------
+#define SWITCH_LETTERS 26
+#define SWITCH_NAME_LENGTH 16   // Longest name + 1
+#define SWITCH_NAMED_TILE '@'   // Map character of a named switch cell
+extern int SwitchCount;
+extern char SwitchName[MAX_SWITCHES][SWITCH_NAME_LENGTH];
 extern bool SwitchExists[MAX_SWITCHES];       
 extern int SwitchCurrentState[MAX_SWITCHES];  //(0 or 1)
 extern int SwitchLogicMode[MAX_SWITCHES];    //(0=PerDir, 1=Global)
 extern int SwitchFlipThresholds[MAX_SWITCHES][4]; 
 extern int SwitchCounters[MAX_SWITCHES][4];
 extern bool SwitchFlipQueue[MAX_SWITCHES];
+extern int SwitchRow[MAX_SWITCHES];  // First map cell of the switch (-1 if not on map)
+extern int SwitchCol[MAX_SWITCHES];
 
 // ----------------------------------------------------------------------------
 // WEATHER CONSTANTS
 // ----------------------------------------------------------------------------
+#define MAX_NAME_LENGTH 128
+extern char LevelName[MAX_NAME_LENGTH]; // NAME: line of the level file
 extern int GameSeed;      
 extern int GameWeather;
 extern int CurrentTick;    
@@ -70,7 +123,10 @@ extern int CurrentTick;
 // ----------------------------------------------------------------------------
 // SIGNAL CONSTANTS
 // ----------------------------------------------------------------------------
-
+#define SIGNAL_NONE  -1
+#define SIGNAL_GREEN  0
+#define SIGNAL_RED    1
+extern int SwitchSignal[MAX_SWITCHES]; // Colour set by the last updateSignalLights()
 
 
 
@@ -85,7 +141,7 @@ extern int CurrentTick;
 
 
 // ----------------------------------------------------------------------------
-// GLOBAL STATE: SWITCHES (A-Z mapped to 0-25)
+// GLOBAL STATE: SWITCHES (A-Z mapped to 0-25, named ones after)
 // ----------------------------------------------------------------------------
 
 
@@ -112,6 +168,21 @@ extern int CurrentTick;
 // ----------------------------------------------------------------------------
 // GLOBAL STATE: EMERGENCY HALT
 // ----------------------------------------------------------------------------
+// Operator halt zones. Trains inside an active zone do not move until its
+// timer runs out. A zone is a rectangle (HaltZoneRadius < 0) or the cells
+// within HaltZoneRadius of a center tile; Top/Left/Bottom/Right is always
+// its bounding box.
+#define MAX_HALT_ZONES 256
+extern bool HaltZoneActive[MAX_HALT_ZONES];
+extern int HaltZoneTop[MAX_HALT_ZONES];
+extern int HaltZoneLeft[MAX_HALT_ZONES];
+extern int HaltZoneBottom[MAX_HALT_ZONES];
+extern int HaltZoneRight[MAX_HALT_ZONES];
+extern int HaltZoneCenterRow[MAX_HALT_ZONES];
+extern int HaltZoneCenterCol[MAX_HALT_ZONES];
+extern int HaltZoneRadius[MAX_HALT_ZONES];   // -1 = rectangle
+extern int HaltZoneTimer[MAX_HALT_ZONES];    // Ticks left
+extern int ActiveHaltZones;
 
 
 // ----------------------------------------------------------------------------
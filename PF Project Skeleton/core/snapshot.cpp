@@ -0,0 +1,330 @@
+#include "snapshot.h"
+#include "simulation_state.h"
+#include "state_hash.h"
+#include "routing.h"
+#include "trains.h"
+#include "grid.h"
+#include "switches.h"
+#include <cstring>
+
+// ============================================================================
+// SNAPSHOT.CPP - Save / restore the whole simulation state
+// ============================================================================
+
+// WALK MODES
+#define SNAP_SIZE    0
+#define SNAP_SAVE    1
+#define SNAP_RESTORE 2
+#define SNAP_COMPARE 3
+#define SNAP_CHECK   4
+
+// SNAP_CHECK reads only the buffer, and never past CheckEnd
+static int CheckEnd = 0;
+static bool CheckFailed = false;
+
+// ----------------------------------------------------------------------------
+// Copies or compares one field at offset and advances the offset.
+// Returns false only when comparing and the field differs.
+// ----------------------------------------------------------------------------
+static bool walkField(unsigned char* buffer, int& offset, void* field, int size, int mode) {
+    bool same = true;
+    if (mode == SNAP_CHECK && offset + size > CheckEnd) CheckFailed = true;
+    if (mode == SNAP_SAVE) memcpy(buffer + offset, field, size);
+    else if (mode == SNAP_RESTORE) memcpy(field, buffer + offset, size);
+    else if (mode == SNAP_COMPARE) same = memcmp(buffer + offset, field, size) == 0;
+    offset += size;
+    return same;
+}
+
+// ----------------------------------------------------------------------------
+// Same for the first used entries of a table (the rest are not in use and
+// take no room). The count must be walked before the table.
+// ----------------------------------------------------------------------------
+static bool walkTable(unsigned char* buffer, int& offset, void* table, int entrySize,
+                      int used, int mode) {
+    if (used == 0) return true;
+    return walkField(buffer, offset, table, entrySize * used, mode);
+}
+
+// ----------------------------------------------------------------------------
+// Walks a count that sizes later tables. Returns it (as stored in the buffer
+// when restoring, comparing or checking), or -1 if it is outside [0, limit]
+// or differs from the current one when comparing.
+// ----------------------------------------------------------------------------
+static int walkCount(unsigned char* buffer, int& offset, int* count, int limit, int mode) {
+    int value = *count;
+    if (mode == SNAP_CHECK && offset + (int)sizeof(int) > CheckEnd) {
+        CheckFailed = true;
+        return -1;
+    }
+    if (mode == SNAP_SAVE) memcpy(buffer + offset, count, sizeof(int));
+    else if (mode != SNAP_SIZE) memcpy(&value, buffer + offset, sizeof(int));
+    offset += sizeof(int);
+    if (value < 0 || value > limit) return -1;
+    if (mode == SNAP_COMPARE && value != *count) return -1;
+    if (mode == SNAP_RESTORE) *count = value;
+    return value;
+}
+
+// ----------------------------------------------------------------------------
+// SNAP_CHECK: whether every entry of the table just walked from start (count
+// entries of 1 unsigned, or 2 or 4 signed bytes) lies in [low, high].
+// ----------------------------------------------------------------------------
+static bool checkEntries(const unsigned char* buffer, int start, int entrySize, int count,
+                         int low, int high) {
+    if (CheckFailed) return false;
+    for (int k = 0; k < count; k++) {
+        const unsigned char* at = buffer + start + k * entrySize;
+        int value;
+        if (entrySize == 1) {
+            value = *at;
+        } else if (entrySize == 2) {
+            short entry;
+            memcpy(&entry, at, sizeof(entry));
+            value = entry;
+        } else {
+            memcpy(&value, at, sizeof(value));
+        }
+        if (value < low || value > high) return false;
+    }
+    return true;
+}
+
+// SNAP_CHECK: whether each of count strings of length bytes from start ends
+// in a '\0'.
+static bool checkStrings(const unsigned char* buffer, int start, int length, int count) {
+    if (CheckFailed) return false;
+    for (int k = 0; k < count; k++) {
+        if (!memchr(buffer + start + k * length, '\0', length)) return false;
+    }
+    return true;
+}
+
+// SNAP_CHECK: whether every cell of the chunk slots (tables from the given
+// offsets) has a known class, and the storage getTile reads for it: a switch
+// ID block for a switch, a detail row for another symbol.
+static bool checkChunkCells(const unsigned char* buffer, int packed, int chunkRows,
+                            int detailRows, int blocks, int chunks) {
+    if (CheckFailed) return false;
+    for (int k = 0; k < chunks; k++) {
+        int chunkRow;
+        short block;
+        memcpy(&chunkRow, buffer + chunkRows + k * sizeof(int), sizeof(int));
+        memcpy(&block, buffer + blocks + k * sizeof(short), sizeof(short));
+        for (int cell = 0; cell < GRID_CHUNK * GRID_CHUNK; cell++) {
+            int tileClass = (buffer[packed + k * GRID_CHUNK_BYTES + (cell >> 1)] >> ((cell & 1) << 2)) & 0x0F;
+            int r = (chunkRow << GRID_CHUNK_SHIFT) + (cell >> GRID_CHUNK_SHIFT);
+            if (tileClass > TILE_OTHER) return false;
+            if (tileClass == TILE_SWITCH && block == 0) return false;
+            if (tileClass == TILE_OTHER && (r >= MAX_ROWS || buffer[detailRows + r] == 0)) return false;
+        }
+    }
+    return true;
+}
+
+// SNAP_CHECK: whether the boxes of the active halt zones, whose tables start
+// at the given offsets, lie on the map (the halt index has a bucket per cell).
+static bool checkHaltZones(const unsigned char* buffer, int active, int top, int left,
+                           int bottom, int right) {
+    if (CheckFailed) return false;
+    for (int z = 0; z < MAX_HALT_ZONES; z++) {
+        unsigned char on = buffer[active + z * sizeof(bool)];
+        if (on > 1) return false;
+        if (!on) continue;
+        int at = z * sizeof(int);
+        if (!checkEntries(buffer, top + at, sizeof(int), 1, 0, MAX_ROWS - 1) ||
+            !checkEntries(buffer, bottom + at, sizeof(int), 1, 0, MAX_ROWS - 1) ||
+            !checkEntries(buffer, left + at, sizeof(int), 1, 0, MAX_COLS - 1) ||
+            !checkEntries(buffer, right + at, sizeof(int), 1, 0, MAX_COLS - 1)) return false;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Visits every field in a fixed order, after the snapshot's size (written
+// when saving). The tick comes first so that SNAP_COMPARE can skip it.
+// Counts come before the tables they size, so SNAP_CHECK can test each one
+// against its capacity and the tables indexed by the others against them.
+// Returns the number of bytes walked, or -1 if a compared field differs or a
+// checked count or index is out of range.
+// ----------------------------------------------------------------------------
+static int walkSnapshot(unsigned char* buffer, int mode) {
+    // States of another size differ in a count, and their tables do not line up
+    if (mode == SNAP_COMPARE && getSnapshotBytes(buffer) != getSnapshotSize()) return -1;
+
+    int offset = sizeof(int);
+    int tickMode = (mode == SNAP_COMPARE) ? SNAP_SIZE : mode;
+    walkField(buffer, offset, &CurrentTick, sizeof(CurrentTick), tickMode);
+
+    bool same = true;
+    bool check = mode == SNAP_CHECK;
+    int start;
+    // Grid (sizes first)
+    if (walkCount(buffer, offset, &LevelNumRows, MAX_ROWS, mode) < 0) return -1;
+    if (walkCount(buffer, offset, &LevelNumCols, MAX_COLS, mode) < 0) return -1;
+    int chunks = walkCount(buffer, offset, &GridChunkCount, GRID_MAX_CHUNKS, mode);
+    int details = walkCount(buffer, offset, &GridDetailRowsUsed, MAX_ROWS, mode);
+    int blocks = walkCount(buffer, offset, &GridSwitchBlocksUsed, GRID_MAX_CHUNKS, mode);
+    int switches = walkCount(buffer, offset, &SwitchCount, MAX_SWITCHES, mode);
+    if (chunks < 0 || details < 0 || blocks < 0 || switches < 0) return -1;
+    if (mode == SNAP_RESTORE) {
+        reserveChunkSlots(chunks);
+        reserveDetailRows(details);
+        reserveSwitchBlocks(blocks);
+    }
+
+    start = offset;
+    same = walkField(buffer, offset, GridChunkDir, sizeof(GridChunkDir), mode) && same;
+    if (check && !checkEntries(buffer, start, sizeof(short), GRID_CHUNK_ROWS * GRID_CHUNK_COLS, -1, chunks - 1)) return -1;
+    int packed = offset;
+    same = walkTable(buffer, offset, GridChunks, sizeof(GridChunks[0]), chunks, mode) && same;
+    int chunkRows = offset;
+    same = walkTable(buffer, offset, GridChunkRow, sizeof(GridChunkRow[0]), chunks, mode) && same;
+    if (check && !checkEntries(buffer, chunkRows, sizeof(int), chunks, 0, GRID_CHUNK_ROWS - 1)) return -1;
+    start = offset;
+    same = walkTable(buffer, offset, GridChunkCol, sizeof(GridChunkCol[0]), chunks, mode) && same;
+    if (check && !checkEntries(buffer, start, sizeof(int), chunks, 0, GRID_CHUNK_COLS - 1)) return -1;
+    int detailRows = offset;
+    same = walkField(buffer, offset, GridDetailRow, sizeof(GridDetailRow), mode) && same;
+    if (check && !checkEntries(buffer, detailRows, sizeof(GridDetailRow[0]), MAX_ROWS, 0, details)) return -1;
+    same = walkTable(buffer, offset, GridDetail, sizeof(GridDetail[0]), details, mode) && same;
+    int chunkBlocks = offset;
+    same = walkTable(buffer, offset, GridChunkSwitches, sizeof(GridChunkSwitches[0]), chunks, mode) && same;
+    if (check && !checkEntries(buffer, chunkBlocks, sizeof(short), chunks, 0, blocks)) return -1;
+    if (check && !checkChunkCells(buffer, packed, chunkRows, detailRows, chunkBlocks, chunks)) return -1;
+    start = offset;
+    same = walkTable(buffer, offset, GridSwitchIds, sizeof(GridSwitchIds[0]), blocks, mode) && same;
+    if (check && !checkEntries(buffer, start, sizeof(short), blocks * GRID_CHUNK * GRID_CHUNK, -1, switches - 1)) return -1;
+    start = offset;
+    same = walkField(buffer, offset, LevelName, sizeof(LevelName), mode) && same;
+    if (check && !checkStrings(buffer, start, sizeof(LevelName), 1)) return -1;
+    same = walkField(buffer, offset, &GameSeed, sizeof(GameSeed), mode) && same;
+    same = walkField(buffer, offset, &GameWeather, sizeof(GameWeather), mode) && same;
+
+    // Trains (positions may be one step off the map, never further)
+    int trains = walkCount(buffer, offset, &TotalScheduledTrains, MAX_TRAINS, mode);
+    if (trains < 0) return -1;
+    same = walkField(buffer, offset, TrainSpawnTicks, sizeof(TrainSpawnTicks), mode) && same;
+    start = offset;
+    same = walkField(buffer, offset, TrainStartCol, sizeof(TrainStartCol), mode) && same;
+    if (check && !checkEntries(buffer, start, sizeof(int), trains, 0, MAX_COLS - 1)) return -1;
+    start = offset;
+    same = walkField(buffer, offset, TrainStartRow, sizeof(TrainStartRow), mode) && same;
+    if (check && !checkEntries(buffer, start, sizeof(int), trains, 0, MAX_ROWS - 1)) return -1;
+    start = offset;
+    same = walkField(buffer, offset, TrainStartDir, sizeof(TrainStartDir), mode) && same;
+    if (check && !checkEntries(buffer, start, sizeof(int), trains, DIR_UP, DIR_LEFT)) return -1;
+    same = walkField(buffer, offset, TrainColorCode, sizeof(TrainColorCode), mode) && same;
+    start = offset;
+    same = walkField(buffer, offset, TrainDestRow, sizeof(TrainDestRow), mode) && same;
+    if (check && !checkEntries(buffer, start, sizeof(int), trains, -1, MAX_ROWS - 1)) return -1;
+    start = offset;
+    same = walkField(buffer, offset, TrainDestCol, sizeof(TrainDestCol), mode) && same;
+    if (check && !checkEntries(buffer, start, sizeof(int), trains, -1, MAX_COLS - 1)) return -1;
+    start = offset;
+    same = walkField(buffer, offset, TrainIsActive, sizeof(TrainIsActive), mode) && same;
+    if (check && !checkEntries(buffer, start, sizeof(bool), MAX_TRAINS, 0, 1)) return -1;
+    start = offset;
+    same = walkField(buffer, offset, TrainCurrentCol, sizeof(TrainCurrentCol), mode) && same;
+    if (check && !checkEntries(buffer, start, sizeof(int), trains, -1, MAX_COLS)) return -1;
+    start = offset;
+    same = walkField(buffer, offset, TrainCurrentRow, sizeof(TrainCurrentRow), mode) && same;
+    if (check && !checkEntries(buffer, start, sizeof(int), trains, -1, MAX_ROWS)) return -1;
+    start = offset;
+    same = walkField(buffer, offset, TrainCurrentDir, sizeof(TrainCurrentDir), mode) && same;
+    if (check && !checkEntries(buffer, start, sizeof(int), trains, DIR_UP, DIR_LEFT)) return -1;
+    start = offset;
+    same = walkField(buffer, offset, TrainNextCol, sizeof(TrainNextCol), mode) && same;
+    if (check && !checkEntries(buffer, start, sizeof(int), trains, -1, MAX_COLS)) return -1;
+    start = offset;
+    same = walkField(buffer, offset, TrainNextRow, sizeof(TrainNextRow), mode) && same;
+    if (check && !checkEntries(buffer, start, sizeof(int), trains, -1, MAX_ROWS)) return -1;
+    start = offset;
+    same = walkField(buffer, offset, TrainNextDir, sizeof(TrainNextDir), mode) && same;
+    if (check && !checkEntries(buffer, start, sizeof(int), trains, DIR_UP, DIR_LEFT)) return -1;
+    start = offset;
+    same = walkField(buffer, offset, TrainState, sizeof(TrainState), mode) && same;
+    if (check && !checkEntries(buffer, start, sizeof(int), trains, 0, 3)) return -1;
+
+    // Switches (their count came with the grid's)
+    int used = switches;
+    start = offset;
+    same = walkTable(buffer, offset, SwitchName, sizeof(SwitchName[0]), used, mode) && same;
+    if (check && !checkStrings(buffer, start, sizeof(SwitchName[0]), used)) return -1;
+    start = offset;
+    same = walkTable(buffer, offset, SwitchExists, sizeof(SwitchExists[0]), used, mode) && same;
+    if (check && !checkEntries(buffer, start, sizeof(bool), used, 0, 1)) return -1;
+    same = walkTable(buffer, offset, SwitchCurrentState, sizeof(SwitchCurrentState[0]), used, mode) && same;
+    same = walkTable(buffer, offset, SwitchLogicMode, sizeof(SwitchLogicMode[0]), used, mode) && same;
+    same = walkTable(buffer, offset, SwitchFlipThresholds, sizeof(SwitchFlipThresholds[0]), used, mode) && same;
+    same = walkTable(buffer, offset, SwitchCounters, sizeof(SwitchCounters[0]), used, mode) && same;
+    start = offset;
+    same = walkTable(buffer, offset, SwitchFlipQueue, sizeof(SwitchFlipQueue[0]), used, mode) && same;
+    if (check && !checkEntries(buffer, start, sizeof(bool), used, 0, 1)) return -1;
+    same = walkTable(buffer, offset, SwitchRow, sizeof(SwitchRow[0]), used, mode) && same;
+    same = walkTable(buffer, offset, SwitchCol, sizeof(SwitchCol[0]), used, mode) && same;
+    same = walkTable(buffer, offset, SwitchSignal, sizeof(SwitchSignal[0]), used, mode) && same;
+
+    // Emergency halt zones
+    int active = offset;
+    same = walkField(buffer, offset, HaltZoneActive, sizeof(HaltZoneActive), mode) && same;
+    int top = offset;
+    same = walkField(buffer, offset, HaltZoneTop, sizeof(HaltZoneTop), mode) && same;
+    int left = offset;
+    same = walkField(buffer, offset, HaltZoneLeft, sizeof(HaltZoneLeft), mode) && same;
+    int bottom = offset;
+    same = walkField(buffer, offset, HaltZoneBottom, sizeof(HaltZoneBottom), mode) && same;
+    int right = offset;
+    same = walkField(buffer, offset, HaltZoneRight, sizeof(HaltZoneRight), mode) && same;
+    if (check && !checkHaltZones(buffer, active, top, left, bottom, right)) return -1;
+    same = walkField(buffer, offset, HaltZoneCenterRow, sizeof(HaltZoneCenterRow), mode) && same;
+    same = walkField(buffer, offset, HaltZoneCenterCol, sizeof(HaltZoneCenterCol), mode) && same;
+    same = walkField(buffer, offset, HaltZoneRadius, sizeof(HaltZoneRadius), mode) && same;
+    same = walkField(buffer, offset, HaltZoneTimer, sizeof(HaltZoneTimer), mode) && same;
+    if (walkCount(buffer, offset, &ActiveHaltZones, MAX_HALT_ZONES, mode) < 0) return -1;
+
+    if (mode == SNAP_SAVE) memcpy(buffer, &offset, sizeof(offset));
+    if (check && (CheckFailed || offset != CheckEnd)) return -1;
+    return same ? offset : -1;
+}
+
+// ----------------------------------------------------------------------------
+// SNAPSHOT FUNCTIONS
+// ----------------------------------------------------------------------------
+int getSnapshotSize() {
+    return walkSnapshot(NULL, SNAP_SIZE);
+}
+
+int getSnapshotBytes(const unsigned char* buffer) {
+    int bytes;
+    memcpy(&bytes, buffer, sizeof(bytes));
+    return bytes;
+}
+
+void saveSnapshot(unsigned char* buffer) {
+    walkSnapshot(buffer, SNAP_SAVE);
+}
+
+bool isSnapshotValid(const unsigned char* buffer, int size) {
+    if (!buffer || size < (int)sizeof(int)) return false;
+    int bytes = getSnapshotBytes(buffer);
+    if (bytes < (int)sizeof(int) || bytes > size) return false;
+    CheckEnd = bytes;
+    CheckFailed = false;
+    // CHECK only reads from the buffer
+    return walkSnapshot(const_cast<unsigned char*>(buffer), SNAP_CHECK) == bytes;
+}
+
+void restoreSnapshot(const unsigned char* buffer) {
+    // RESTORE only reads from the buffer
+    walkSnapshot(const_cast<unsigned char*>(buffer), SNAP_RESTORE);
+    initializeStateHash();
+    invalidateRoutes();
+    rebuildHaltIndex();
+    rebuildTrainLists();
+    invalidateSignalLights();
+}
+
+bool sameStateAsSnapshot(const unsigned char* buffer) {
+    return walkSnapshot(const_cast<unsigned char*>(buffer), SNAP_COMPARE) >= 0;
+}
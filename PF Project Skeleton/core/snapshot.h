@@ -0,0 +1,39 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+// ============================================================================
+// SNAPSHOT.H - Save / restore the whole simulation state
+// ============================================================================
+// A snapshot is a flat byte buffer holding every global of
+// simulation_state.h (level, trains, switches, tick). Only the switches and
+// switch ID blocks in use are stored, so the size depends on the level; it
+// stays the same while a level runs, as only loading one changes those
+// counts. The caller owns the buffer; getSnapshotSize() tells how large it
+// has to be for the current state.
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// SNAPSHOTS
+// ----------------------------------------------------------------------------
+// Bytes needed for a snapshot of the current state.
+int getSnapshotSize();
+
+// Bytes of the snapshot saved in buffer.
+int getSnapshotBytes(const unsigned char* buffer);
+
+// Copy the current state into buffer.
+void saveSnapshot(unsigned char* buffer);
+
+// True if buffer (size bytes) holds a snapshot that can be restored: every
+// count within its table's capacity, every index within its table, and the
+// fields walked exactly filling the size stored in it. Reads only buffer.
+bool isSnapshotValid(const unsigned char* buffer, int size);
+
+// Make buffer the current state (also rebuilds the state hash). The buffer
+// must come from saveSnapshot or pass isSnapshotValid.
+void restoreSnapshot(const unsigned char* buffer);
+
+// True if the current state equals the snapshot, ignoring the tick number.
+bool sameStateAsSnapshot(const unsigned char* buffer);
+
+#endif
@@ -0,0 +1,109 @@
+#include "state_hash.h"
+#include "simulation_state.h"
+
+// ============================================================================
+// STATE_HASH.CPP - Incremental 64-bit simulation state hash
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// HASH PARTS
+// ----------------------------------------------------------------------------
+static unsigned long long TrainHashPart[MAX_TRAINS];
+static unsigned long long SwitchHashPart[MAX_SWITCHES];
+static unsigned long long StateHash = 0;
+
+// ----------------------------------------------------------------------------
+// Mixes one value into a running hash (splitmix64 finalizer).
+// ----------------------------------------------------------------------------
+static unsigned long long mixHash(unsigned long long h, unsigned long long value) {
+    h ^= value + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+// ----------------------------------------------------------------------------
+// Part for one train. Scheduled trains only carry their (possibly delayed)
+// spawn tick; finished trains only their final state.
+// ----------------------------------------------------------------------------
+static unsigned long long trainPart(int i) {
+    unsigned long long h = mixHash(0x7472ULL, (unsigned long long)i);
+    h = mixHash(h, (unsigned long long)TrainState[i]);
+    if (TrainState[i] == 0) {
+        h = mixHash(h, (unsigned long long)TrainSpawnTicks[i]);
+    } else {
+        h = mixHash(h, (unsigned long long)TrainCurrentRow[i]);
+        h = mixHash(h, (unsigned long long)TrainCurrentCol[i]);
+        h = mixHash(h, (unsigned long long)TrainCurrentDir[i]);
+    }
+    return h;
+}
+
+// ----------------------------------------------------------------------------
+// Part for one switch (0 for switches the level does not use).
+// ----------------------------------------------------------------------------
+static unsigned long long switchPart(int i) {
+    if (!SwitchExists[i]) return 0;
+    unsigned long long h = mixHash(0x7377ULL, (unsigned long long)i);
+    h = mixHash(h, (unsigned long long)SwitchCurrentState[i]);
+    for (int k = 0; k < 4; k++) {
+        h = mixHash(h, (unsigned long long)SwitchCounters[i][k]);
+    }
+    return h;
+}
+
+// ----------------------------------------------------------------------------
+// INITIALIZE STATE HASH
+// ----------------------------------------------------------------------------
+void initializeStateHash() {
+    StateHash = 0;
+    for (int i = 0; i < MAX_TRAINS; i++) {
+        TrainHashPart[i] = (i < TotalScheduledTrains) ? trainPart(i) : 0;
+        StateHash ^= TrainHashPart[i];
+    }
+    for (int i = 0; i < MAX_SWITCHES; i++) {
+        SwitchHashPart[i] = (i < SwitchCount) ? switchPart(i) : 0;
+        StateHash ^= SwitchHashPart[i];
+    }
+}
+
+// ----------------------------------------------------------------------------
+// REFRESH TRAIN / SWITCH HASH
+// ----------------------------------------------------------------------------
+void refreshTrainHash(int i) {
+    StateHash ^= takeTrainHashChange(i);
+}
+
+unsigned long long takeTrainHashChange(int i) {
+    unsigned long long part = trainPart(i);
+    unsigned long long change = TrainHashPart[i] ^ part;
+    TrainHashPart[i] = part;
+    return change;
+}
+
+void applyHashChange(unsigned long long change) {
+    StateHash ^= change;
+}
+
+void refreshSwitchHash(int i) {
+    unsigned long long part = switchPart(i);
+    StateHash ^= SwitchHashPart[i] ^ part;
+    SwitchHashPart[i] = part;
+}
+
+// ----------------------------------------------------------------------------
+// QUERIES
+// ----------------------------------------------------------------------------
+unsigned long long getStateHash() {
+    return StateHash;
+}
+
+unsigned long long computeStateHash() {
+    unsigned long long h = 0;
+    for (int i = 0; i < TotalScheduledTrains; i++) h ^= trainPart(i);
+    for (int i = 0; i < SwitchCount; i++) h ^= switchPart(i);
+    return h;
+}
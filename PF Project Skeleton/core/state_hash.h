@@ -0,0 +1,43 @@
+#ifndef STATE_HASH_H
+#define STATE_HASH_H
+
+// ============================================================================
+// STATE_HASH.H - Incremental 64-bit simulation state hash
+// ============================================================================
+// The hash is the XOR of one 64-bit part per train (position, direction,
+// state, pending spawn tick) and one per switch (state and counters). Code
+// that changes a train or switch calls the matching refresh function, which
+// swaps the old part for the new one, so a tick costs O(changes).
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// SETUP
+// ----------------------------------------------------------------------------
+// Compute every part from the current state (called when a simulation starts).
+void initializeStateHash();
+
+// ----------------------------------------------------------------------------
+// UPDATES
+// ----------------------------------------------------------------------------
+// Call after changing any hashed field of train i.
+void refreshTrainHash(int i);
+
+// Call after changing the state or counters of switch i.
+void refreshSwitchHash(int i);
+
+// Split form of refreshTrainHash for pool workers: takeTrainHashChange(i)
+// only touches train i's part and returns the change, which the simulation
+// thread later passes to applyHashChange (changes XOR together in any order).
+unsigned long long takeTrainHashChange(int i);
+void applyHashChange(unsigned long long change);
+
+// ----------------------------------------------------------------------------
+// QUERIES
+// ----------------------------------------------------------------------------
+// Current hash of the whole state.
+unsigned long long getStateHash();
+
+// Hash recomputed from scratch (for checking the incremental updates).
+unsigned long long computeStateHash();
+
+#endif
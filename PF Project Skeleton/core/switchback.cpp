@@ -0,0 +1,321 @@
+#include "switchback.h"
+#include "simulation_state.h"
+#include "simulation.h"
+#include "io.h"
+#include "snapshot.h"
+#include "grid.h"
+#include "state_hash.h"
+#include "cycle.h"
+#include "heatmap.h"
+#include "trains.h"
+#include "log_writer.h"
+#include "thread_pool.h"
+#include <cstdlib>
+#include <cstring>
+
+// ============================================================================
+// SWITCHBACK.CPP - C API of libswitchback.a
+// ============================================================================
+
+// sbGetHeat passes its layer straight to the heatmap
+#if SB_HEAT_HOLD != HEAT_HOLD || SB_HEAT_FLIP != HEAT_FLIP
+#error "SB_HEAT_* must match the HEAT_* layers in heatmap.h"
+#endif
+
+// ----------------------------------------------------------------------------
+// HANDLES
+// ----------------------------------------------------------------------------
+// Each open simulation owns a snapshot buffer (SimBytes long, grown to the
+// size of its level's snapshots). The live one's buffer is out of date; its
+// real state is in the globals.
+// ----------------------------------------------------------------------------
+static bool SimUsed[SB_MAX_SIMS];
+static unsigned char* SimState[SB_MAX_SIMS];
+static int SimBytes[SB_MAX_SIMS];
+static int LiveSim = -1;
+
+// ----------------------------------------------------------------------------
+// Finds a free handle. Returns -1 if all handles are taken.
+// ----------------------------------------------------------------------------
+static int allocateSim() {
+    for (int sim = 0; sim < SB_MAX_SIMS; sim++) {
+        if (SimUsed[sim]) continue;
+        SimUsed[sim] = true;
+        return sim;
+    }
+    return -1;
+}
+
+// ----------------------------------------------------------------------------
+// Saves the globals into sim's buffer. Returns false if it cannot grow.
+// ----------------------------------------------------------------------------
+static bool storeSim(int sim) {
+    int bytes = getSnapshotSize();
+    if (bytes > SimBytes[sim]) {
+        unsigned char* grown = (unsigned char*)realloc(SimState[sim], bytes);
+        if (!grown) return false;
+        SimState[sim] = grown;
+        SimBytes[sim] = bytes;
+    }
+    saveSnapshot(SimState[sim]);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Saves the live simulation so the globals can be reused. Returns false
+// (and it stays live) if there is no memory for it.
+// ----------------------------------------------------------------------------
+static bool parkLiveSim() {
+    if (LiveSim >= 0 && !storeSim(LiveSim)) return false;
+    LiveSim = -1;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Makes sim the live simulation. Returns false for a bad handle.
+// ----------------------------------------------------------------------------
+static bool activateSim(int sim) {
+    if (sim < 0 || sim >= SB_MAX_SIMS || !SimUsed[sim]) return false;
+    if (LiveSim == sim) return true;
+    if (!parkLiveSim()) return false;
+    restoreSnapshot(SimState[sim]);
+    resetCycleDetection();
+    LiveSim = sim;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Finishes a create once a level is in the globals (or frees the handle).
+// ----------------------------------------------------------------------------
+static int startSim(int sim, bool loaded) {
+    if (!loaded) {
+        SimUsed[sim] = false;
+        return -1;
+    }
+    initializeSimulation();
+    LiveSim = sim;
+    return sim;
+}
+
+// ----------------------------------------------------------------------------
+// LIFETIME
+// ----------------------------------------------------------------------------
+int sbCreateFromFile(const char* path) {
+    int sim = allocateSim();
+    if (sim < 0) return -1;
+    if (!parkLiveSim()) {
+        SimUsed[sim] = false;
+        return -1;
+    }
+    return startSim(sim, loadLevelFile(path));
+}
+
+int sbCreateFromBuffer(const char* text, int length) {
+    int sim = allocateSim();
+    if (sim < 0) return -1;
+    if (!parkLiveSim()) {
+        SimUsed[sim] = false;
+        return -1;
+    }
+    return startSim(sim, loadLevelBuffer(text, length));
+}
+
+int sbClone(int sim) {
+    if (!activateSim(sim)) return -1;
+    int copy = allocateSim();
+    if (copy < 0) return -1;
+    if (!storeSim(copy)) {
+        SimUsed[copy] = false;
+        return -1;
+    }
+    return copy;
+}
+
+void sbDestroy(int sim) {
+    if (sim < 0 || sim >= SB_MAX_SIMS || !SimUsed[sim]) return;
+    if (LiveSim == sim) LiveSim = -1;
+    SimUsed[sim] = false;
+    free(SimState[sim]);
+    SimState[sim] = NULL;
+    SimBytes[sim] = 0;
+}
+
+// ----------------------------------------------------------------------------
+// OPTIONS
+// ----------------------------------------------------------------------------
+void sbSetLogging(int enabled) {
+    setLoggingEnabled(enabled != 0);
+}
+
+void sbSetHashLog(int enabled) {
+    setHashLogEnabled(enabled != 0);
+}
+
+void sbSetLogDrop(int enabled) {
+    setLogBackpressure(enabled ? LOG_DROP : LOG_BLOCK);
+}
+
+int sbSetLogLevels(const char* spec) {
+    return (spec && parseLogLevels(spec)) ? 0 : -1;
+}
+
+void sbSetThreads(int threads) {
+    setPoolThreads(threads);
+}
+
+void sbSetHeatWindow(int ticks) {
+    setHeatWindow(ticks);
+}
+
+// ----------------------------------------------------------------------------
+// STEPPING
+// ----------------------------------------------------------------------------
+int sbStep(int sim, int ticks) {
+    if (!activateSim(sim)) return -1;
+    for (int t = 0; t < ticks; t++) simulateOneTick();
+    return CurrentTick;
+}
+
+int sbIsComplete(int sim) {
+    if (!activateSim(sim)) return -1;
+    return isSimulationComplete() ? 1 : 0;
+}
+
+int sbGetCycleLength(int sim) {
+    if (!activateSim(sim)) return -1;
+    return getCycleLength();
+}
+
+int sbGetCycleStart(int sim) {
+    if (!activateSim(sim)) return -1;
+    return getCycleStart();
+}
+
+// ----------------------------------------------------------------------------
+// QUERIES
+// ----------------------------------------------------------------------------
+int sbGetTick(int sim) {
+    if (!activateSim(sim)) return -1;
+    return CurrentTick;
+}
+
+unsigned long long sbGetStateHash(int sim) {
+    if (!activateSim(sim)) return 0;
+    return getStateHash();
+}
+
+int sbGetMapSize(int sim, int* rows, int* cols) {
+    if (!activateSim(sim)) return -1;
+    if (rows) *rows = LevelNumRows;
+    if (cols) *cols = LevelNumCols;
+    return 0;
+}
+
+int sbGetMap(int sim, char* cells, int capacity) {
+    if (!activateSim(sim)) return -1;
+    int size = LevelNumRows * LevelNumCols;
+    if (!cells || capacity < size) return -1;
+    for (int r = 0; r < LevelNumRows; r++) getTileRow(r, cells + r * LevelNumCols);
+    return size;
+}
+
+int sbGetTrains(int sim, int* rows, int* cols, int* dirs, int* states, int capacity) {
+    if (!activateSim(sim)) return -1;
+    int count = TotalScheduledTrains < capacity ? TotalScheduledTrains : capacity;
+    if (count > 0) {
+        size_t bytes = sizeof(int) * count;
+        if (rows) memcpy(rows, TrainCurrentRow, bytes);
+        if (cols) memcpy(cols, TrainCurrentCol, bytes);
+        if (dirs) memcpy(dirs, TrainCurrentDir, bytes);
+        if (states) memcpy(states, TrainState, bytes);
+    }
+    return TotalScheduledTrains;
+}
+
+int sbGetTrainColors(int sim, int* colors, int capacity) {
+    if (!activateSim(sim)) return -1;
+    int count = TotalScheduledTrains < capacity ? TotalScheduledTrains : capacity;
+    if (colors && count > 0) memcpy(colors, TrainColorCode, sizeof(int) * count);
+    return TotalScheduledTrains;
+}
+
+int sbGetChunks(int sim, int* firstRows, int* firstCols, int* endRows, int* endCols, int capacity) {
+    if (!activateSim(sim)) return -1;
+    for (int k = 0; k < GridChunkCount && k < capacity; k++) {
+        int r0, c0, r1, c1;
+        getChunkBounds(k, r0, c0, r1, c1);
+        if (firstRows) firstRows[k] = r0;
+        if (firstCols) firstCols[k] = c0;
+        if (endRows) endRows[k] = r1;
+        if (endCols) endCols[k] = c1;
+    }
+    return GridChunkCount;
+}
+
+int sbGetSwitchAt(int sim, int row, int col) {
+    if (!activateSim(sim) || !isInBounds(row, col)) return -1;
+    if (getTileClass(row, col) != TILE_SWITCH) return -1;
+    return getSwitchIndex(row, col);
+}
+
+int sbGetHaltMap(int sim, char* cells, int capacity) {
+    if (!activateSim(sim)) return -1;
+    int size = LevelNumRows * LevelNumCols;
+    if (!cells || capacity < size) return -1;
+    memset(cells, 0, size);
+    if (ActiveHaltZones == 0) return size;
+    for (int r = 0; r < LevelNumRows; r++) {
+        for (int c = 0; c < LevelNumCols; c++) cells[r * LevelNumCols + c] = isCellHalted(r, c) ? 1 : 0;
+    }
+    return size;
+}
+
+int sbGetHeat(int sim, int layer, int* values, int capacity) {
+    if (!activateSim(sim) || layer < 0 || layer >= HEAT_LAYERS) return -1;
+    int size = LevelNumRows * LevelNumCols;
+    if (!values || capacity < size) return -1;
+    for (int r = 0; r < LevelNumRows; r++) {
+        for (int c = 0; c < LevelNumCols; c++) values[r * LevelNumCols + c] = getHeatValue(layer, r, c);
+    }
+    return size;
+}
+
+int sbGetSwitches(int sim, int* states, int* rows, int* cols, int capacity) {
+    if (!activateSim(sim)) return -1;
+    int count = SwitchCount < capacity ? SwitchCount : capacity;
+    if (count > 0) {
+        size_t bytes = sizeof(int) * count;
+        if (states) memcpy(states, SwitchCurrentState, bytes);
+        if (rows) memcpy(rows, SwitchRow, bytes);
+        if (cols) memcpy(cols, SwitchCol, bytes);
+    }
+    return SwitchCount;
+}
+
+int sbGetSwitchName(int sim, int idx, char* name, int capacity) {
+    if (!activateSim(sim) || idx < 0 || idx >= SwitchCount || !name || capacity < 1) return -1;
+    strncpy(name, SwitchName[idx], capacity - 1);
+    name[capacity - 1] = '\0';
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// SNAPSHOTS
+// ----------------------------------------------------------------------------
+int sbGetSnapshotSize(int sim) {
+    if (!activateSim(sim)) return -1;
+    return getSnapshotSize();
+}
+
+int sbSaveSnapshot(int sim, unsigned char* buffer, int size) {
+    if (!activateSim(sim) || !buffer || size < getSnapshotSize()) return -1;
+    saveSnapshot(buffer);
+    return getSnapshotSize();
+}
+
+int sbRestoreSnapshot(int sim, const unsigned char* buffer, int size) {
+    if (!activateSim(sim) || !isSnapshotValid(buffer, size)) return -1;
+    restoreSnapshot(buffer);
+    resetCycleDetection();
+    return 0;
+}
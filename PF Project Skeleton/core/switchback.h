@@ -0,0 +1,159 @@
+#ifndef SWITCHBACK_H
+#define SWITCHBACK_H
+
+// ============================================================================
+// SWITCHBACK.H - C API of libswitchback.a
+// ============================================================================
+// Lets another program (C or C++) load levels and step simulations without
+// SFML or a window. A simulation is an int handle. Queries copy whole state
+// arrays into buffers owned by the caller; pass NULL for ones you don't need.
+//
+// Several simulations can be open at once, but only one is "live" in the
+// core's global state. Calling into another handle saves the live one and
+// restores the other (one snapshot copy each way), so stay on one handle at
+// a time where you can. Livelock detection starts over after a switch, and
+// the heatmap and out/ logs are shared. Call the API from one thread only.
+//
+// Functions return -1 on a bad handle or a failed load unless noted.
+// ============================================================================
+
+#define SB_API_VERSION 2
+#define SB_MAX_SIMS 64
+
+// TRAIN STATES (as reported by sbGetTrains)
+#define SB_TRAIN_SCHEDULED 0
+#define SB_TRAIN_ACTIVE    1
+#define SB_TRAIN_ARRIVED   2
+#define SB_TRAIN_CRASHED   3
+
+// HEATMAP LAYERS (as read by sbGetHeat)
+#define SB_HEAT_HOLD 0
+#define SB_HEAT_FLIP 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ----------------------------------------------------------------------------
+// LIFETIME
+// ----------------------------------------------------------------------------
+// Load a .lvl file and start a simulation at tick 0. Returns the handle.
+int sbCreateFromFile(const char* path);
+
+// Same from level text in memory (length bytes in .lvl format).
+int sbCreateFromBuffer(const char* text, int length);
+
+// New simulation with the exact state of sim (for trying out branches).
+int sbClone(int sim);
+
+// Free a simulation. The handle may be reused by a later create.
+void sbDestroy(int sim);
+
+// ----------------------------------------------------------------------------
+// OPTIONS (apply to all handles)
+// ----------------------------------------------------------------------------
+// Write out/*.csv logs (1, the default) or not (0).
+void sbSetLogging(int enabled);
+
+// Write the per-tick state hash to out/hash.csv (1) or not (0, the default).
+void sbSetHashLog(int enabled);
+
+// Drop log rows when the log writer lags (1) instead of waiting (0).
+void sbSetLogDrop(int enabled);
+
+// Per-log levels, e.g. "trace=events,signals=off,hash=sampled:100".
+// Returns 0, or -1 (and prints why) if spec is not valid.
+int sbSetLogLevels(const char* spec);
+
+// Simulation threads on busy maps (1 = single-threaded, 0 = CPU cores).
+void sbSetThreads(int threads);
+
+// Heatmap window in ticks for sbGetHeat (0 = all time, the default).
+void sbSetHeatWindow(int ticks);
+
+// ----------------------------------------------------------------------------
+// STEPPING
+// ----------------------------------------------------------------------------
+// Run ticks ticks (a finished run keeps ticking; check sbIsComplete).
+// Returns the tick reached.
+int sbStep(int sim, int ticks);
+
+// 1 once every train has arrived or crashed (or the run is livelocked).
+int sbIsComplete(int sim);
+
+// Ticks in a detected livelock cycle (0 if none).
+int sbGetCycleLength(int sim);
+
+// Tick whose end state the cycle repeats (-1 if no cycle was found).
+int sbGetCycleStart(int sim);
+
+// ----------------------------------------------------------------------------
+// QUERIES
+// ----------------------------------------------------------------------------
+// Current tick.
+int sbGetTick(int sim);
+
+// 64-bit hash of the whole state (equal states give equal hashes).
+unsigned long long sbGetStateHash(int sim);
+
+// Map size in cells; either pointer may be NULL.
+int sbGetMapSize(int sim, int* rows, int* cols);
+
+// Map tiles row by row into cells[rows * cols]. Returns rows * cols.
+int sbGetMap(int sim, char* cells, int capacity);
+
+// Per-train position (row, col), direction and SB_TRAIN_* state for the
+// first capacity trains. Returns the number of trains in the level.
+int sbGetTrains(int sim, int* rows, int* cols, int* dirs, int* states, int capacity);
+
+// Colour code of each train's schedule entry (0 red, 1 green, 2 blue) for
+// the first capacity trains. Returns the number of trains in the level.
+int sbGetTrainColors(int sim, int* colors, int capacity);
+
+// Allocated map chunks (blocks of cells that hold anything but empty
+// ground): cells [firstRows[k], endRows[k]) x [firstCols[k], endCols[k]).
+// Returns the number of chunks; only the first capacity are written.
+int sbGetChunks(int sim, int* firstRows, int* firstCols, int* endRows, int* endCols, int capacity);
+
+// Switch index of a switch tile (as in sbGetSwitches), or -1 for any other
+// cell.
+int sbGetSwitchAt(int sim, int row, int col);
+
+// 1 for cells inside an active emergency halt zone, 0 elsewhere, row by row
+// into cells[rows * cols]. Returns rows * cols.
+int sbGetHaltMap(int sim, char* cells, int capacity);
+
+// Heatmap layer (SB_HEAT_*) counts in the sbSetHeatWindow window, row by
+// row into values[rows * cols]. Returns rows * cols.
+int sbGetHeat(int sim, int layer, int* values, int capacity);
+
+// Per-switch state (0/1) and first map cell, indexed by switch: letter - 'A'
+// for A-Z, then named switches from 26 in level order. Unused switches have
+// row -1. Returns the number of switch slots (26 + named switches).
+int sbGetSwitches(int sim, int* states, int* rows, int* cols, int capacity);
+
+// Name of switch idx ("A".."Z" or the level's name for it) into name, at
+// most capacity bytes with the terminator. Returns 0, or -1 if idx is not a
+// switch slot.
+int sbGetSwitchName(int sim, int idx, char* name, int capacity);
+
+// ----------------------------------------------------------------------------
+// SNAPSHOTS
+// ----------------------------------------------------------------------------
+// Bytes needed for a snapshot of sim (depends on its level: the number of
+// switches and the map chunks holding them), or -1 for a bad handle.
+int sbGetSnapshotSize(int sim);
+
+// Copy the state of sim into buffer. Returns the bytes written.
+int sbSaveSnapshot(int sim, unsigned char* buffer, int size);
+
+// Replace the state of sim with a snapshot, which may come from any sim
+// (size is the buffer's length). Returns 0 on success, or -1 with sim
+// unchanged if the buffer is not a complete, consistent snapshot.
+int sbRestoreSnapshot(int sim, const unsigned char* buffer, int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
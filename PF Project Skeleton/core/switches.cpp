@@ -2,36 +2,144 @@
 #include "simulation_state.h"
 #include "grid.h"
 #include "io.h"
+#include "heatmap.h"
+#include "state_hash.h"
+#include "routing.h"
+#include "thread_pool.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 // ============================================================================
 // SWITCHES.CPP - Switch management
 // ============================================================================
 
+// ----------------------------------------------------------------------------
+// PARTIAL COUNTERS
+// ----------------------------------------------------------------------------
+// Each pool worker counts switch entries into its own copy; the copies are
+// added into SwitchCounters afterwards. Only switches in a worker's touched
+// list are non-zero, so nothing has to be cleared in bulk. The copies have
+// PartialSize entries, grown to SwitchCount before a count.
+// ----------------------------------------------------------------------------
+static int (*PartialCounters[POOL_MAX_THREADS])[4];
+static bool* PartialTouched[POOL_MAX_THREADS];
+static int* PartialTouchedList[POOL_MAX_THREADS];
+static int PartialTouchedCount[POOL_MAX_THREADS];
+static int PartialSize = 0;
+
+// ----------------------------------------------------------------------------
+// SWITCHES OF THE CURRENT TICK
+// ----------------------------------------------------------------------------
+// A switch only reaches its K when a train enters it, so the flip passes
+// only look at the switches entered this tick (each listed once), and then
+// at the ones queued to flip (in index order, the order flips are logged in).
+// ----------------------------------------------------------------------------
+static int EnteredSwitches[MAX_SWITCHES];
+static bool EnteredMark[MAX_SWITCHES];
+static int EnteredCount = 0;
+static int QueuedSwitches[MAX_SWITCHES];
+static int QueuedCount = 0;
+
+// ----------------------------------------------------------------------------
+// SIGNALS OF THE CURRENT TICK
+// ----------------------------------------------------------------------------
+// A signal only changes where a train arrives or leaves, so between full
+// walks updateSignalLights() looks at the switches occupied now and the ones
+// occupied at the last update (RedSwitches, whose signals are RED). After
+// the state is replaced the list is unknown until the next full walk.
+// ----------------------------------------------------------------------------
+static bool SwitchOccupied[MAX_SWITCHES];
+static int OccupiedSwitches[MAX_SWITCHES];
+static int OccupiedCount = 0;
+static int RedSwitches[MAX_SWITCHES];
+static int RedCount = 0;
+static bool RedListValid = false;
+static int ChangedSignals[2 * MAX_SWITCHES];
+
+static int compareSwitchIds(const void* a, const void* b) {
+    return *(const int*)a - *(const int*)b;
+}
+
+// ----------------------------------------------------------------------------
+// Pool loop body: counts the entries of running trains begin .. end - 1 of
+// the list.
+// ----------------------------------------------------------------------------
+static void countSwitchEntries(int begin, int end, int worker) {
+    for (int k = begin; k < end; k++) {
+        int i = ActiveTrainList[k];
+        int r = TrainCurrentRow[i];
+        int c = TrainCurrentCol[i];
+        if (!isSwitchTile(r, c)) continue;
+        int swIdx = getSwitchIndex(r, c);
+        if (swIdx < 0) continue; // '@' cell no switch was named for
+
+        // Logic: Entry direction is opposite of current facing
+        int currentDir = TrainCurrentDir[i];
+        int entryDir = (currentDir + 2) % 4;
+
+        if (SwitchLogicMode[swIdx] == MODE_GLOBAL) {
+            PartialCounters[worker][swIdx][0]++;
+        } else {
+            PartialCounters[worker][swIdx][entryDir]++;
+        }
+        if (!PartialTouched[worker][swIdx]) {
+            PartialTouched[worker][swIdx] = true;
+            PartialTouchedList[worker][PartialTouchedCount[worker]++] = swIdx;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Gives every pool worker partial counters for SwitchCount switches (all
+// zero, as between ticks).
+// ----------------------------------------------------------------------------
+static void reservePartialCounters() {
+    if (PartialSize >= SwitchCount) return;
+    int size = SwitchCount;
+    for (int w = 0; w < POOL_MAX_THREADS; w++) {
+        int (*counters)[4] = (int (*)[4])realloc(PartialCounters[w], sizeof(int) * 4 * size);
+        bool* touched = (bool*)realloc(PartialTouched[w], sizeof(bool) * size);
+        int* list = (int*)realloc(PartialTouchedList[w], sizeof(int) * size);
+        if (counters) PartialCounters[w] = counters;
+        if (touched) PartialTouched[w] = touched;
+        if (list) PartialTouchedList[w] = list;
+        if (!counters || !touched || !list) {
+            printf("Error: Not enough memory for switch counters\n");
+            exit(1);
+        }
+        memset(PartialCounters[w] + PartialSize, 0, sizeof(int) * 4 * (size - PartialSize));
+        memset(PartialTouched[w] + PartialSize, 0, sizeof(bool) * (size - PartialSize));
+    }
+    PartialSize = size;
+}
+
 // ----------------------------------------------------------------------------
 // UPDATE SWITCH COUNTERS
 // ----------------------------------------------------------------------------
 // Increment counters for trains entering switches.
 // ----------------------------------------------------------------------------
 void updateSwitchCounters() {
-    for(int i = 0; i < TotalScheduledTrains; i++) {
-        if (TrainState[i] == 1) { 
-            int r = TrainCurrentRow[i];
-            int c = TrainCurrentCol[i];
-
-            if (isSwitchTile(r, c)) {
-                int swIdx = getSwitchIndex(r, c);
-                
-                // Logic: Entry direction is opposite of current facing
-                int currentDir = TrainCurrentDir[i];
-                int entryDir = (currentDir + 2) % 4; 
-
-                if (SwitchLogicMode[swIdx] == MODE_GLOBAL) {
-                    SwitchCounters[swIdx][0]++;
-                } else {
-                    SwitchCounters[swIdx][entryDir]++;
-                }
+    reservePartialCounters();
+    parallelFor(ActiveTrainCount, getPoolGrain(POOL_TICK_GRAIN), countSwitchEntries);
+
+    // Add up the partial counts (sums do not depend on who counted what)
+    int workers = getPoolThreads();
+    for (int w = 0; w < workers; w++) {
+        for (int k = 0; k < PartialTouchedCount[w]; k++) {
+            int swIdx = PartialTouchedList[w][k];
+            for (int d = 0; d < 4; d++) {
+                SwitchCounters[swIdx][d] += PartialCounters[w][swIdx][d];
+                PartialCounters[w][swIdx][d] = 0;
+            }
+            PartialTouched[w][swIdx] = false;
+            refreshSwitchHash(swIdx);
+            if (!EnteredMark[swIdx]) {
+                EnteredMark[swIdx] = true;
+                EnteredSwitches[EnteredCount++] = swIdx;
             }
         }
+        PartialTouchedCount[w] = 0;
     }
 }
 
@@ -41,8 +149,10 @@ void updateSwitchCounters() {
 // Queue flips when counters hit K.
 // ----------------------------------------------------------------------------
 void queueSwitchFlips() {
-    for (int i = 0; i < MAX_SWITCHES; i++)
+    for (int e = 0; e < EnteredCount; e++)
     {
+        int i = EnteredSwitches[e];
+        EnteredMark[i] = false;
         if (!SwitchExists[i])
         {
             continue;
@@ -69,8 +179,16 @@ void queueSwitchFlips() {
         }
         if (shouldFlip){
             SwitchFlipQueue[i] = true;
+            invalidateSwitchRoutes(i); // Routes already assume the new state
+            int q = QueuedCount++;
+            while (q > 0 && QueuedSwitches[q - 1] > i) {
+                QueuedSwitches[q] = QueuedSwitches[q - 1];
+                q--;
+            }
+            QueuedSwitches[q] = i;
         }
     }
+    EnteredCount = 0;
 }
 
 // ----------------------------------------------------------------------------
@@ -79,61 +197,123 @@ void queueSwitchFlips() {
 // Apply queued flips after movement.
 // ----------------------------------------------------------------------------
 void applyDeferredFlips() {
-    for (int i = 0; i < MAX_SWITCHES; i++) {
+    for (int q = 0; q < QueuedCount; q++) {
+        int i = QueuedSwitches[q];
         if (SwitchFlipQueue[i]) {
             if (SwitchCurrentState[i] == 0) {
                 SwitchCurrentState[i] = 1;
             } else {
                 SwitchCurrentState[i] = 0;
             }
-            char switchName = 'A' + i;
-            const char* modeStr = (SwitchLogicMode[i] == MODE_GLOBAL) ? "GLOBAL" : "PER_DIR";
-            logSwitchState(CurrentTick, switchName, modeStr, SwitchCurrentState[i]);
+            if (isLogEventTick(LOG_STREAM_SWITCH, CurrentTick)) {
+                const char* modeStr = (SwitchLogicMode[i] == MODE_GLOBAL) ? "GLOBAL" : "PER_DIR";
+                logSwitchState(CurrentTick, i, modeStr, SwitchCurrentState[i]);
+            }
+            recordHeat(HEAT_FLIP, SwitchRow[i], SwitchCol[i]);
 
             for (int k = 0; k < 4; k++) {
                 SwitchCounters[i][k] = 0; // Reset
             }
-            SwitchFlipQueue[i] = false;
+            refreshSwitchHash(i);
+            SwitchFlipQueue[i] = false; // Routes already assumed the new state
         }
     }
+    QueuedCount = 0;
 }
 
 // ----------------------------------------------------------------------------
 // UPDATE SIGNAL LIGHTS
 // ----------------------------------------------------------------------------
-// Update signal colors for switches.
+// Update signal colors for switches. At the "events" log level only colour
+// changes are written. Ticks that log every switch (and the first update
+// after the state was replaced) walk all switches; other ticks only visit
+// switches whose occupancy may have changed, and log their changes in
+// switch order like the walk does.
 // ----------------------------------------------------------------------------
+static bool setSignal(int i) {
+    // Default Signal is green; if a train is on the switch, it's RED
+    int signal = SwitchOccupied[i] ? SIGNAL_RED : SIGNAL_GREEN;
+    bool changed = signal != SwitchSignal[i];
+    SwitchSignal[i] = signal;
+    return changed;
+}
+
+static void logSignal(int i) {
+    logSignalState(CurrentTick, i, SwitchSignal[i] == SIGNAL_RED ? "RED" : "GREEN");
+}
+
 void updateSignalLights() { 
-    for (int i = 0; i < MAX_SWITCHES; i++) {
-        if (!SwitchExists[i]) continue;
-        
-        // Default Signal is green
-        const char* color = "GREEN";
-        char switchName = 'A' + i;
-
-        // If a train is on the switch, it's RED 
-        for (int t = 0; t < TotalScheduledTrains; t++) {
-            if (TrainState[t] == 1) { // Active
-                int r = TrainCurrentRow[t];
-                int c = TrainCurrentCol[t];
-                if (getSwitchIndex(r, c) == i) {
-                    color = "RED";
-                    break;
-                }
-            }
+    bool logAll = isLogTick(LOG_STREAM_SIGNAL, CurrentTick);
+    bool logChanges = LogLevel[LOG_STREAM_SIGNAL] == LOG_EVENTS;
+
+    // Switches with a running train on them (each listed once)
+    OccupiedCount = 0;
+    for (int k = 0; k < ActiveTrainCount; k++) {
+        int t = ActiveTrainList[k];
+        int swIdx = getSwitchIndex(TrainCurrentRow[t], TrainCurrentCol[t]);
+        if (swIdx < 0 || SwitchOccupied[swIdx]) continue;
+        SwitchOccupied[swIdx] = true;
+        OccupiedSwitches[OccupiedCount++] = swIdx;
+    }
+
+    if (logAll || !RedListValid) {
+        for (int i = 0; i < SwitchCount; i++) {
+            if (!SwitchExists[i]) continue;
+            bool changed = setSignal(i);
+            
+            // Log the signal state
+            if (logAll || (logChanges && changed)) logSignal(i);
+        }
+    } else {
+        // Was red or is occupied now: the only signals that can change
+        int changedCount = 0;
+        for (int k = 0; k < RedCount; k++) {
+            int i = RedSwitches[k];
+            if (setSignal(i)) ChangedSignals[changedCount++] = i;
+        }
+        for (int k = 0; k < OccupiedCount; k++) {
+            int i = OccupiedSwitches[k];
+            if (SwitchExists[i] && setSignal(i)) ChangedSignals[changedCount++] = i;
+        }
+        if (logChanges) {
+            if (changedCount > 1) qsort(ChangedSignals, changedCount, sizeof(int), compareSwitchIds);
+            for (int k = 0; k < changedCount; k++) logSignal(ChangedSignals[k]);
         }
-        
-        // Log the signal state
-        logSignalState(CurrentTick, switchName, color);
     }
+
+    // The occupied switches are the red ones until the next update
+    RedCount = 0;
+    for (int k = 0; k < OccupiedCount; k++) {
+        int i = OccupiedSwitches[k];
+        SwitchOccupied[i] = false;
+        if (SwitchExists[i]) RedSwitches[RedCount++] = i;
+    }
+    RedListValid = true;
+}
+
+void invalidateSignalLights() {
+    RedListValid = false;
 }
 
 // ----------------------------------------------------------------------------
 // TOGGLE SWITCH STATE (Manual)
 // ----------------------------------------------------------------------------
-// Manually toggle a switch state.
+// Flip the switch on cell (r, c) right away (operator input between ticks).
+// Returns false if the cell holds no switch of this level.
 // ----------------------------------------------------------------------------
-void toggleSwitchState() {
+bool toggleSwitchState(int r, int c) {
+    if (!isSwitchTile(r, c)) return false;
+    int idx = getSwitchIndex(r, c);
+    if (idx < 0 || idx >= SwitchCount || !SwitchExists[idx]) return false;
+
+    SwitchCurrentState[idx] = 1 - SwitchCurrentState[idx];
+    refreshSwitchHash(idx);
+    invalidateSwitchRoutes(idx);
+    if (isLogEventTick(LOG_STREAM_SWITCH, CurrentTick)) {
+        const char* modeStr = (SwitchLogicMode[idx] == MODE_GLOBAL) ? "GLOBAL" : "PER_DIR";
+        logSwitchState(CurrentTick, idx, modeStr, SwitchCurrentState[idx]);
+    }
+    return true;
 }
 
 // ----------------------------------------------------------------------------
@@ -29,11 +29,15 @@ void applyDeferredFlips();
 // Update switch signal colors.
 void updateSignalLights();
 
+// Forget which signals are red (the state was replaced); the next update
+// checks every switch.
+void invalidateSignalLights();
+
 // ----------------------------------------------------------------------------
 // SWITCH TOGGLE (for manual control / editing)
 // ----------------------------------------------------------------------------
-// Manually toggle a switch state.
-void toggleSwitchState();
+// Manually toggle the switch on cell (r, c). Returns true if there was one.
+bool toggleSwitchState(int r, int c);
 
 // ----------------------------------------------------------------------------
 // HELPER FUNCTIONS
@@ -0,0 +1,218 @@
+#include "thread_pool.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+// ============================================================================
+// THREAD_POOL.CPP - Work-stealing parallel-for
+// ============================================================================
+
+#define POOL_SPIN 1000     // Checks for a new loop before a worker sleeps
+#define POOL_STRIDE 8      // Range slots one cache line apart
+
+// ----------------------------------------------------------------------------
+// WORKERS
+// ----------------------------------------------------------------------------
+static int PoolSetting = 0;
+static int PoolMinItems = 0;
+static std::atomic<bool> PoolStealing(true);
+static int PoolCores = 0;
+static std::thread* PoolWorkers[POOL_MAX_THREADS];
+static int PoolStarted = 0;        // Worker threads (caller not counted)
+static bool PoolShutdownRegistered = false;
+
+static std::mutex PoolMutex;
+static std::condition_variable PoolWake;
+static std::atomic<unsigned int> PoolGeneration(0);   // Bumped per loop
+static std::atomic<bool> PoolStop(false);
+static std::atomic<bool> PoolInLoop(false);
+
+// ----------------------------------------------------------------------------
+// CURRENT LOOP
+// ----------------------------------------------------------------------------
+// Worker w's items are [begin, end), packed as begin << 32 | end. Items are
+// only ever taken with a compare-and-swap: the owner from the front, others
+// from the back. Only the caller stores a whole range, when a loop starts,
+// and by then every range of the previous loop is empty.
+//
+// A worker may still be looking at the previous loop's (empty) ranges when
+// the next loop starts, so the body and grain are atomics too. The caller
+// stores them before the ranges; a worker reads the body only after taking
+// items, so it always gets the body of the loop those items belong to.
+// ----------------------------------------------------------------------------
+static std::atomic<void (*)(int, int, int)> PoolBody(NULL);
+static std::atomic<int> PoolGrain(1);
+static std::atomic<int> PoolParticipants(1);
+static std::atomic<unsigned long long> PoolRange[POOL_MAX_THREADS * POOL_STRIDE];
+static std::atomic<int> PoolItemsLeft(0);
+
+static unsigned long long packRange(int begin, int end) {
+    return ((unsigned long long)(unsigned int)begin << 32) | (unsigned int)end;
+}
+
+// ----------------------------------------------------------------------------
+// SETTINGS
+// ----------------------------------------------------------------------------
+void setPoolThreads(int threads) {
+    if (threads < 0) threads = 0;
+    PoolSetting = threads;
+}
+
+int getPoolThreads() {
+    int threads = PoolSetting;
+    if (threads == 0) {
+        // Asked once: it is a system call
+        if (PoolCores == 0) PoolCores = (int)std::thread::hardware_concurrency();
+        threads = PoolCores;
+    }
+    if (threads > POOL_MAX_THREADS) threads = POOL_MAX_THREADS;
+    if (threads < 1) threads = 1;
+    return threads;
+}
+
+void setPoolMinItems(int items) {
+    if (items < 0) items = 0;
+    PoolMinItems = items;
+}
+
+int getPoolGrain(int grain) {
+    return PoolMinItems > 0 ? PoolMinItems : grain;
+}
+
+void setPoolStealing(bool enabled) {
+    PoolStealing.store(enabled);
+}
+
+// ----------------------------------------------------------------------------
+// Takes up to grain items from worker w's range, from the front if w is the
+// taker's own range, else from the back. Returns false if it was empty.
+// ----------------------------------------------------------------------------
+static bool takeItems(int w, bool own, int& begin, int& end) {
+    std::atomic<unsigned long long>& slot = PoolRange[w * POOL_STRIDE];
+    unsigned long long range = slot.load(std::memory_order_acquire);
+    while (true) {
+        int lo = (int)(range >> 32);
+        int hi = (int)(range & 0xFFFFFFFFULL);
+        if (lo >= hi) return false;
+        // Any grain splits a range correctly; it only sets the take size
+        int grain = PoolGrain.load(std::memory_order_relaxed);
+        int take = (hi - lo < grain) ? hi - lo : grain;
+        unsigned long long rest = own ? packRange(lo + take, hi) : packRange(lo, hi - take);
+        if (slot.compare_exchange_weak(range, rest, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            begin = own ? lo : hi - take;
+            end = begin + take;
+            return true;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Runs items until no range has any left (own range first, then stealing,
+// unless that is turned off).
+// ----------------------------------------------------------------------------
+static void runPoolItems(int w) {
+    int participants = PoolParticipants.load(std::memory_order_acquire);
+    int victims = PoolStealing.load() ? participants : 1;
+    int begin = 0, end = 0;
+    while (true) {
+        bool found = takeItems(w, true, begin, end);
+        for (int v = 1; !found && v < victims; v++) {
+            found = takeItems((w + v) % participants, false, begin, end);
+        }
+        if (!found) return;
+        PoolBody.load(std::memory_order_acquire)(begin, end, w);
+        PoolItemsLeft.fetch_sub(end - begin, std::memory_order_acq_rel);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Worker thread: spins briefly for the next loop (ticks come in quick
+// succession), then sleeps until one is published. seen is the generation
+// before the loop the worker was started for, so it takes part in that one.
+// ----------------------------------------------------------------------------
+static void runPoolWorker(int w, unsigned int seen) {
+    while (true) {
+        int spins = 0;
+        while (PoolGeneration.load(std::memory_order_acquire) == seen && !PoolStop.load()) {
+            if (++spins < POOL_SPIN) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(PoolMutex);
+            while (PoolGeneration.load() == seen && !PoolStop.load()) PoolWake.wait(lock);
+        }
+        if (PoolStop.load()) return;
+        seen = PoolGeneration.load(std::memory_order_acquire);
+        runPoolItems(w);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Makes exactly helpers worker threads run.
+// ----------------------------------------------------------------------------
+static void startPoolWorkers(int helpers) {
+    if (PoolStarted > helpers) shutdownPool();
+    while (PoolStarted < helpers) {
+        PoolWorkers[PoolStarted] = new std::thread(runPoolWorker, PoolStarted + 1, PoolGeneration.load());
+        PoolStarted++;
+    }
+    if (!PoolShutdownRegistered) atexit(shutdownPool);
+    PoolShutdownRegistered = true;
+}
+
+// ----------------------------------------------------------------------------
+// PARALLEL FOR
+// ----------------------------------------------------------------------------
+void parallelFor(int count, int grain, void (*body)(int begin, int end, int worker)) {
+    if (count <= 0) return;
+    if (grain < 1) grain = 1;
+    int threads = getPoolThreads();
+
+    // Small loops, one thread, or a loop inside a loop body: no sharing
+    if (count <= grain || threads == 1 || PoolInLoop.load()) {
+        body(0, count, 0);
+        return;
+    }
+    PoolInLoop.store(true);
+    startPoolWorkers(threads - 1);
+
+    PoolBody.store(body, std::memory_order_release);
+    PoolGrain.store(grain, std::memory_order_relaxed);
+    PoolParticipants.store(threads, std::memory_order_release);
+    PoolItemsLeft.store(count, std::memory_order_release);
+    for (int w = 0; w < POOL_MAX_THREADS; w++) {
+        int begin = (w < threads) ? (int)((long long)count * w / threads) : count;
+        int end = (w < threads) ? (int)((long long)count * (w + 1) / threads) : count;
+        PoolRange[w * POOL_STRIDE].store(packRange(begin, end), std::memory_order_release);
+    }
+    {
+        std::lock_guard<std::mutex> lock(PoolMutex);
+        PoolGeneration.fetch_add(1, std::memory_order_acq_rel);
+    }
+    PoolWake.notify_all();
+
+    runPoolItems(0);
+    while (PoolItemsLeft.load(std::memory_order_acquire) > 0) std::this_thread::yield();
+    PoolInLoop.store(false);
+}
+
+// ----------------------------------------------------------------------------
+// SHUTDOWN POOL
+// ----------------------------------------------------------------------------
+void shutdownPool() {
+    if (PoolStarted == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(PoolMutex);
+        PoolStop.store(true);
+    }
+    PoolWake.notify_all();
+    for (int t = 0; t < PoolStarted; t++) {
+        PoolWorkers[t]->join();
+        delete PoolWorkers[t];
+        PoolWorkers[t] = NULL;
+    }
+    PoolStarted = 0;
+    PoolStop.store(false);
+}
@@ -0,0 +1,64 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// ============================================================================
+// THREAD_POOL.H - Work-stealing parallel-for
+// ============================================================================
+// Worker threads are started on first use and then wait for work, so a
+// parallel loop costs a wake-up instead of a thread start. The calling
+// thread always takes part as worker 0.
+//
+// A loop over [0, count) is cut into one contiguous range per worker. Each
+// worker takes grain items at a time from the front of its own range; a
+// worker whose range is empty takes grain items from the back of another's.
+// Items are never run twice or skipped, but which worker runs which item is
+// not fixed, so loop bodies must only write per-item data or per-worker
+// partials.
+// ============================================================================
+
+// Most threads taking part in a loop (caller included)
+#define POOL_MAX_THREADS 16
+
+// Grain of the per-train tick loops (region bands, switch entry counts,
+// arrivals and trace rows). No loop is this big, so they run on one thread:
+// they hold at most MAX_TRAINS items, and sharing loops that small has not
+// been measured to help. setPoolMinItems() turns them on, e.g. for tests.
+#define POOL_TICK_GRAIN 0x7FFFFFFF
+
+// ----------------------------------------------------------------------------
+// SETTINGS
+// ----------------------------------------------------------------------------
+// Threads taking part in a loop (0 = one per core, the default; 1 = none).
+void setPoolThreads(int threads);
+
+// Threads the next loop may use (caller included, at least 1).
+int getPoolThreads();
+
+// Smallest loop the tick shares out (0 = each loop's own size, the default).
+// A small value makes every level use the threaded tick loops (see
+// POOL_TICK_GRAIN), e.g. to test them. Results are the same either way.
+void setPoolMinItems(int items);
+
+// Grain for a loop whose own size is grain: the setPoolMinItems() value if
+// one is set, else grain.
+int getPoolGrain(int grain);
+
+// Whether idle workers take items from busy ones (the default). Without it
+// each worker runs exactly its own range, so every worker takes part in
+// every shared loop however the threads are scheduled; tests use this.
+void setPoolStealing(bool enabled);
+
+// ----------------------------------------------------------------------------
+// PARALLEL FOR
+// ----------------------------------------------------------------------------
+// Calls body(begin, end, worker) over disjoint ranges covering [0, count),
+// worker being 0 .. getPoolThreads() - 1. Ranges hold at least grain items
+// (except the last of a worker), and a loop of at most grain items runs on
+// the calling thread alone, so grain is also the size below which a loop is
+// not worth sharing. Returns when every item is done.
+void parallelFor(int count, int grain, void (*body)(int begin, int end, int worker));
+
+// Stop the worker threads (also runs at exit).
+void shutdownPool();
+
+#endif
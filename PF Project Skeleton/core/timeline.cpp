@@ -0,0 +1,168 @@
+#include "timeline.h"
+#include "simulation_state.h"
+#include "simulation.h"
+#include "snapshot.h"
+#include "journal.h"
+#include "cycle.h"
+#include "heatmap.h"
+#include "io.h"
+#include "log_writer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// ============================================================================
+// TIMELINE.CPP - Checkpoints and seeking
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// CHECKPOINT STORE
+// ----------------------------------------------------------------------------
+// One block of MaxCheckpoints snapshot slots, filled in tick order.
+// ----------------------------------------------------------------------------
+static unsigned char* CheckpointData = NULL;
+static int* CheckpointTick = NULL;
+static int MaxCheckpoints = 0;
+static int CheckpointCount = 0;
+static int CheckpointInterval = TIMELINE_DEFAULT_INTERVAL;
+static int CheckpointBytes = 0;
+static int TimelineEnd = 0;
+static bool TimelineReady = false;
+
+static unsigned char* getCheckpointSlot(int index) {
+    return CheckpointData + (size_t)index * CheckpointBytes;
+}
+
+// ----------------------------------------------------------------------------
+// Budget is full: keep every other checkpoint (the first always stays) and
+// take them half as often from now on.
+// ----------------------------------------------------------------------------
+static void thinCheckpoints() {
+    int kept = 0;
+    for (int i = 0; i < CheckpointCount; i += 2) {
+        if (i != kept) {
+            memcpy(getCheckpointSlot(kept), getCheckpointSlot(i), CheckpointBytes);
+            CheckpointTick[kept] = CheckpointTick[i];
+        }
+        kept++;
+    }
+    CheckpointCount = kept;
+    CheckpointInterval *= 2;
+}
+
+static void saveCheckpoint() {
+    if (CheckpointCount == MaxCheckpoints) thinCheckpoints();
+    saveSnapshot(getCheckpointSlot(CheckpointCount));
+    CheckpointTick[CheckpointCount] = CurrentTick;
+    CheckpointCount++;
+}
+
+// ----------------------------------------------------------------------------
+// INITIALIZE TIMELINE
+// ----------------------------------------------------------------------------
+bool initializeTimeline(int interval, long budgetBytes) {
+    TimelineReady = false;
+    CheckpointBytes = getSnapshotSize();
+    long slots = budgetBytes / CheckpointBytes;
+    if (slots < 2) slots = 2;
+
+    free(CheckpointData);
+    free(CheckpointTick);
+    CheckpointData = (unsigned char*)malloc((size_t)slots * CheckpointBytes);
+    CheckpointTick = (int*)malloc(sizeof(int) * slots);
+    if (!CheckpointData || !CheckpointTick) {
+        printf("Error: Not enough memory for %ld checkpoints\n", slots);
+        return false;
+    }
+
+    MaxCheckpoints = (int)slots;
+    CheckpointCount = 0;
+    CheckpointInterval = interval > 0 ? interval : 1;
+    TimelineEnd = CurrentTick;
+    TimelineReady = true;
+    saveCheckpoint();
+    startHeatHistory();
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// UPDATE TIMELINE
+// ----------------------------------------------------------------------------
+// Checkpoints sit on a grid of CheckpointInterval ticks from the first one.
+// Re-simulated ticks behind the last checkpoint save nothing.
+// ----------------------------------------------------------------------------
+void updateTimeline() {
+    if (!TimelineReady) return;
+    if (CurrentTick > TimelineEnd) TimelineEnd = CurrentTick;
+    if (CurrentTick > CheckpointTick[CheckpointCount - 1] &&
+        (CurrentTick - CheckpointTick[0]) % CheckpointInterval == 0) {
+        saveCheckpoint();
+    }
+}
+
+// ----------------------------------------------------------------------------
+// DISCARD CHECKPOINTS AFTER
+// ----------------------------------------------------------------------------
+void discardCheckpointsAfter(int tick) {
+    if (!TimelineReady) return;
+    while (CheckpointCount > 1 && CheckpointTick[CheckpointCount - 1] > tick) CheckpointCount--;
+    if (TimelineEnd > tick) TimelineEnd = tick;
+    truncateHeatHistory(tick);
+}
+
+// ----------------------------------------------------------------------------
+// SEEK TO TICK
+// ----------------------------------------------------------------------------
+// Going forward from the current tick needs no restore when no checkpoint
+// lies in between.
+// ----------------------------------------------------------------------------
+bool seekToTick(int tick) {
+    if (!TimelineReady) return false;
+    if (tick < CheckpointTick[0]) tick = CheckpointTick[0];
+
+    // Last checkpoint at or before the target (ticks are increasing)
+    int low = 0, high = CheckpointCount - 1;
+    while (low < high) {
+        int mid = (low + high + 1) / 2;
+        if (CheckpointTick[mid] <= tick) low = mid;
+        else high = mid - 1;
+    }
+
+    if (CurrentTick > tick || CurrentTick < CheckpointTick[low]) {
+        // Ticks from the target on are logged again when played
+        if (CurrentTick > tick) truncateLogStreams(tick);
+        restoreSnapshot(getCheckpointSlot(low));
+        rewindJournal();
+        resetCycleDetection();
+        if (!rebuildHeatmap()) {
+            printf("Warning: heatmap restarted at tick %d (no memory left for its history)\n", CurrentTick);
+        }
+    }
+
+    // Catch up without touching the log files
+    bool logging = isLoggingEnabled();
+    setLoggingEnabled(false);
+    while (CurrentTick < tick) {
+        applyJournalInputs();
+        simulateOneTick();
+        updateTimeline();
+    }
+    applyJournalInputs();
+    setLoggingEnabled(logging);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// QUERIES
+// ----------------------------------------------------------------------------
+int getTimelineEnd() {
+    return TimelineEnd;
+}
+
+int getCheckpointCount() {
+    return CheckpointCount;
+}
+
+int getCheckpointInterval() {
+    return CheckpointInterval;
+}
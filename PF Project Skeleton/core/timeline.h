@@ -0,0 +1,58 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+// ============================================================================
+// TIMELINE.H - Checkpoints and seeking
+// ============================================================================
+// While a session runs, a snapshot is kept every K ticks inside a fixed
+// memory budget. When the budget is full every other checkpoint is dropped
+// and K doubles, so any length of run fits and checkpoints stay evenly
+// spread.
+//
+// Seeking to a tick restores the nearest checkpoint at or before it and
+// re-simulates the rest headlessly (no logs), replaying the journaled inputs.
+// A seek costs at most K ticks of simulation, so stepping back is instant.
+// The heatmap is rebuilt for the restored tick from its event history, so
+// totals and windows match an unbroken run. Seeking back cuts the CSV logs
+// at the target tick, so ticks played again are logged once and the files
+// stay in tick order.
+// ============================================================================
+
+// DEFAULTS
+#define TIMELINE_DEFAULT_INTERVAL 16
+#define TIMELINE_DEFAULT_BUDGET (64L * 1024 * 1024)
+
+// ----------------------------------------------------------------------------
+// SETUP
+// ----------------------------------------------------------------------------
+// Start a timeline at the current state (after initializeSimulation).
+// interval = ticks between checkpoints, budget = bytes for all of them.
+bool initializeTimeline(int interval, long budgetBytes);
+
+// ----------------------------------------------------------------------------
+// RECORDING
+// ----------------------------------------------------------------------------
+// Call after every tick; saves a checkpoint when one is due.
+void updateTimeline();
+
+// Forget checkpoints after tick (the state from there on changed).
+void discardCheckpointsAfter(int tick);
+
+// ----------------------------------------------------------------------------
+// SEEKING
+// ----------------------------------------------------------------------------
+// Move the simulation to tick (0 to anything ahead). Returns false if no
+// timeline was started.
+bool seekToTick(int tick);
+
+// ----------------------------------------------------------------------------
+// QUERIES
+// ----------------------------------------------------------------------------
+// Furthest tick reached so far (right end of the scrubber).
+int getTimelineEnd();
+
+// Checkpoints held and the current spacing between them.
+int getCheckpointCount();
+int getCheckpointInterval();
+
+#endif
@@ -0,0 +1,713 @@
+#include "trace_index.h"
+#include "trains.h"
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ============================================================================
+// TRACE_INDEX.CPP - Random access into a recorded trace.csv
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// INDEX FILE LAYOUT
+// ----------------------------------------------------------------------------
+// TRACE_HEADER_FIELDS 64-bit values, then the tables in this order (wider
+// elements first, so every table stays aligned in the mapping):
+//   TickOffset     u64 [ticks + 1]    first row of tick t; [ticks] = file end
+//   TrainRunStart  u32 [trains + 1]   runs of train t: [start[t], start[t+1])
+//   RunStartTick, RunEndTick, RunCol, RunRow, RunTrain    i32 [runs] each
+//   BucketStart    u32 [buckets + 1]  runs in block b: [start[b], start[b+1])
+//   BucketRuns     u32 [entries]
+//   RunDir, RunStep, RunState         u8 [runs] each
+// Runs are sorted by train, then by tick. RunCol/RunRow is the first cell;
+// a moving run (step 1) is at first + (tick - start) * delta(dir).
+// ----------------------------------------------------------------------------
+#define TRACE_MAGIC 0x3158444952544253ULL   // "SBTRIDX1"
+#define TRACE_VERSION 1
+#define TRACE_HEADER_FIELDS 16
+#define TRACE_TAIL_BYTES 256
+
+// Header fields
+#define HDR_MAGIC 0
+#define HDR_VERSION 1
+#define HDR_TRACE_SIZE 2
+#define HDR_TRACE_MTIME 3
+#define HDR_TRACE_TAIL 4
+#define HDR_ROWS 5
+#define HDR_TICKS 6
+#define HDR_TRAINS 7
+#define HDR_RUNS 8
+#define HDR_BLOCK_COLS 9
+#define HDR_BLOCK_ROWS 10
+#define HDR_BUCKET_ENTRIES 11
+
+// Run steps (unknown until a run has its second row)
+#define TRACE_STEP_HELD 0
+#define TRACE_STEP_MOVING 1
+#define TRACE_STEP_UNKNOWN 2
+
+// Names used in trace.csv (see log_writer.cpp)
+static const char* TraceDirNames[4] = { "UP", "RIGHT", "DOWN", "LEFT" };
+static const char* TraceStateNames[4] = { "SCHEDULED", "RUNNING", "ARRIVED", "CRASHED" };
+
+// ----------------------------------------------------------------------------
+// OPEN INDEX
+// ----------------------------------------------------------------------------
+static const char* TraceData = NULL;
+static long TraceSize = 0;
+static const char* IndexData = NULL;
+static long IndexSize = 0;
+
+static long NumRows = 0;
+static int NumTicks = 0;
+static int NumTrains = 0;
+static long NumRuns = 0;
+static int BlockCols = 0;
+static int BlockRows = 0;
+
+static const unsigned long long* TickOffset = NULL;
+static const unsigned int* TrainRunStart = NULL;
+static const int* RunStartTick = NULL;
+static const int* RunEndTick = NULL;
+static const int* RunCol = NULL;
+static const int* RunRow = NULL;
+static const int* RunTrain = NULL;
+static const unsigned int* BucketStart = NULL;
+static const unsigned int* BucketRuns = NULL;
+static const unsigned char* RunDir = NULL;
+static const unsigned char* RunStep = NULL;
+static const unsigned char* RunState = NULL;
+
+// ----------------------------------------------------------------------------
+// BUILD STATE
+// ----------------------------------------------------------------------------
+// Runs are collected as rows of RUN_FIELDS ints in the order they start.
+// BuildOpenRun[t] is train t's newest run (-1 before its first row).
+// ----------------------------------------------------------------------------
+#define RUN_START 0
+#define RUN_END 1
+#define RUN_COL 2
+#define RUN_ROW 3
+#define RUN_TRAIN 4
+#define RUN_DIR 5
+#define RUN_STEP 6
+#define RUN_STATE 7
+#define RUN_FIELDS 8
+
+static int* BuildRuns = NULL;
+static long BuildRunCount = 0;
+static long BuildRunCapacity = 0;
+static unsigned long long* BuildTickOffset = NULL;
+static long BuildTickCapacity = 0;
+static long* BuildOpenRun = NULL;
+static int BuildTrainCapacity = 0;
+
+// ----------------------------------------------------------------------------
+// Maps a whole file read-only. An empty file maps to "" (size 0).
+// Returns NULL if it cannot be opened.
+// ----------------------------------------------------------------------------
+static const char* mapFile(const char* path, long* size, long long* mtime) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return NULL;
+    }
+    *size = (long)info.st_size;
+    if (mtime) *mtime = (long long)info.st_mtime;
+
+    const char* data = "";
+    if (*size > 0) {
+        void* mapped = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+        data = (mapped == MAP_FAILED) ? NULL : (const char*)mapped;
+    }
+    close(fd);
+    return data;
+}
+
+static void unmapFile(const char* data, long size) {
+    if (data && size > 0) munmap((void*)data, size);
+}
+
+// ----------------------------------------------------------------------------
+// FNV-1a of the last bytes of the trace, so an index is not reused for a
+// trace that was rewritten with the same size and modification second.
+// ----------------------------------------------------------------------------
+static unsigned long long hashTraceTail(const char* data, long size) {
+    unsigned long long hash = 1469598103934665603ULL;
+    long from = size > TRACE_TAIL_BYTES ? size - TRACE_TAIL_BYTES : 0;
+    for (long i = from; i < size; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// ----------------------------------------------------------------------------
+// BUILD HELPERS
+// ----------------------------------------------------------------------------
+static void freeBuildState() {
+    free(BuildRuns);
+    free(BuildTickOffset);
+    free(BuildOpenRun);
+    BuildRuns = NULL;
+    BuildTickOffset = NULL;
+    BuildOpenRun = NULL;
+    BuildRunCount = BuildRunCapacity = BuildTickCapacity = 0;
+    BuildTrainCapacity = 0;
+}
+
+// Doubles a capacity until it holds needed. Returns the new capacity.
+static long grownCapacity(long capacity, long needed, long minimum) {
+    if (capacity < minimum) capacity = minimum;
+    while (capacity < needed) capacity *= 2;
+    return capacity;
+}
+
+static bool growRuns(long needed) {
+    if (needed <= BuildRunCapacity) return true;
+    long capacity = grownCapacity(BuildRunCapacity, needed, 4096);
+    int* runs = (int*)realloc(BuildRuns, sizeof(int) * RUN_FIELDS * capacity);
+    if (!runs) return false;
+    BuildRuns = runs;
+    BuildRunCapacity = capacity;
+    return true;
+}
+
+static bool growTicks(long needed) {
+    if (needed <= BuildTickCapacity) return true;
+    long capacity = grownCapacity(BuildTickCapacity, needed, 4096);
+    unsigned long long* offsets = (unsigned long long*)realloc(BuildTickOffset, sizeof(unsigned long long) * capacity);
+    if (!offsets) return false;
+    BuildTickOffset = offsets;
+    BuildTickCapacity = capacity;
+    return true;
+}
+
+static bool growTrains(int needed) {
+    if (needed <= BuildTrainCapacity) return true;
+    int capacity = (int)grownCapacity(BuildTrainCapacity, needed, 128);
+    long* open = (long*)realloc(BuildOpenRun, sizeof(long) * capacity);
+    if (!open) return false;
+    for (int t = BuildTrainCapacity; t < capacity; t++) open[t] = -1;
+    BuildOpenRun = open;
+    BuildTrainCapacity = capacity;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Extends the train's newest run with this row, or starts a new run.
+// ----------------------------------------------------------------------------
+static bool addTraceRow(int tick, int train, int x, int y, int dir, int state) {
+    if (!growTrains(train + 1)) return false;
+
+    long open = BuildOpenRun[train];
+    if (open >= 0) {
+        int* run = BuildRuns + open * RUN_FIELDS;
+        if (run[RUN_END] + 1 == tick && run[RUN_DIR] == dir && run[RUN_STATE] == state) {
+            int dr, dc;
+            getDelta(dir, dr, dc);
+            int k = tick - run[RUN_START];
+            bool held = x == run[RUN_COL] && y == run[RUN_ROW];
+            bool moved = x == run[RUN_COL] + dc * k && y == run[RUN_ROW] + dr * k;
+            int step = run[RUN_STEP];
+            if ((held && step != TRACE_STEP_MOVING) || (moved && step != TRACE_STEP_HELD)) {
+                if (step == TRACE_STEP_UNKNOWN) run[RUN_STEP] = held ? TRACE_STEP_HELD : TRACE_STEP_MOVING;
+                run[RUN_END] = tick;
+                return true;
+            }
+        }
+    }
+
+    if (!growRuns(BuildRunCount + 1)) return false;
+    int* run = BuildRuns + BuildRunCount * RUN_FIELDS;
+    run[RUN_START] = tick;
+    run[RUN_END] = tick;
+    run[RUN_COL] = x;
+    run[RUN_ROW] = y;
+    run[RUN_TRAIN] = train;
+    run[RUN_DIR] = dir;
+    run[RUN_STEP] = TRACE_STEP_UNKNOWN;
+    run[RUN_STATE] = state;
+    BuildOpenRun[train] = BuildRunCount++;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// ROW PARSING
+// ----------------------------------------------------------------------------
+static bool parseNumber(const char*& p, const char* end, int& value) {
+    if (p >= end || *p < '0' || *p > '9') return false;
+    long number = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        number = number * 10 + (*p - '0');
+        if (number > 2000000000L) return false;
+        p++;
+    }
+    value = (int)number;
+    return true;
+}
+
+static bool parseComma(const char*& p, const char* end) {
+    if (p >= end || *p != ',') return false;
+    p++;
+    return true;
+}
+
+// Index of the name at p in names[], or -1.
+static int parseName(const char*& p, const char* end, const char* const* names, int count) {
+    const char* start = p;
+    while (p < end && *p != ',' && *p != '\n' && *p != '\r') p++;
+    int length = (int)(p - start);
+    for (int i = 0; i < count; i++) {
+        if ((int)strlen(names[i]) == length && strncmp(names[i], start, length) == 0) return i;
+    }
+    return -1;
+}
+
+// Parses "tick,train,x,y,DIR,STATE" and the line end.
+static bool parseTraceRow(const char*& p, const char* end, int& tick, int& train,
+                          int& x, int& y, int& dir, int& state) {
+    if (!parseNumber(p, end, tick) || !parseComma(p, end)) return false;
+    if (!parseNumber(p, end, train) || !parseComma(p, end)) return false;
+    if (!parseNumber(p, end, x) || !parseComma(p, end)) return false;
+    if (!parseNumber(p, end, y) || !parseComma(p, end)) return false;
+    dir = parseName(p, end, TraceDirNames, 4);
+    if (dir < 0 || !parseComma(p, end)) return false;
+    state = parseName(p, end, TraceStateNames, 4);
+    if (state < 0) return false;
+    if (p < end && *p == '\r') p++;
+    if (p < end && *p != '\n') return false;
+    if (p < end) p++;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Writes count ints of one run field, in train order.
+// ----------------------------------------------------------------------------
+static bool writeRunField(FILE* f, const long* order, long count, int field, bool asBytes) {
+    const long CHUNK = 16384;
+    int ints[CHUNK];
+    unsigned char bytes[CHUNK];
+    for (long first = 0; first < count; first += CHUNK) {
+        long n = count - first < CHUNK ? count - first : CHUNK;
+        for (long i = 0; i < n; i++) {
+            int value = BuildRuns[order[first + i] * RUN_FIELDS + field];
+            if (field == RUN_STEP && value == TRACE_STEP_UNKNOWN) value = TRACE_STEP_HELD;
+            ints[i] = value;
+            bytes[i] = (unsigned char)value;
+        }
+        size_t written = asBytes ? fwrite(bytes, 1, n, f) : fwrite(ints, sizeof(int), n, f);
+        if (written != (size_t)n) return false;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// For every block a run passes through: counts it (counts != NULL) or adds
+// the run to the block's entries.
+// ----------------------------------------------------------------------------
+static void forEachRunBlock(const int* run, int blockCols, unsigned int* counts, unsigned int* cursor,
+                            unsigned int* entries, unsigned int runIndex) {
+    int dr, dc;
+    getDelta(run[RUN_DIR], dr, dc);
+    int cells = (run[RUN_STEP] == TRACE_STEP_MOVING) ? run[RUN_END] - run[RUN_START] + 1 : 1;
+    int lastBlock = -1;
+    for (int k = 0; k < cells; k++) {
+        int x = run[RUN_COL] + dc * k;
+        int y = run[RUN_ROW] + dr * k;
+        int block = (y / TRACE_BLOCK) * blockCols + x / TRACE_BLOCK;
+        if (block == lastBlock) continue;
+        lastBlock = block;
+        if (counts) counts[block + 1]++;
+        else entries[cursor[block]++] = runIndex;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Writes the index from the build state.
+// ----------------------------------------------------------------------------
+static bool writeTraceIndex(const char* indexPath, unsigned long long* header, int maxX, int maxY) {
+    long runs = BuildRunCount;
+    int trains = (int)header[HDR_TRAINS];
+    int ticks = (int)header[HDR_TICKS];
+    int blockCols = maxX / TRACE_BLOCK + 1;
+    int blockRows = maxY / TRACE_BLOCK + 1;
+    int buckets = blockCols * blockRows;
+    if (runs > 0xFFFFFFFFL) {
+        printf("Error: Trace has too many runs to index\n");
+        return false;
+    }
+
+    // Sort runs by train (stable, so each train's runs stay in tick order)
+    unsigned int* trainStart = (unsigned int*)calloc(trains + 1, sizeof(unsigned int));
+    unsigned int* bucketStart = (unsigned int*)calloc(buckets + 1, sizeof(unsigned int));
+    unsigned int* cursor = (unsigned int*)malloc(sizeof(unsigned int) * (buckets > trains ? buckets : trains + 1));
+    long* order = (long*)malloc(sizeof(long) * (runs > 0 ? runs : 1));
+    unsigned int* entries = NULL;
+    FILE* f = NULL;
+    bool ok = trainStart && bucketStart && cursor && order;
+
+    if (ok) {
+        for (long r = 0; r < runs; r++) trainStart[BuildRuns[r * RUN_FIELDS + RUN_TRAIN] + 1]++;
+        for (int t = 0; t < trains; t++) trainStart[t + 1] += trainStart[t];
+        for (int t = 0; t < trains; t++) cursor[t] = trainStart[t];
+        for (long r = 0; r < runs; r++) order[cursor[BuildRuns[r * RUN_FIELDS + RUN_TRAIN]]++] = r;
+
+        // Buckets: count, then fill (entries are sorted run indexes)
+        for (long i = 0; i < runs; i++) {
+            forEachRunBlock(BuildRuns + order[i] * RUN_FIELDS, blockCols, bucketStart, NULL, NULL, 0);
+        }
+        for (int b = 0; b < buckets; b++) bucketStart[b + 1] += bucketStart[b];
+        entries = (unsigned int*)malloc(sizeof(unsigned int) * (bucketStart[buckets] > 0 ? bucketStart[buckets] : 1));
+        ok = entries != NULL;
+    }
+    if (ok) {
+        for (int b = 0; b < buckets; b++) cursor[b] = bucketStart[b];
+        for (long i = 0; i < runs; i++) {
+            forEachRunBlock(BuildRuns + order[i] * RUN_FIELDS, blockCols, NULL, cursor, entries, (unsigned int)i);
+        }
+        header[HDR_BLOCK_COLS] = blockCols;
+        header[HDR_BLOCK_ROWS] = blockRows;
+        header[HDR_BUCKET_ENTRIES] = bucketStart[buckets];
+
+        f = fopen(indexPath, "wb");
+        ok = f != NULL;
+    }
+    if (ok) {
+        ok = fwrite(header, sizeof(unsigned long long), TRACE_HEADER_FIELDS, f) == TRACE_HEADER_FIELDS &&
+             fwrite(BuildTickOffset, sizeof(unsigned long long), ticks + 1, f) == (size_t)(ticks + 1) &&
+             fwrite(trainStart, sizeof(unsigned int), trains + 1, f) == (size_t)(trains + 1) &&
+             writeRunField(f, order, runs, RUN_START, false) &&
+             writeRunField(f, order, runs, RUN_END, false) &&
+             writeRunField(f, order, runs, RUN_COL, false) &&
+             writeRunField(f, order, runs, RUN_ROW, false) &&
+             writeRunField(f, order, runs, RUN_TRAIN, false) &&
+             fwrite(bucketStart, sizeof(unsigned int), buckets + 1, f) == (size_t)(buckets + 1) &&
+             fwrite(entries, sizeof(unsigned int), bucketStart[buckets], f) == bucketStart[buckets] &&
+             writeRunField(f, order, runs, RUN_DIR, true) &&
+             writeRunField(f, order, runs, RUN_STEP, true) &&
+             writeRunField(f, order, runs, RUN_STATE, true);
+        if (fclose(f) != 0) ok = false;
+        if (!ok) remove(indexPath);
+    }
+    if (!ok) printf("Error: Could not write index %s\n", indexPath);
+
+    free(trainStart);
+    free(bucketStart);
+    free(cursor);
+    free(order);
+    free(entries);
+    return ok;
+}
+
+// ----------------------------------------------------------------------------
+// BUILD TRACE INDEX
+// ----------------------------------------------------------------------------
+bool buildTraceIndex(const char* tracePath, const char* indexPath) {
+    long size;
+    long long mtime;
+    const char* data = mapFile(tracePath, &size, &mtime);
+    if (!data) {
+        printf("Error: Could not open %s\n", tracePath);
+        return false;
+    }
+    if (size > 0) madvise((void*)data, size, MADV_SEQUENTIAL);
+
+    const char* p = data;
+    const char* end = data + size;
+    if (size < 5 || strncmp(data, "Tick,", 5) != 0) {
+        printf("Error: %s is not a trace.csv\n", tracePath);
+        unmapFile(data, size);
+        return false;
+    }
+    const char* newline = (const char*)memchr(p, '\n', size);
+    p = newline ? newline + 1 : end;
+
+    freeBuildState();
+    long rows = 0;
+    int lastTick = -1;
+    int maxTrain = -1, maxX = 0, maxY = 0;
+    int line = 1;
+    bool ok = growTicks(1);
+    while (ok && p < end) {
+        line++;
+        if (*p == '\n') {
+            p++;
+            continue;
+        }
+        const char* rowStart = p;
+        int tick, train, x, y, dir, state;
+        if (!parseTraceRow(p, end, tick, train, x, y, dir, state)) {
+            const char* rowEnd = (const char*)memchr(rowStart, '\n', end - rowStart);
+            int length = (int)((rowEnd ? rowEnd : end) - rowStart);
+            printf("Error: Bad trace row on line %d: %.*s\n", line, length > 80 ? 80 : length, rowStart);
+            ok = false;
+            break;
+        }
+        if (tick < lastTick) {
+            printf("Error: Trace rows are not in tick order (line %d)\n", line);
+            ok = false;
+            break;
+        }
+        // Ticks without rows start where the next row does
+        if (!growTicks((long)tick + 2)) ok = false;
+        while (ok && lastTick < tick) BuildTickOffset[++lastTick] = (unsigned long long)(rowStart - data);
+        if (ok) ok = addTraceRow(tick, train, x, y, dir, state);
+        if (!ok) printf("Error: Not enough memory to index %s\n", tracePath);
+
+        rows++;
+        if (train > maxTrain) maxTrain = train;
+        if (x > maxX) maxX = x;
+        if (y > maxY) maxY = y;
+    }
+
+    if (ok) {
+        BuildTickOffset[lastTick + 1] = (unsigned long long)size;
+        unsigned long long header[TRACE_HEADER_FIELDS];
+        memset(header, 0, sizeof(header));
+        header[HDR_MAGIC] = TRACE_MAGIC;
+        header[HDR_VERSION] = TRACE_VERSION;
+        header[HDR_TRACE_SIZE] = (unsigned long long)size;
+        header[HDR_TRACE_MTIME] = (unsigned long long)mtime;
+        header[HDR_TRACE_TAIL] = hashTraceTail(data, size);
+        header[HDR_ROWS] = rows;
+        header[HDR_TICKS] = lastTick + 1;
+        header[HDR_TRAINS] = maxTrain + 1;
+        header[HDR_RUNS] = BuildRunCount;
+        ok = writeTraceIndex(indexPath, header, maxX, maxY);
+    }
+
+    freeBuildState();
+    unmapFile(data, size);
+    return ok;
+}
+
+// ----------------------------------------------------------------------------
+// OPEN / CLOSE
+// ----------------------------------------------------------------------------
+void closeTraceIndex() {
+    unmapFile(TraceData, TraceSize);
+    unmapFile(IndexData, IndexSize);
+    TraceData = IndexData = NULL;
+    TraceSize = IndexSize = 0;
+    NumRows = NumRuns = 0;
+    NumTicks = NumTrains = 0;
+}
+
+bool openTraceIndex(const char* tracePath, const char* indexPath) {
+    closeTraceIndex();
+    long long mtime;
+    TraceData = mapFile(tracePath, &TraceSize, &mtime);
+    IndexData = mapFile(indexPath, &IndexSize, NULL);
+    const unsigned long long* header = (const unsigned long long*)IndexData;
+    bool ok = TraceData && IndexData && IndexSize >= (long)(TRACE_HEADER_FIELDS * sizeof(unsigned long long)) &&
+              header[HDR_MAGIC] == TRACE_MAGIC && header[HDR_VERSION] == TRACE_VERSION &&
+              header[HDR_TRACE_SIZE] == (unsigned long long)TraceSize &&
+              header[HDR_TRACE_MTIME] == (unsigned long long)mtime &&
+              header[HDR_TRACE_TAIL] == hashTraceTail(TraceData, TraceSize);
+    if (!ok) {
+        closeTraceIndex();
+        return false;
+    }
+
+    NumRows = (long)header[HDR_ROWS];
+    NumTicks = (int)header[HDR_TICKS];
+    NumTrains = (int)header[HDR_TRAINS];
+    NumRuns = (long)header[HDR_RUNS];
+    BlockCols = (int)header[HDR_BLOCK_COLS];
+    BlockRows = (int)header[HDR_BLOCK_ROWS];
+    long buckets = (long)BlockCols * BlockRows;
+    long entries = (long)header[HDR_BUCKET_ENTRIES];
+
+    const char* p = IndexData + TRACE_HEADER_FIELDS * sizeof(unsigned long long);
+    TickOffset = (const unsigned long long*)p;    p += sizeof(unsigned long long) * (NumTicks + 1);
+    TrainRunStart = (const unsigned int*)p;       p += sizeof(unsigned int) * (NumTrains + 1);
+    RunStartTick = (const int*)p;                 p += sizeof(int) * NumRuns;
+    RunEndTick = (const int*)p;                   p += sizeof(int) * NumRuns;
+    RunCol = (const int*)p;                       p += sizeof(int) * NumRuns;
+    RunRow = (const int*)p;                       p += sizeof(int) * NumRuns;
+    RunTrain = (const int*)p;                     p += sizeof(int) * NumRuns;
+    BucketStart = (const unsigned int*)p;         p += sizeof(unsigned int) * (buckets + 1);
+    BucketRuns = (const unsigned int*)p;          p += sizeof(unsigned int) * entries;
+    RunDir = (const unsigned char*)p;             p += NumRuns;
+    RunStep = (const unsigned char*)p;            p += NumRuns;
+    RunState = (const unsigned char*)p;           p += NumRuns;
+
+    if (p - IndexData != IndexSize) {
+        printf("Error: Index %s is damaged\n", indexPath);
+        closeTraceIndex();
+        return false;
+    }
+    return true;
+}
+
+bool loadTraceIndex(const char* tracePath, const char* indexPath) {
+    if (openTraceIndex(tracePath, indexPath)) return true;
+    return buildTraceIndex(tracePath, indexPath) && openTraceIndex(tracePath, indexPath);
+}
+
+// ----------------------------------------------------------------------------
+// QUERY HELPERS
+// ----------------------------------------------------------------------------
+static void printTraceRow(FILE* out, int tick, int train, int x, int y, int dir, int state) {
+    fprintf(out, "%d,%d,%d,%d,%s,%s\n", tick, train, x, y, TraceDirNames[dir], TraceStateNames[state]);
+}
+
+// First run of a train that ends at or after tick (binary search).
+static long findTrainRun(int trainId, int tick) {
+    long lo = TrainRunStart[trainId];
+    long hi = TrainRunStart[trainId + 1];
+    while (lo < hi) {
+        long mid = (lo + hi) / 2;
+        if (RunEndTick[mid] < tick) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static int compareKeys(const void* a, const void* b) {
+    unsigned long long x = *(const unsigned long long*)a;
+    unsigned long long y = *(const unsigned long long*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// ----------------------------------------------------------------------------
+// QUERY: TRAIN OVER A TICK WINDOW
+// ----------------------------------------------------------------------------
+long queryTraceTrain(int trainId, int fromTick, int toTick, FILE* out) {
+    if (!IndexData || trainId < 0 || trainId >= NumTrains) return 0;
+    long rows = 0;
+    long last = TrainRunStart[trainId + 1];
+    for (long r = findTrainRun(trainId, fromTick); r < last && RunStartTick[r] <= toTick; r++) {
+        int dr, dc;
+        getDelta(RunDir[r], dr, dc);
+        int first = RunStartTick[r] > fromTick ? RunStartTick[r] : fromTick;
+        int stop = RunEndTick[r] < toTick ? RunEndTick[r] : toTick;
+        for (int tick = first; tick <= stop; tick++) {
+            int k = (tick - RunStartTick[r]) * RunStep[r];
+            printTraceRow(out, tick, trainId, RunCol[r] + dc * k, RunRow[r] + dr * k, RunDir[r], RunState[r]);
+            rows++;
+        }
+    }
+    return rows;
+}
+
+// ----------------------------------------------------------------------------
+// QUERY: ALL TRAINS AT A TICK
+// ----------------------------------------------------------------------------
+// The tick's rows are one contiguous byte range of the trace.
+// ----------------------------------------------------------------------------
+long queryTraceTick(int tick, FILE* out) {
+    if (!IndexData || tick < 0 || tick >= NumTicks) return 0;
+    const char* first = TraceData + TickOffset[tick];
+    long length = (long)(TickOffset[tick + 1] - TickOffset[tick]);
+    fwrite(first, 1, length, out);
+    if (length > 0 && first[length - 1] != '\n') fputc('\n', out);
+
+    long rows = 0;
+    for (const char* p = first; p < first + length; p++) {
+        if (*p == '\n') rows++;
+    }
+    if (length > 0 && first[length - 1] != '\n') rows++;
+    return rows;
+}
+
+// ----------------------------------------------------------------------------
+// QUERY: VISITS TO A CELL
+// ----------------------------------------------------------------------------
+// Only runs in the cell's block are checked. Hits are sorted as
+// tick << 32 | run; runs are in train order, so this is (tick, train) order.
+// ----------------------------------------------------------------------------
+long queryTraceCell(int x, int y, int fromTick, int toTick, FILE* out) {
+    if (!IndexData || x < 0 || y < 0) return 0;
+    int bx = x / TRACE_BLOCK;
+    int by = y / TRACE_BLOCK;
+    if (bx >= BlockCols || by >= BlockRows) return 0;
+    int block = by * BlockCols + bx;
+
+    unsigned long long* hits = NULL;
+    long count = 0, capacity = 0;
+    for (unsigned int e = BucketStart[block]; e < BucketStart[block + 1]; e++) {
+        unsigned int r = BucketRuns[e];
+        int dr, dc;
+        getDelta(RunDir[r], dr, dc);
+
+        // Ticks of the run spent on (x, y)
+        int first, stop;
+        if (RunStep[r] == TRACE_STEP_MOVING) {
+            int k = (x - RunCol[r]) * dc + (y - RunRow[r]) * dr;
+            if (k < 0 || RunCol[r] + dc * k != x || RunRow[r] + dr * k != y) continue;
+            first = stop = RunStartTick[r] + k;
+            if (first > RunEndTick[r]) continue;
+        } else {
+            if (RunCol[r] != x || RunRow[r] != y) continue;
+            first = RunStartTick[r];
+            stop = RunEndTick[r];
+        }
+        if (first < fromTick) first = fromTick;
+        if (stop > toTick) stop = toTick;
+
+        for (int tick = first; tick <= stop; tick++) {
+            if (count == capacity) {
+                capacity = grownCapacity(capacity, count + 1, 1024);
+                unsigned long long* bigger = (unsigned long long*)realloc(hits, sizeof(unsigned long long) * capacity);
+                if (!bigger) {
+                    printf("Error: Not enough memory for the query\n");
+                    free(hits);
+                    return 0;
+                }
+                hits = bigger;
+            }
+            hits[count++] = ((unsigned long long)tick << 32) | r;
+        }
+    }
+
+    if (count > 1) qsort(hits, count, sizeof(unsigned long long), compareKeys);
+    for (long i = 0; i < count; i++) {
+        unsigned int r = (unsigned int)(hits[i] & 0xFFFFFFFFULL);
+        printTraceRow(out, (int)(hits[i] >> 32), RunTrain[r], x, y, RunDir[r], RunState[r]);
+    }
+    free(hits);
+    return count;
+}
+
+// ----------------------------------------------------------------------------
+// READ TRACE TICK
+// ----------------------------------------------------------------------------
+int readTraceTick(int tick, int* trains, int* cols, int* rows, int* dirs, int* states, int cap) {
+    if (!IndexData || tick < 0 || tick >= NumTicks) return 0;
+    const char* p = TraceData + TickOffset[tick];
+    const char* end = TraceData + TickOffset[tick + 1];
+    int count = 0;
+    while (p < end && count < cap) {
+        int rowTick;
+        if (!parseTraceRow(p, end, rowTick, trains[count], cols[count], rows[count],
+                           dirs[count], states[count])) break;
+        count++;
+    }
+    return count;
+}
+
+// ----------------------------------------------------------------------------
+// INDEX INFO
+// ----------------------------------------------------------------------------
+long getIndexedRows() {
+    return NumRows;
+}
+
+int getIndexedTicks() {
+    return NumTicks;
+}
+
+int getIndexedTrains() {
+    return NumTrains;
+}
+
+long getIndexedRuns() {
+    return NumRuns;
+}
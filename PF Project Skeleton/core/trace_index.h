@@ -0,0 +1,68 @@
+#ifndef TRACE_INDEX_H
+#define TRACE_INDEX_H
+
+#include <cstdio>
+
+// ============================================================================
+// TRACE_INDEX.H - Random access into a recorded trace.csv
+// ============================================================================
+// A sidecar index (<trace>.idx) is built in one streaming pass over the
+// memory-mapped trace. It holds:
+//   - the byte offset of the first row of every tick
+//   - per train, a list of runs: ticks during which the train held still or
+//     moved straight one cell per tick with the same direction and state, so
+//     any tick inside a run is known without reading the trace
+//   - for every 8x8 block of cells, the runs that pass through it
+//
+// Both files are mapped, never read whole, so queries cost the same on a
+// multi-gigabyte trace as on a small one. Rows must be in tick order (as the
+// simulator writes them). Query results are the matching trace rows, in file
+// order, in the same format as trace.csv.
+// ============================================================================
+
+// Cells per side of a spatial bucket
+#define TRACE_BLOCK 8
+
+// ----------------------------------------------------------------------------
+// BUILD / OPEN
+// ----------------------------------------------------------------------------
+// Scan tracePath and write its index to indexPath. Returns false on a bad
+// row (the line is printed) or an I/O error.
+bool buildTraceIndex(const char* tracePath, const char* indexPath);
+
+// Map a trace and its index. Returns false if either is missing or the index
+// was built from a different version of the trace (rebuild it then).
+bool openTraceIndex(const char* tracePath, const char* indexPath);
+
+// Open the index, building it first if it is missing or stale.
+bool loadTraceIndex(const char* tracePath, const char* indexPath);
+
+// Unmap both files.
+void closeTraceIndex();
+
+// ----------------------------------------------------------------------------
+// QUERIES (on the open index; each returns the number of rows written)
+// ----------------------------------------------------------------------------
+// Rows of one train with fromTick <= tick <= toTick.
+long queryTraceTrain(int trainId, int fromTick, int toTick, FILE* out);
+
+// Every row of one tick.
+long queryTraceTick(int tick, FILE* out);
+
+// Rows at column x, row y with fromTick <= tick <= toTick.
+long queryTraceCell(int x, int y, int fromTick, int toTick, FILE* out);
+
+// Parses the rows of one tick (only those bytes of the trace are read) into
+// the arrays; states use the TrainState codes. Returns the number of rows
+// stored (at most cap).
+int readTraceTick(int tick, int* trains, int* cols, int* rows, int* dirs, int* states, int cap);
+
+// ----------------------------------------------------------------------------
+// INDEX INFO
+// ----------------------------------------------------------------------------
+long getIndexedRows();
+int getIndexedTicks();      // Last tick + 1
+int getIndexedTrains();     // Highest train id + 1
+long getIndexedRuns();
+
+#endif
@@ -2,6 +2,11 @@
 #include "simulation_state.h"
 #include "grid.h"
 #include "switches.h"
+#include "heatmap.h"
+#include "state_hash.h"
+#include "routing.h"
+#include "rng.h"
+#include "thread_pool.h"
 #include <cstdlib>
 
 // ============================================================================
@@ -20,63 +25,159 @@ void getDelta(int dir, int &dr, int &dc) {
     else if (dir == DIR_LEFT) dc = -1;
 }
 
+// ----------------------------------------------------------------------------
+// Collision priority: ticks along the track to the train's own destination
+// (the nearest 'D' if it has none), or ROUTE_UNREACHABLE.
+// ----------------------------------------------------------------------------
 int calculateDistance(int trainIdx) {
+    return getTrainRouteDistance(trainIdx, TrainCurrentRow[trainIdx], TrainCurrentCol[trainIdx],
+                                 TrainCurrentDir[trainIdx]);
+}
+
+// ----------------------------------------------------------------------------
+// Manhattan distance to the train's own destination (the nearest 'D' if it
+// has none). Pairs of trains without destinations use it, as before routing.
+// ----------------------------------------------------------------------------
+int calculateManhattanDistance(int trainIdx) {
     int r = TrainCurrentRow[trainIdx];
     int c = TrainCurrentCol[trainIdx];
+    if (TrainDestRow[trainIdx] >= 0) {
+        return abs(TrainDestRow[trainIdx] - r) + abs(TrainDestCol[trainIdx] - c);
+    }
+
     int minDist = 99999;
     bool found = false;
-    for (int i = 0; i < LevelNumRows; i++) {
-        for (int j = 0; j < LevelNumCols; j++) {
-            if (TheGrid[i][j] == 'D') {
-                int dist = abs(i - r) + abs(j - c);
-                if (dist < minDist) minDist = dist;
-                found = true;
+    for (int k = 0; k < GridChunkCount; k++) {
+        int r0, c0, r1, c1;
+        getChunkBounds(k, r0, c0, r1, c1);
+        for (int i = r0; i < r1; i++) {
+            for (int j = c0; j < c1; j++) {
+                if (getTileClass(i, j) == TILE_DEST) {
+                    int dist = abs(i - r) + abs(j - c);
+                    if (dist < minDist) minDist = dist;
+                    found = true;
+                }
             }
         }
     }
     return found ? minDist : 0;
 }
 
+// ----------------------------------------------------------------------------
+// TRAIN LISTS
+// ----------------------------------------------------------------------------
+// Trains not spawned yet wait in SpawnOrder, sorted by spawn tick (then
+// index), from SpawnNext on. When their tick comes they move to SpawnReady
+// (index order) until their start cell is free. A blocked train's spawn tick
+// only moves on to the next tick, so a ready train stays ready.
+// ----------------------------------------------------------------------------
+static int SpawnOrder[MAX_TRAINS];
+static int SpawnOrderCount = 0;
+static int SpawnNext = 0;
+static int SpawnReady[MAX_TRAINS];
+static int SpawnReadyCount = 0;
+static int SpawnedNow[MAX_TRAINS];      // Spawned this tick, in index order
+static int TrainListBuilds = 0;
+
+static int compareSpawnOrder(const void* a, const void* b) {
+    int i = *(const int*)a;
+    int j = *(const int*)b;
+    if (TrainSpawnTicks[i] != TrainSpawnTicks[j]) return TrainSpawnTicks[i] < TrainSpawnTicks[j] ? -1 : 1;
+    return i - j;
+}
+
+void rebuildTrainLists() {
+    ActiveTrainCount = 0;
+    FinishedTrainCount = 0;
+    SpawnOrderCount = 0;
+    for (int i = 0; i < TotalScheduledTrains; i++) {
+        if (TrainState[i] == 1) ActiveTrainList[ActiveTrainCount++] = i;
+        else if (TrainState[i] == 0) SpawnOrder[SpawnOrderCount++] = i;
+    }
+    if (SpawnOrderCount > 1) qsort(SpawnOrder, SpawnOrderCount, sizeof(int), compareSpawnOrder);
+    SpawnNext = 0;
+    SpawnReadyCount = 0;
+    TrainListBuilds++;
+}
+
+int getWaitingTrainCount() {
+    return SpawnOrderCount - SpawnNext + SpawnReadyCount;
+}
+
+int getTrainListBuilds() {
+    return TrainListBuilds;
+}
+
+// ----------------------------------------------------------------------------
+// True if one of the listed trains stands on (r, c).
+// ----------------------------------------------------------------------------
+static bool isTrainOnCell(const int* trains, int count, int r, int c) {
+    for (int k = 0; k < count; k++) {
+        int j = trains[k];
+        if (TrainCurrentRow[j] == r && TrainCurrentCol[j] == c) return true;
+    }
+    return false;
+}
+
 // ----------------------------------------------------------------------------
 // SPAWN TRAINS FOR CURRENT TICK
 // ----------------------------------------------------------------------------
 // Activate trains scheduled for this tick.
 // ----------------------------------------------------------------------------
 void spawnTrainsForTick() {
-    for (int i = 0; i < TotalScheduledTrains ; i++) 
-    {
-        if (TrainSpawnTicks[i] <= CurrentTick && TrainState[i] == 0) { 
-            
-            int r = TrainStartRow[i];
-            int c = TrainStartCol[i];
-           
-            bool blocked = false;
-           
-            for (int j = 0; j < TotalScheduledTrains; j++) {
-                if (TrainState[j] == 1 && TrainCurrentRow[j] == r && TrainCurrentCol[j] == c) {
-                    blocked = true;
-                    break;
-                }
-            }
-            
-            if (blocked) {
-                // If it is blocked, wait until next tick
-                TrainSpawnTicks[i]++; 
-            } else {
-                // spawn the train
-                TrainIsActive[i] = true;
-                TrainState[i] = 1;
-                TrainCurrentRow[i] = r;
-                TrainCurrentCol[i] = c;
-                TrainCurrentDir[i] = TrainStartDir[i];
-                
-                // Initialize Next to avoid glitches
-                TrainNextRow[i] = r;
-                TrainNextCol[i] = c;
-                TrainNextDir[i] = TrainStartDir[i];
-            }
+    // Trains whose tick has come join the ready ones (index order)
+    while (SpawnNext < SpawnOrderCount && TrainSpawnTicks[SpawnOrder[SpawnNext]] <= CurrentTick) {
+        int i = SpawnOrder[SpawnNext++];
+        int k = SpawnReadyCount++;
+        while (k > 0 && SpawnReady[k - 1] > i) {
+            SpawnReady[k] = SpawnReady[k - 1];
+            k--;
         }
+        SpawnReady[k] = i;
     }
+    if (SpawnReadyCount == 0) return;
+
+    int spawned = 0;
+    int waiting = 0;
+    for (int k = 0; k < SpawnReadyCount; k++) {
+        int i = SpawnReady[k];
+        int r = TrainStartRow[i];
+        int c = TrainStartCol[i];
+
+        bool blocked = isTrainOnCell(ActiveTrainList, ActiveTrainCount, r, c) ||
+                       isTrainOnCell(SpawnedNow, spawned, r, c);
+
+        if (blocked) {
+            // If it is blocked, wait until next tick
+            TrainSpawnTicks[i]++;
+            refreshTrainHash(i);
+            SpawnReady[waiting++] = i;
+        } else {
+            // spawn the train
+            TrainIsActive[i] = true;
+            TrainState[i] = 1;
+            TrainCurrentRow[i] = r;
+            TrainCurrentCol[i] = c;
+            TrainCurrentDir[i] = TrainStartDir[i];
+            refreshTrainHash(i);
+
+            // Initialize Next to avoid glitches
+            TrainNextRow[i] = r;
+            TrainNextCol[i] = c;
+            TrainNextDir[i] = TrainStartDir[i];
+            SpawnedNow[spawned++] = i;
+        }
+    }
+    SpawnReadyCount = waiting;
+
+    // Merge the new trains into the running list, from the back
+    int a = ActiveTrainCount - 1;
+    int b = spawned - 1;
+    for (int out = ActiveTrainCount + spawned - 1; b >= 0; out--) {
+        if (a >= 0 && ActiveTrainList[a] > SpawnedNow[b]) ActiveTrainList[out] = ActiveTrainList[a--];
+        else ActiveTrainList[out] = SpawnedNow[b--];
+    }
+    ActiveTrainCount += spawned;
 }
 
 // ----------------------------------------------------------------------------
@@ -96,9 +197,9 @@ bool determineNextPosition(int i) {
     int nextDir = dir;
     // Handles Crossing
     if (isInBounds(nextR, nextC)) {
-        char tile = TheGrid[nextR][nextC];
+        char tile = getTile(nextR, nextC);
         if (tile == '+') {
-            nextDir = getSmartDirectionAtCrossing(nextR, nextC, dir);
+            nextDir = getSmartDirectionAtCrossing(nextR, nextC, dir, i);
         } else {
             // Handles Curves and Switches
             nextDir = getNextDirection(nextR, nextC, dir, tile);
@@ -132,32 +233,37 @@ int getNextDirection(int r, int c, int dir, char tile) {
         if (dir == DIR_LEFT) return DIR_UP; // Left -> Up
         if (dir == DIR_DOWN) return DIR_RIGHT; // Down -> Right
     }
-    // Switches (A-Z)
-    else if (tile >= 'A' && tile <= 'Z') {
-        int idx = tile - 'A';
-        int state = SwitchCurrentState[idx];
-        
-        if (state == 0) {
-            return dir;
-        }
-        else {
-            // Try Right Turn
-            int rightDir = (dir + 1) % 4;
-            int dr, dc;
-            getDelta(rightDir, dr, dc);
-            
-            if (isTrackTile(r + dr, c + dc)) {
-                return rightDir;
-            }
-            
-            // Try Left Turn (fallback)
-            int leftDir = (dir + 3) % 4;
-            getDelta(leftDir, dr, dc);
-            if(isTrackTile(r + dr, c + dc)) {
-                return leftDir;
-            }
-            return dir;
-        }
+    // Switches (A-Z, named)
+    else {
+        int idx = getSwitchIndex(r, c);
+        if (idx >= 0) return getSwitchExitDirection(r, c, dir, SwitchCurrentState[idx]);
+    }
+    return dir;
+}
+
+// ----------------------------------------------------------------------------
+// GET SWITCH EXIT DIRECTION
+// ----------------------------------------------------------------------------
+// Direction out of the switch on (r, c) when it is in the given state.
+// ----------------------------------------------------------------------------
+int getSwitchExitDirection(int r, int c, int dir, int state) {
+    if (state == 0) {
+        return dir;
+    }
+    // Try Right Turn
+    int rightDir = (dir + 1) % 4;
+    int dr, dc;
+    getDelta(rightDir, dr, dc);
+
+    if (isTrackTile(r + dr, c + dc)) {
+        return rightDir;
+    }
+
+    // Try Left Turn (fallback)
+    int leftDir = (dir + 3) % 4;
+    getDelta(leftDir, dr, dc);
+    if(isTrackTile(r + dr, c + dc)) {
+        return leftDir;
     }
     return dir;
 }
@@ -165,21 +271,48 @@ int getNextDirection(int r, int c, int dir, char tile) {
 // ----------------------------------------------------------------------------
 // SMART ROUTING AT CROSSING - Route train to its matched destination
 // ----------------------------------------------------------------------------
-// Choose best direction at '+' toward destination.
+// Choose best direction at '+' toward the train's destination (any 'D' if
+// it has none): the exit with the shortest route along the track (see
+// routing.h). Only if no exit leads there the old Manhattan guess is used.
 // ----------------------------------------------------------------------------
-int getSmartDirectionAtCrossing(int r, int c, int currentDir) { 
+int getSmartDirectionAtCrossing(int r, int c, int currentDir, int trainId) { 
+    // Candidates: Straight, Left Turn, Right Turn (ties keep this order)
+    int routeCandidates[3] = { currentDir, (currentDir + 3) % 4, (currentDir + 1) % 4 };
+    int routeDir = -1;
+    int routeDist = ROUTE_UNREACHABLE;
+    for (int k = 0; k < 3; k++) {
+        int dr, dc;
+        getDelta(routeCandidates[k], dr, dc);
+        if (!isTrackTile(r + dr, c + dc)) continue;
+        int dist = getTrainRouteDistance(trainId, r, c, routeCandidates[k]);
+        if (dist < routeDist) {
+            routeDist = dist;
+            routeDir = routeCandidates[k];
+        }
+    }
+    if (routeDir >= 0) return routeDir;
+
      int destR = -1, destC = -1;
      int minDistFound = 99999;
-   // Flag to break nested loops
-    // Simple search for any 'D'
-    for(int i = 0; i < LevelNumRows; i++) {
-        for(int j = 0; j < LevelNumCols; j++) {
-            if(TheGrid[i][j] == 'D') {
+     if (TrainDestRow[trainId] >= 0) {
+        destR = TrainDestRow[trainId];
+        destC = TrainDestCol[trainId];
+        minDistFound = 0; // Own destination, skip the search
+     }
+    // Simple search for the nearest 'D' (ties go to the first in reading
+    // order, as chunks are not visited in that order)
+    for (int k = 0; k < GridChunkCount; k++) {
+        int r0, c0, r1, c1;
+        getChunkBounds(k, r0, c0, r1, c1);
+        for (int i = r0; i < r1; i++) {
+            for (int j = c0; j < c1; j++) {
+                if (getTileClass(i, j) != TILE_DEST) continue;
                 int d = abs(i - r) + abs(j - c);
-                if (d < minDistFound) { 
-                    minDistFound = d; 
-                    destR=i; 
-                    destC=j; 
+                if (d < minDistFound ||
+                    (d == minDistFound && (i < destR || (i == destR && j < destC)))) {
+                    minDistFound = d;
+                    destR = i;
+                    destC = j;
                 }
             }
         }
@@ -225,28 +358,85 @@ int getSmartDirectionAtCrossing(int r, int c, int currentDir) {
 // Fill next positions/directions for all trains.
 // ----------------------------------------------------------------------------
 void determineAllRoutes() {
-    for (int i = 0; i < TotalScheduledTrains; i++) {
-        if (TrainState[i] == 1) { // Active
-            determineNextPosition(i);
-        }
+    for (int k = 0; k < ActiveTrainCount; k++) {
+        determineNextPosition(ActiveTrainList[k]);
     }
 }
 
+// ----------------------------------------------------------------------------
+// PLAN TRAIN MOVE
+// ----------------------------------------------------------------------------
+// Route, emergency halt and weather for one train. Each step only reads the
+// train's own planned move, so doing all three per train gives the same
+// result as the three whole-fleet passes.
+// ----------------------------------------------------------------------------
+void planTrainMove(int i) {
+    determineNextPosition(i);
+    holdIfHalted(i);
+    delayForWeather(i);
+}
+
+// Trains that were going to move and lost a collision this tick (read and
+// cleared by moveAllTrains for the hold heatmap). Written only for the pair
+// being resolved, like TrainNextRow, so region bands can share it.
+static bool TrainHeldBack[MAX_TRAINS];
+
 // ----------------------------------------------------------------------------
 // MOVE ALL TRAINS (PHASE 5)
 // ----------------------------------------------------------------------------
-// Move trains; resolve collisions and apply effects.
+// Move trains to their planned (collision-checked) cells and apply effects.
 // ----------------------------------------------------------------------------
 void moveAllTrains() {
-    detectCollisions();
-    for (int i = 0; i < TotalScheduledTrains; i++) {
-        if (TrainState[i] == 1) {
-            TrainCurrentRow[i] = TrainNextRow[i];
-            TrainCurrentCol[i] = TrainNextCol[i];
-            TrainCurrentDir[i] = TrainNextDir[i];
-            // Switch counter update removed from here (handled in simulation.cpp)
+    for (int k = 0; k < ActiveTrainCount; k++) {
+        int i = ActiveTrainList[k];
+        // Lost a collision this tick: counts towards the congestion heatmap
+        if (TrainHeldBack[i]) {
+            TrainHeldBack[i] = false;
+            recordHeat(HEAT_HOLD, TrainCurrentRow[i], TrainCurrentCol[i]);
         }
+        bool changed = TrainCurrentRow[i] != TrainNextRow[i] ||
+                       TrainCurrentCol[i] != TrainNextCol[i] ||
+                       TrainCurrentDir[i] != TrainNextDir[i];
+        TrainCurrentRow[i] = TrainNextRow[i];
+        TrainCurrentCol[i] = TrainNextCol[i];
+        TrainCurrentDir[i] = TrainNextDir[i];
+        if (changed) refreshTrainHash(i);
+        // Switch counter update removed from here (handled in simulation.cpp)
+    }
+}
+
+// ----------------------------------------------------------------------------
+// APPLY WEATHER EFFECTS
+// ----------------------------------------------------------------------------
+// RAIN: wheels slip and a moving train loses the tick now and then.
+// FOG: drivers cannot see far, so a train may wait before entering a switch
+// or crossing. Each decision is drawn from (seed, tick, train), so it does
+// not depend on the order trains are handled in.
+// ----------------------------------------------------------------------------
+void delayForWeather(int i) {
+    if (GameWeather == WEATHER_NORMAL) return;
+    int nr = TrainNextRow[i];
+    int nc = TrainNextCol[i];
+    if (nr == TrainCurrentRow[i] && nc == TrainCurrentCol[i]) return;
+
+    bool delayed = false;
+    if (GameWeather == WEATHER_RAIN) {
+        delayed = rngChance(GameSeed, CurrentTick, i, RNG_STREAM_RAIN, 1, RAIN_SLIP_CHANCE);
+    } else if (GameWeather == WEATHER_FOG && isInBounds(nr, nc)) {
+        int tileClass = getTileClass(nr, nc);
+        bool blind = tileClass == TILE_CROSSING || tileClass == TILE_SWITCH;
+        delayed = blind && rngChance(GameSeed, CurrentTick, i, RNG_STREAM_FOG, 1, FOG_CAUTION_CHANCE);
     }
+    if (delayed) {
+        TrainNextRow[i] = TrainCurrentRow[i];
+        TrainNextCol[i] = TrainCurrentCol[i];
+        TrainNextDir[i] = TrainCurrentDir[i];
+    }
+}
+
+void applyWeatherEffects() {
+    if (GameWeather == WEATHER_NORMAL) return;
+    for (int k = 0; k < ActiveTrainCount; k++) delayForWeather(ActiveTrainList[k]);
 }
 
 // ----------------------------------------------------------------------------
@@ -254,39 +444,52 @@ void moveAllTrains() {
 // ----------------------------------------------------------------------------
 // Resolve same-tile, swap, and crossing conflicts.
 // ----------------------------------------------------------------------------
-void detectCollisions() {
-    for (int i = 0; i < TotalScheduledTrains; i++) {
-        if (TrainState[i] != 1) continue;
-
-        for (int j = i + 1; j < TotalScheduledTrains; j++) {
-            if (TrainState[j] != 1) continue;
-            
-            bool collision = false;
-            if (TrainNextRow[i] == TrainNextRow[j] && TrainNextCol[i] == TrainNextCol[j]) {
-               collision = true;
-            }
-            else if (TrainNextRow[i] == TrainCurrentRow[j] && TrainNextCol[i] == TrainCurrentCol[j] &&
-                     TrainNextRow[j] == TrainCurrentRow[i] && TrainNextCol[j] == TrainCurrentCol[i]) {
-                collision = true;
-            }
+static void holdBack(int i) {
+    if (TrainNextRow[i] != TrainCurrentRow[i] || TrainNextCol[i] != TrainCurrentCol[i]) {
+        TrainHeldBack[i] = true;
+    }
+    TrainNextRow[i] = TrainCurrentRow[i];
+    TrainNextCol[i] = TrainCurrentCol[i];
+}
 
-            if (collision) {
-                int distI = calculateDistance(i);
-                int distJ  = calculateDistance(j);
-
-                if (distI > distJ) {
-                    TrainNextRow[j] = TrainCurrentRow[j];
-                    TrainNextCol[j] = TrainCurrentCol[j];
-                } 
-                else if (distJ > distI) {
-                    TrainNextRow[i] = TrainCurrentRow[i];
-                    TrainNextCol[i] = TrainCurrentCol[i];
-                } 
-                else {
-                    TrainNextRow[j] = TrainCurrentRow[j];
-                    TrainNextCol[j] = TrainCurrentCol[j];
-                }
+void resolveCollisionPair(int i, int j) {
+    bool collision = false;
+    if (TrainNextRow[i] == TrainNextRow[j] && TrainNextCol[i] == TrainNextCol[j]) {
+       collision = true;
+    }
+    else if (TrainNextRow[i] == TrainCurrentRow[j] && TrainNextCol[i] == TrainCurrentCol[j] &&
+             TrainNextRow[j] == TrainCurrentRow[i] && TrainNextCol[j] == TrainCurrentCol[i]) {
+        collision = true;
+    }
+
+    if (collision) {
+        int distI, distJ;
+        if (TrainDestRow[i] < 0 && TrainDestRow[j] < 0) {
+            // Neither has its own destination: the original priority
+            distI = calculateManhattanDistance(i);
+            distJ = calculateManhattanDistance(j);
+        } else {
+            distI = calculateDistance(i);
+            distJ = calculateDistance(j);
+            if (distI == ROUTE_UNREACHABLE && distJ == ROUTE_UNREACHABLE) {
+                distI = calculateManhattanDistance(i);
+                distJ = calculateManhattanDistance(j);
             }
+            // A train that cannot arrive yields to one that can
+            else if (distI == ROUTE_UNREACHABLE) distI = -1;
+            else if (distJ == ROUTE_UNREACHABLE) distJ = -1;
+        }
+
+        if (distI > distJ) holdBack(j);
+        else if (distJ > distI) holdBack(i);
+        else holdBack(j);
+    }
+}
+
+void detectCollisions() {
+    for (int a = 0; a < ActiveTrainCount; a++) {
+        for (int b = a + 1; b < ActiveTrainCount; b++) {
+            resolveCollisionPair(ActiveTrainList[a], ActiveTrainList[b]);
         }
     }
 }
@@ -294,35 +497,183 @@ void detectCollisions() {
 // ----------------------------------------------------------------------------
 // CHECK ARRIVALS
 // ----------------------------------------------------------------------------
-// Mark trains that reached destinations.
+// Mark trains that reached destinations. Trains are checked on the thread
+// pool; each worker collects its trains' hash changes in its own slot. The
+// finished trains then leave the running list.
 // ----------------------------------------------------------------------------
+static unsigned long long ArrivalHashChange[POOL_MAX_THREADS * 8];   // Slots a cache line apart
+
+// Pool loop body: checks running trains begin .. end - 1 of the list.
+static void checkArrivalRange(int begin, int end, int worker) {
+    unsigned long long change = 0;
+    for (int k = begin; k < end; k++) {
+        int i = ActiveTrainList[k];
+        int r = TrainCurrentRow[i];
+        int c = TrainCurrentCol[i];
+        // Off the map has no tile to classify (the chunk directory is not
+        // indexed with -1 or past the level)
+        bool onMap = isInBounds(r, c);
+
+        // Checks Arrival
+        if (onMap && getTileClass(r, c) == TILE_DEST) {
+            TrainState[i] = 2; // Arrived
+            TrainIsActive[i] = false;
+            change ^= takeTrainHashChange(i);
+        }
+        // Checks Crash 
+        else if (!onMap || !isTrackTile(r , c) ) 
+        {
+            TrainState[i] = 3; // Crashed
+            TrainIsActive[i] = false;
+            change ^= takeTrainHashChange(i);
+        }
+    }
+    ArrivalHashChange[worker * 8] ^= change;
+}
+
 void checkArrivals() {
-    for (int i = 0; i < TotalScheduledTrains; i++) {
-        if (TrainState[i] == 1) {
-            int r = TrainCurrentRow[i];
-            int c = TrainCurrentCol[i];
-
-            // Checks Arrival
-            if (TheGrid[r][c] == 'D') {
-                TrainState[i] = 2; // Arrived
-                TrainIsActive[i] = false;
-            }
-            // Checks Crash 
-            else if (!isInBounds(r, c) || !isTrackTile(r , c) ) 
-            {
-                TrainState[i] = 3; // Crashed
-                TrainIsActive[i] = false;
-            }
+    parallelFor(ActiveTrainCount, getPoolGrain(POOL_TICK_GRAIN), checkArrivalRange);
+    int workers = getPoolThreads();
+    for (int w = 0; w < workers; w++) {
+        applyHashChange(ArrivalHashChange[w * 8]);
+        ArrivalHashChange[w * 8] = 0;
+    }
+
+    int running = 0;
+    FinishedTrainCount = 0;
+    for (int k = 0; k < ActiveTrainCount; k++) {
+        int i = ActiveTrainList[k];
+        if (TrainState[i] == 1) ActiveTrainList[running++] = i;
+        else FinishedTrainList[FinishedTrainCount++] = i;
+    }
+    ActiveTrainCount = running;
+}
+
+// ----------------------------------------------------------------------------
+// HALT ZONE SPATIAL INDEX
+// ----------------------------------------------------------------------------
+// The map is cut into HALT_BUCKET x HALT_BUCKET buckets. Each bucket keeps a
+// linked list of the active zones overlapping it, so a train only tests the
+// few zones near it instead of every zone.
+// ----------------------------------------------------------------------------
+#define HALT_BUCKET 8
+#define HALT_BUCKET_ROWS ((MAX_ROWS + HALT_BUCKET - 1) / HALT_BUCKET)
+#define HALT_BUCKET_COLS ((MAX_COLS + HALT_BUCKET - 1) / HALT_BUCKET)
+#define HALT_MAX_ENTRIES (MAX_HALT_ZONES * HALT_BUCKET_ROWS * HALT_BUCKET_COLS)
+
+static int HaltBucketHead[HALT_BUCKET_ROWS][HALT_BUCKET_COLS];
+static int HaltEntryZone[HALT_MAX_ENTRIES];
+static int HaltEntryNext[HALT_MAX_ENTRIES];
+static int HaltEntryCount = 0;
+
+// Adds zone z to every bucket its bounding box touches.
+static void indexHaltZone(int z) {
+    for (int br = HaltZoneTop[z] / HALT_BUCKET; br <= HaltZoneBottom[z] / HALT_BUCKET; br++) {
+        for (int bc = HaltZoneLeft[z] / HALT_BUCKET; bc <= HaltZoneRight[z] / HALT_BUCKET; bc++) {
+            HaltEntryZone[HaltEntryCount] = z;
+            HaltEntryNext[HaltEntryCount] = HaltBucketHead[br][bc];
+            HaltBucketHead[br][bc] = HaltEntryCount;
+            HaltEntryCount++;
         }
     }
 }
 
+// True if zone z covers cell (r, c).
+static bool haltZoneContains(int z, int r, int c) {
+    if (r < HaltZoneTop[z] || r > HaltZoneBottom[z] ||
+        c < HaltZoneLeft[z] || c > HaltZoneRight[z]) return false;
+    if (HaltZoneRadius[z] < 0) return true;
+    int dr = r - HaltZoneCenterRow[z];
+    int dc = c - HaltZoneCenterCol[z];
+    return dr * dr + dc * dc <= HaltZoneRadius[z] * HaltZoneRadius[z];
+}
+
+// ----------------------------------------------------------------------------
+// REBUILD HALT INDEX
+// ----------------------------------------------------------------------------
+// Rebuilds every bucket list from the active zones.
+// ----------------------------------------------------------------------------
+void rebuildHaltIndex() {
+    for (int br = 0; br < HALT_BUCKET_ROWS; br++) {
+        for (int bc = 0; bc < HALT_BUCKET_COLS; bc++) HaltBucketHead[br][bc] = -1;
+    }
+    HaltEntryCount = 0;
+    for (int z = 0; z < MAX_HALT_ZONES; z++) {
+        if (HaltZoneActive[z]) indexHaltZone(z);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// ADD HALT ZONE
+// ----------------------------------------------------------------------------
+// Takes a free slot, clips the bounding box to the map and indexes it.
+// Returns the zone id, or -1 if the zone is empty or all slots are in use.
+// ----------------------------------------------------------------------------
+static int addHaltZone(int top, int left, int bottom, int right,
+                       int centerRow, int centerCol, int radius, int ticks) {
+    if (top < 0) top = 0;
+    if (left < 0) left = 0;
+    if (bottom >= LevelNumRows) bottom = LevelNumRows - 1;
+    if (right >= LevelNumCols) right = LevelNumCols - 1;
+    if (ticks <= 0 || top > bottom || left > right) return -1;
+
+    for (int z = 0; z < MAX_HALT_ZONES; z++) {
+        if (HaltZoneActive[z]) continue;
+        HaltZoneActive[z] = true;
+        HaltZoneTop[z] = top;
+        HaltZoneLeft[z] = left;
+        HaltZoneBottom[z] = bottom;
+        HaltZoneRight[z] = right;
+        HaltZoneCenterRow[z] = centerRow;
+        HaltZoneCenterCol[z] = centerCol;
+        HaltZoneRadius[z] = radius;
+        HaltZoneTimer[z] = ticks;
+        ActiveHaltZones++;
+        indexHaltZone(z);
+        return z;
+    }
+    return -1;
+}
+
+int addHaltZoneRect(int top, int left, int bottom, int right, int ticks) {
+    return addHaltZone(top, left, bottom, right, -1, -1, -1, ticks);
+}
+
+int addHaltZoneRadius(int r, int c, int radius, int ticks) {
+    if (radius < 0) return -1;
+    return addHaltZone(r - radius, c - radius, r + radius, c + radius, r, c, radius, ticks);
+}
+
+// ----------------------------------------------------------------------------
+// IS CELL HALTED
+// ----------------------------------------------------------------------------
+// Looks only at the zones listed in the cell's bucket.
+// ----------------------------------------------------------------------------
+bool isCellHalted(int r, int c) {
+    if (ActiveHaltZones == 0 || !isInBounds(r, c)) return false;
+    for (int e = HaltBucketHead[r / HALT_BUCKET][c / HALT_BUCKET]; e >= 0; e = HaltEntryNext[e]) {
+        if (haltZoneContains(HaltEntryZone[e], r, c)) return true;
+    }
+    return false;
+}
+
 // ----------------------------------------------------------------------------
 // APPLY EMERGENCY HALT
 // ----------------------------------------------------------------------------
-// Apply halt to trains in the active zone.
+// Apply halt to trains in the active zone: they keep their place this tick.
+// Runs after routing and before movement, so collision checks see them as
+// standing still.
 // ----------------------------------------------------------------------------
+void holdIfHalted(int i) {
+    if (ActiveHaltZones == 0 || !isCellHalted(TrainCurrentRow[i], TrainCurrentCol[i])) return;
+    TrainNextRow[i] = TrainCurrentRow[i];
+    TrainNextCol[i] = TrainCurrentCol[i];
+    TrainNextDir[i] = TrainCurrentDir[i];
+}
+
 void applyEmergencyHalt() {
+    if (ActiveHaltZones == 0) return;
+    for (int k = 0; k < ActiveTrainCount; k++) holdIfHalted(ActiveTrainList[k]);
 }
 
 // ----------------------------------------------------------------------------
@@ -331,4 +682,16 @@ void applyEmergencyHalt() {
 // Decrement timer and disable when done.
 // ----------------------------------------------------------------------------
 void updateEmergencyHalt() {
+    if (ActiveHaltZones == 0) return;
+    bool expired = false;
+    for (int z = 0; z < MAX_HALT_ZONES; z++) {
+        if (!HaltZoneActive[z]) continue;
+        HaltZoneTimer[z]--;
+        if (HaltZoneTimer[z] <= 0) {
+            HaltZoneActive[z] = false;
+            ActiveHaltZones--;
+            expired = true;
+        }
+    }
+    if (expired) rebuildHaltIndex();
 }
\ No newline at end of file
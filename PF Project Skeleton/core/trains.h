@@ -11,33 +11,69 @@
 // Spawn trains scheduled for the current tick.
 void spawnTrainsForTick();
 
+// ----------------------------------------------------------------------------
+// TRAIN LISTS
+// ----------------------------------------------------------------------------
+// Recompute the running list and the spawn queue from TrainState (after a
+// level load or snapshot restore).
+void rebuildTrainLists();
+
+// Trains not spawned yet (TrainState 0).
+int getWaitingTrainCount();
+
+// How many times the lists were rebuilt: a change means train states may
+// have jumped instead of following ticks.
+int getTrainListBuilds();
+
 // ----------------------------------------------------------------------------
 // TRAIN ROUTING
 // ----------------------------------------------------------------------------
 // Compute routes for all trains (Phase 2).
 void determineAllRoutes();
 
+// Row/column step for a direction.
+void getDelta(int dir, int &dr, int &dc);
+
 // Compute next position/direction for a train.
 bool determineNextPosition(int trainId);
 
 // Get next direction on entering a tile.
 int getNextDirection(int r, int c, int currentDir, char tile);
 
-// Choose best direction at a crossing.
-int getSmartDirectionAtCrossing(int r, int c, int currentDir);
+// Exit direction of a switch tile for a given switch state.
+int getSwitchExitDirection(int r, int c, int currentDir, int state);
+
+// Choose best direction at a crossing for train trainId.
+int getSmartDirectionAtCrossing(int r, int c, int currentDir, int trainId);
 
 // ----------------------------------------------------------------------------
 // TRAIN MOVEMENT
 // ----------------------------------------------------------------------------
-// Move trains and handle collisions (Phase 5).
+// Route, halt and weather for one active train (Phases 2 to 4).
+void planTrainMove(int trainId);
+
+// Move trains to their planned cells (Phase 5, after collision checks).
 void moveAllTrains();
 
+// ----------------------------------------------------------------------------
+// WEATHER
+// ----------------------------------------------------------------------------
+// Hold back trains delayed by rain or fog this tick (before collisions).
+void applyWeatherEffects();
+
+// Same for one active train.
+void delayForWeather(int trainId);
+
 // ----------------------------------------------------------------------------
 // COLLISION DETECTION
 // ----------------------------------------------------------------------------
 // Detect trains targeting the same tile/swap/crossing.
 void detectCollisions();
 
+// Check one pair (i < j) and hold back the loser; detectCollisions() calls
+// it for every active pair in (i, j) order.
+void resolveCollisionPair(int i, int j);
+
 // ----------------------------------------------------------------------------
 // ARRIVALS
 // ----------------------------------------------------------------------------
@@ -47,9 +83,25 @@ void checkArrivals();
 // ----------------------------------------------------------------------------
 // EMERGENCY HALT
 // ----------------------------------------------------------------------------
+// Halt trains inside a rectangle of cells (inclusive) for the given ticks.
+// Returns the zone id, or -1 if it could not be added.
+int addHaltZoneRect(int top, int left, int bottom, int right, int ticks);
+
+// Halt trains within radius cells of (r, c) for the given ticks.
+int addHaltZoneRadius(int r, int c, int radius, int ticks);
+
+// True if cell (r, c) is inside an active halt zone.
+bool isCellHalted(int r, int c);
+
+// Rebuild the zone lookup after zones were replaced (level load, snapshot).
+void rebuildHaltIndex();
+
 // Apply emergency halt in active zone.
 void applyEmergencyHalt();
 
+// Same for one active train.
+void holdIfHalted(int trainId);
+
 // Update emergency halt timer.
 void updateEmergencyHalt();
 
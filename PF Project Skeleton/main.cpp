@@ -1,30 +1,206 @@
-#include "core/io.h"
-#include "core/simulation.h"
+#include "core/switchback.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <unistd.h>
+#include <sys/ioctl.h>
 
 using namespace std;
 
+// ============================================================================
+// MAIN.CPP - Console frontend (uses only the switchback API)
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// CONSOLE FRAMEBUFFER
+// ----------------------------------------------------------------------------
+// ConsoleFrame is built each tick from the map with trains stamped on top.
+// ConsoleScreen holds what the terminal currently shows, so only cells that
+// differ are sent. All output for a tick goes out in one write. Buffers are
+// sized for the level when it is loaded.
+// ----------------------------------------------------------------------------
+static int MapRows = 0;
+static int MapCols = 0;
+static int TrainSlots = 0;
+static char* ConsoleFrame = NULL;
+static char* ConsoleScreen = NULL;
+static bool ConsoleScreenValid = false;
+static int* TrainRows = NULL;
+static int* TrainCols = NULL;
+static int* TrainStates = NULL;
+
+// Output buffer (large enough for a full redraw with cursor moves)
+static char* ConsoleOut = NULL;
+static int ConsoleOutSize = 0;
+static int ConsoleOutLen = 0;
+
+static void consoleAppend(const char* text, int len) {
+    if (ConsoleOutLen + len > ConsoleOutSize) return;
+    memcpy(ConsoleOut + ConsoleOutLen, text, len);
+    ConsoleOutLen += len;
+}
+
+// ----------------------------------------------------------------------------
+// Sizes the buffers for sim's map and trains. Returns false without memory.
+// ----------------------------------------------------------------------------
+static bool allocateConsole(int sim) {
+    sbGetMapSize(sim, &MapRows, &MapCols);
+    TrainSlots = sbGetTrains(sim, NULL, NULL, NULL, NULL, 0);
+    int cells = MapRows * MapCols;
+    ConsoleFrame = (char*)malloc(cells + 1);
+    ConsoleScreen = (char*)malloc(cells + 1);
+    TrainRows = (int*)malloc(sizeof(int) * (TrainSlots + 1));
+    TrainCols = (int*)malloc(sizeof(int) * (TrainSlots + 1));
+    TrainStates = (int*)malloc(sizeof(int) * (TrainSlots + 1));
+    ConsoleOutSize = cells * 12 + 4096;
+    ConsoleOut = (char*)malloc(ConsoleOutSize);
+    return ConsoleFrame && ConsoleScreen && TrainRows && TrainCols && TrainStates && ConsoleOut;
+}
+
+static void freeConsole() {
+    free(ConsoleFrame);
+    free(ConsoleScreen);
+    free(TrainRows);
+    free(TrainCols);
+    free(TrainStates);
+    free(ConsoleOut);
+}
+
+// ----------------------------------------------------------------------------
+// Whether the tick line, the map, the separator and the prompt under it fit
+// in the terminal window. Cursor moves address screen cells, so a map that
+// scrolls or wraps must be redrawn in full. An unknown size counts as fitting.
+// ----------------------------------------------------------------------------
+static bool fitsTerminal() {
+    struct winsize size;
+    if (ioctl(fileno(stdout), TIOCGWINSZ, &size) != 0 || size.ws_row == 0) return true;
+    int width = MapCols > 26 ? MapCols : 26; // Separator is 26 wide
+    return MapRows + 3 <= size.ws_row && width <= size.ws_col;
+}
+
+// ----------------------------------------------------------------------------
+// PRINT GRID
+// ----------------------------------------------------------------------------
+// Prints the map with active trains shown as their id (mod 10), lowest id on
+// top. On a terminal the first call draws the whole map and later calls only
+// move the cursor to changed cells (ANSI escapes); when output is redirected,
+// or the map does not fit in the window, the full map is printed every tick.
+// ----------------------------------------------------------------------------
+static void printGrid(int sim) {
+    // 1. Build the frame: map rows, then trains (highest id first)
+    sbGetMap(sim, ConsoleFrame, MapRows * MapCols);
+    sbGetTrains(sim, TrainRows, TrainCols, NULL, TrainStates, TrainSlots);
+    for (int i = TrainSlots - 1; i >= 0; i--) {
+        if (TrainStates[i] != SB_TRAIN_ACTIVE) continue;
+        int r = TrainRows[i];
+        int c = TrainCols[i];
+        if (r >= 0 && r < MapRows && c >= 0 && c < MapCols) {
+            ConsoleFrame[r * MapCols + c] = (char)('0' + i % 10);
+        }
+    }
+
+    int tick = sbGetTick(sim);
+    char line[64];
+    int len;
+    ConsoleOutLen = 0;
+    bool terminal = isatty(fileno(stdout));
+    bool fits = terminal && fitsTerminal();
+
+    if (!fits || !ConsoleScreenValid) {
+        // 2a. Whole map (clearing the screen first on a terminal)
+        if (terminal) consoleAppend("\x1b[H\x1b[2J", 7);
+        len = sprintf(line, "Tick: %d\n", tick);
+        consoleAppend(line, len);
+        for (int r = 0; r < MapRows; r++) {
+            consoleAppend(ConsoleFrame + r * MapCols, MapCols);
+            consoleAppend("\n", 1);
+        }
+        consoleAppend("--------------------------\n", 27);
+    } else {
+        // 2b. Only the tick line and the cells that changed
+        len = sprintf(line, "\x1b[1;1HTick: %d\x1b[K", tick);
+        consoleAppend(line, len);
+        for (int r = 0; r < MapRows; r++) {
+            int cursorCol = -1; // Column the cursor is at on this row, -1 = unknown
+            for (int c = 0; c < MapCols; c++) {
+                int cell = r * MapCols + c;
+                if (ConsoleFrame[cell] == ConsoleScreen[cell]) continue;
+                if (c != cursorCol) {
+                    // Screen row 1 is the tick line, so map row r is r + 2
+                    len = sprintf(line, "\x1b[%d;%dH", r + 2, c + 1);
+                    consoleAppend(line, len);
+                }
+                consoleAppend(&ConsoleFrame[cell], 1);
+                cursorCol = c + 1;
+            }
+        }
+        // Park the cursor below the separator line for the next prompt
+        len = sprintf(line, "\x1b[%d;1H", MapRows + 3);
+        consoleAppend(line, len);
+    }
+
+    // 3. Remember what the terminal now shows and send everything at once
+    memcpy(ConsoleScreen, ConsoleFrame, MapRows * MapCols);
+    ConsoleScreenValid = fits;
+
+    fwrite(ConsoleOut, 1, ConsoleOutLen, stdout);
+    fflush(stdout);
+}
+
+// ----------------------------------------------------------------------------
+// Cycle length and the trains trapped in it (the ones still on the track).
+// ----------------------------------------------------------------------------
+static void printCycleReport(int sim) {
+    printf("Livelock: the state after tick %d repeats every %d ticks.\n",
+           sbGetCycleStart(sim), sbGetCycleLength(sim));
+    printf("Trapped trains:");
+    sbGetTrains(sim, NULL, NULL, NULL, TrainStates, TrainSlots);
+    for (int i = 0; i < TrainSlots; i++) {
+        if (TrainStates[i] == SB_TRAIN_ACTIVE) printf(" %d", i);
+    }
+    printf("\n");
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
-        cout << "Usage: ./console_game <level_file_path>" << endl;
+        cout << "Usage: ./console_game <level_file_path> [--hash-log] [--log-drop] [--log <levels>] [--threads <n>]" << endl;
         return 1;
     }
 
+    for (int a = 2; a < argc; a++) {
+        if (string(argv[a]) == "--hash-log") {
+            sbSetHashLog(1); // Per-tick state hash to out/hash.csv
+        } else if (string(argv[a]) == "--log-drop") {
+            sbSetLogDrop(1); // Never wait for the log writer
+        } else if (string(argv[a]) == "--log" && a + 1 < argc) {
+            if (sbSetLogLevels(argv[++a]) != 0) return 1; // e.g. trace=events,signals=off
+        } else if (string(argv[a]) == "--threads" && a + 1 < argc) {
+            sbSetThreads(atoi(argv[++a])); // 1 = single-threaded tick
+        } else {
+            cout << "Unknown option: " << argv[a] << endl;
+            return 1;
+        }
+    }
+
     cout << "Loading level: " << argv[1] << "..." << endl;
-    if (!loadLevelFile(argv[1])) {
+    int sim = sbCreateFromFile(argv[1]);
+    if (sim < 0) {
         cout << "Error: Failed to load level file." << endl;
         return 1;
     }
-
-    initializeSimulation();
+    if (!allocateConsole(sim)) {
+        cout << "Error: Out of memory." << endl;
+        return 1;
+    }
 
     cout << "Simulation Loaded." << endl;
     cout << "Press [ENTER] to step forward one tick." << endl;
     cout << "Type 'q' and [ENTER] to quit." << endl;
     cout << "----------------------------------------" << endl;
 
-    printGrid();
+    printGrid(sim);
 
     string input;
     while (true) {
@@ -34,10 +210,18 @@ int main(int argc, char* argv[]) {
             break;
         }
 
-        simulateOneTick();
-        printGrid();
+        sbStep(sim, 1);
+        printGrid(sim);
+
+        // A livelocked run never finishes, so stop here
+        if (sbGetCycleLength(sim) > 0) {
+            printCycleReport(sim);
+            break;
+        }
     }
 
+    freeConsole();
+    sbDestroy(sim);
     cout << "Exiting simulation." << endl;
     return 0;
 }
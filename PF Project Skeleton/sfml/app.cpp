@@ -1,12 +1,17 @@
 #include "app.h"
 #include "../core/simulation_state.h"
-#include "../core/simulation.h"
-#include "../core/grid.h"
-#include "../core/switches.h"
-#include "../core/io.h"
+#include "../core/switchback.h"
+#include "../core/heatmap.h"
+#include "../core/journal.h"
+#include "../core/timeline.h"
+#include "../core/trace_index.h"
+#include "atlas.h"
+#include "board.h"
 #include <SFML/Graphics.hpp>
 #include <cmath>
 #include <cstdio>
+#include <cstdlib>
+#include <ctime>
 
 // ============================================================================
 // APP.CPP - Implementation of SFML application (NO CLASSES)
@@ -21,10 +26,19 @@ static sf::Font g_font;
 // View for camera (panning/zoom)
 static sf::View g_camera;
 
+// Simulation shown (a switchback handle; drawing reads it through board.h)
+static int g_sim = -1;
+
 // Simulation state
 static bool g_isPaused = true; // Default to paused so user can see start state
 static bool g_isStepMode = false;
 
+// Frame pacing: a frame is only drawn when something on screen changed
+static bool g_needsRedraw = true;
+static int g_framesDrawn = 0;
+static sf::Clock g_runClock;        // Wall time since the window opened
+static std::clock_t g_cpuStart = 0; // Process CPU time at that moment
+
 // Mouse state
 static bool g_isDragging = false;
 static int g_lastMouseX = 0;
@@ -35,6 +49,274 @@ static float g_cellSize = 40.0f;
 static float g_gridOffsetX = 50.0f;
 static float g_gridOffsetY = 50.0f;
 
+static sf::Texture g_atlas;
+static bool g_spriteLoaded[NUM_ATLAS_SPRITES];
+static sf::VertexArray g_batch(sf::Quads);
+
+// Heatmap overlay: -1 = off, otherwise the SB_HEAT_* layer shown
+static int g_heatLayer = -1;
+static const int NUM_HEAT_LAYERS = 2;
+static const int NUM_HEAT_WINDOWS = 4;
+static const int g_heatWindows[NUM_HEAT_WINDOWS] = { 0, 50, 200, 1000 }; // 0 = all time
+static int g_heatWindowIndex = 0;
+static const char* g_heatNames[NUM_HEAT_LAYERS] = { "holds", "flips" };
+static int* g_heatValues = nullptr; // One layer, row by row (sbGetHeat)
+
+// Emergency halt placed with E (3x3) or Shift+E (circle)
+static const int HALT_TICKS = 10;
+static const int HALT_CIRCLE_RADIUS = 3;
+
+// Timeline scrubber along the bottom of the window (window pixels)
+static const int SCRUB_MARGIN = 20;
+static const int SCRUB_HEIGHT = 14;
+static const int SCRUB_BOTTOM = 30; // Distance of the bar's top from the bottom edge
+static bool g_isScrubbing = false;
+
+// Trace replay (--replay-trace): trains come from a recorded trace.csv, one
+// tick's rows at a time, instead of from the simulation
+static bool g_isTraceReplay = false;
+static int g_replayTick = 0;
+static double g_replayPosition = 0.0;  // Playback position, in ticks
+static float g_replaySpeed = 2.0f;     // Ticks per second
+static const float REPLAY_MAX_SPEED = 16384.0f;
+static int g_replayCount = 0;
+static int g_replayTrain[MAX_TRAINS];
+static int g_replayCol[MAX_TRAINS];
+static int g_replayRow[MAX_TRAINS];
+static int g_replayDir[MAX_TRAINS];
+static int g_replayState[MAX_TRAINS];
+
+// ----------------------------------------------------------------------------
+// BUILD SPRITE ATLAS
+// ----------------------------------------------------------------------------
+// Packs every tile and train sprite into one texture so the whole board is
+// drawn from a single vertex array with one draw call.
+// ----------------------------------------------------------------------------
+static bool buildSpriteAtlas() {
+    sf::Image atlas;
+    buildAtlasImage(atlas, g_spriteLoaded);
+    if (!g_atlas.loadFromImage(atlas)) return false;
+    g_atlas.setSmooth(true);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// APPEND SPRITE QUAD
+// ----------------------------------------------------------------------------
+// Adds one size x size quad at (x, y) to the batch, textured with the given
+// atlas sprite. The texture corners are rotated by quarterTurns (clockwise)
+// and optionally mirrored left-right, so no per-sprite transform is needed.
+// ----------------------------------------------------------------------------
+static void appendSpriteQuad(float x, float y, float size, int sprite,
+                             int quarterTurns, bool mirror, sf::Color tint) {
+    float u = (float)((sprite % ATLAS_COLUMNS) * ATLAS_SLOT);
+    float v = (float)((sprite / ATLAS_COLUMNS) * ATLAS_SLOT);
+    float slot = (float)ATLAS_SLOT;
+
+    // Corners in order: top-left, top-right, bottom-right, bottom-left
+    sf::Vector2f pos[4] = { sf::Vector2f(x, y), sf::Vector2f(x + size, y),
+                            sf::Vector2f(x + size, y + size), sf::Vector2f(x, y + size) };
+    sf::Vector2f tex[4] = { sf::Vector2f(u, v), sf::Vector2f(u + slot, v),
+                            sf::Vector2f(u + slot, v + slot), sf::Vector2f(u, v + slot) };
+    if (sprite == SPR_BLANK) {
+        // Sample the middle of the white slot so filtering never bleeds
+        for (int k = 0; k < 4; k++) tex[k] = sf::Vector2f(u + slot / 2.0f, v + slot / 2.0f);
+    }
+
+    for (int k = 0; k < 4; k++) {
+        int corner = (k - quarterTurns + 4) % 4;
+        if (mirror) corner = corner ^ 1; // TL<->TR, BR<->BL
+        g_batch.append(sf::Vertex(pos[k], tint, tex[corner]));
+    }
+}
+
+// ----------------------------------------------------------------------------
+// TRACE REPLAY
+// ----------------------------------------------------------------------------
+// Shows one recorded tick. Only that tick's rows are read from the mapped
+// trace, so memory use does not depend on the trace length.
+// ----------------------------------------------------------------------------
+static void showTraceTick(int tick) {
+    int last = getIndexedTicks() - 1;
+    if (tick > last) tick = last;
+    if (tick < 0) tick = 0;
+    g_replayTick = tick;
+    g_replayCount = readTraceTick(tick, g_replayTrain, g_replayCol, g_replayRow,
+                                  g_replayDir, g_replayState, MAX_TRAINS);
+    g_needsRedraw = true;
+}
+
+bool openTraceReplay(const char* tracePath) {
+    char indexPath[1024];
+    snprintf(indexPath, sizeof(indexPath), "%s.idx", tracePath);
+    if (!loadTraceIndex(tracePath, indexPath)) {
+        printf("Error: Could not index trace %s\n", tracePath);
+        return false;
+    }
+    g_isTraceReplay = true;
+    g_replayPosition = 0.0;
+    showTraceTick(0);
+    return true;
+}
+
+// Tick on screen and last tick of the scrubber
+static int getShownTick() {
+    return g_isTraceReplay ? g_replayTick : sbGetTick(g_sim);
+}
+
+static int getScrubberEnd() {
+    return g_isTraceReplay ? getIndexedTicks() - 1 : getTimelineEnd();
+}
+
+// ----------------------------------------------------------------------------
+// STEP SIMULATION
+// ----------------------------------------------------------------------------
+// Runs one tick. If the trains just got stuck in a repeating loop, pauses
+// and prints the cycle report once. In trace replay it shows the next
+// recorded tick instead.
+// ----------------------------------------------------------------------------
+static void stepSimulation() {
+    if (g_isTraceReplay) {
+        showTraceTick(g_replayTick + 1);
+        g_replayPosition = g_replayTick;
+        if (g_replayTick >= getScrubberEnd()) g_isPaused = true;
+        return;
+    }
+    bool wasLivelocked = sbGetCycleLength(g_sim) > 0;
+    applyJournalInputs(); // Re-applies inputs after a seek back; no-op otherwise
+    sbStep(g_sim, 1);
+    updateTimeline();
+    if (sbGetCycleLength(g_sim) > 0 && !wasLivelocked) {
+        g_isPaused = true;
+        printCycleReport(g_sim);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// TIMELINE SCRUBBER
+// ----------------------------------------------------------------------------
+// A bar from tick 0 to the furthest tick reached. Clicking or dragging on it
+// seeks; the filled part ends at the current tick.
+// ----------------------------------------------------------------------------
+static bool isOnScrubber(int x, int y) {
+    sf::Vector2u size = (*g_window).getSize();
+    int top = (int)size.y - SCRUB_BOTTOM;
+    return x >= SCRUB_MARGIN && x <= (int)size.x - SCRUB_MARGIN &&
+           y >= top - 4 && y <= top + SCRUB_HEIGHT + 4;
+}
+
+static int getScrubberTick(int x) {
+    int width = (int)(*g_window).getSize().x - 2 * SCRUB_MARGIN;
+    if (width <= 0) return 0;
+    float t = (float)(x - SCRUB_MARGIN) / width;
+    if (t < 0.0f) t = 0.0f;
+    if (t > 1.0f) t = 1.0f;
+    return (int)(t * getScrubberEnd() + 0.5f);
+}
+
+static void seekTimeline(int tick) {
+    g_isPaused = true;
+    if (g_isTraceReplay) {
+        showTraceTick(tick);
+        g_replayPosition = g_replayTick;
+    } else if (tick != sbGetTick(g_sim)) {
+        seekToTick(tick);
+    }
+    g_needsRedraw = true;
+}
+
+static void drawScrubber() {
+    sf::Vector2u size = (*g_window).getSize();
+    float width = (float)size.x - 2 * SCRUB_MARGIN;
+    float top = (float)size.y - SCRUB_BOTTOM;
+    int end = getScrubberEnd();
+    float filled = (end > 0) ? width * getShownTick() / end : width;
+    if (filled > width) filled = width;
+
+    (*g_window).setView((*g_window).getDefaultView());
+    sf::RectangleShape bar(sf::Vector2f(width, (float)SCRUB_HEIGHT));
+    bar.setPosition((float)SCRUB_MARGIN, top);
+    bar.setFillColor(sf::Color(60, 60, 60, 220));
+    (*g_window).draw(bar);
+
+    sf::RectangleShape done(sf::Vector2f(filled, (float)SCRUB_HEIGHT));
+    done.setPosition((float)SCRUB_MARGIN, top);
+    done.setFillColor(sf::Color(70, 140, 220, 230));
+    (*g_window).draw(done);
+
+    if (g_font.getInfo().family != "") {
+        char label[96];
+        if (g_isTraceReplay) {
+            sprintf(label, "Tick %d / %d   (trace replay, %g ticks/s)", g_replayTick, end, g_replaySpeed);
+        } else {
+            sprintf(label, "Tick %d / %d   (%d checkpoints, every %d ticks)",
+                    sbGetTick(g_sim), end, getCheckpointCount(), getCheckpointInterval());
+        }
+        sf::Text text;
+        text.setFont(g_font);
+        text.setString(label);
+        text.setCharacterSize(12);
+        text.setFillColor(sf::Color::White);
+        text.setPosition((float)SCRUB_MARGIN, top - 16.0f);
+        (*g_window).draw(text);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Adds the quads of one train: colour badge, then the train sprite turned to
+// face its direction.
+// ----------------------------------------------------------------------------
+static void appendTrainQuads(int col, int row, int dir, int colorCode) {
+    float x = col * g_cellSize;
+    float y = row * g_cellSize;
+    appendSpriteQuad(x + g_cellSize * 0.1f, y + g_cellSize * 0.1f, g_cellSize * 0.8f,
+                     SPR_BLANK, 0, false, getTrainColor(colorCode));
+    if (g_spriteLoaded[SPR_TRAIN]) {
+        int quarterTurns = (dir - DIR_RIGHT + 4) % 4;
+        appendSpriteQuad(x, y, g_cellSize, SPR_TRAIN, quarterTurns, false, sf::Color::White);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// EXPORT HEATMAPS
+// ----------------------------------------------------------------------------
+// Reads one heatmap layer into g_heatValues. Returns its largest value.
+// ----------------------------------------------------------------------------
+static int readHeatLayer(int layer) {
+    int cells = BoardRows * BoardCols;
+    if (!g_heatValues || sbGetHeat(g_sim, layer, g_heatValues, cells) < 0) return 0;
+    int maxValue = 0;
+    for (int k = 0; k < cells; k++) {
+        if (g_heatValues[k] > maxValue) maxValue = g_heatValues[k];
+    }
+    return maxValue;
+}
+
+// ----------------------------------------------------------------------------
+// Writes every heatmap layer to out/ as PGM (from the core) and as PNG.
+// ----------------------------------------------------------------------------
+static void exportHeatmapImages() {
+    for (int layer = 0; layer < NUM_HEAT_LAYERS; layer++) {
+        char path[64];
+        sprintf(path, "out/heatmap_%s.pgm", g_heatNames[layer]);
+        exportHeatmapPGM(path, layer);
+
+        int maxValue = readHeatLayer(layer);
+        sf::Image image;
+        image.create(BoardCols, BoardRows, sf::Color::Black);
+        for (int r = 0; r < BoardRows; r++) {
+            for (int c = 0; c < BoardCols; c++) {
+                int v = g_heatValues[r * BoardCols + c];
+                sf::Uint8 level = (sf::Uint8)(maxValue > 0 ? v * 255 / maxValue : 0);
+                image.setPixel(c, r, sf::Color(level, level, level));
+            }
+        }
+        sprintf(path, "out/heatmap_%s.png", g_heatNames[layer]);
+        image.saveToFile(path);
+    }
+    printf("Heatmaps exported to out/ (window: %d ticks, 0 = all time)\n", g_heatWindows[g_heatWindowIndex]);
+}
+
 // ----------------------------------------------------------------------------
 // INITIALIZATION
 // ----------------------------------------------------------------------------
@@ -43,13 +325,20 @@ static float g_gridOffsetY = 50.0f;
 // framerate limit, attempts to load a font file for text rendering, and
 // initializes the camera view. Returns true on success, false on failure.
 // This should be called once at the start of the application before entering
-// the main loop.
+// the main loop. sim is the switchback handle the window shows.
 // ----------------------------------------------------------------------------
-bool initializeApp() {
+bool initializeApp(int sim) {
+    g_sim = sim;
+    if (!loadBoard(sim)) return false;
+    g_heatValues = (int*)malloc(sizeof(int) * (BoardRows * BoardCols + 1));
+    if (!g_heatValues) return false;
+
     // Creates the Window
     // We allocate the window on the heap as per the global pointer
     g_window = new sf::RenderWindow(sf::VideoMode(1200, 800), "Switchback Rails");
     (*g_window).setFramerateLimit(60);
+    g_runClock.restart();
+    g_cpuStart = std::clock();
 
     // Loads Font
     // Required for drawing text. If this fails, text won't show, but we return true to run.
@@ -59,11 +348,16 @@ bool initializeApp() {
 
     // Setup Camera
     g_camera = (*g_window).getDefaultView(); // Center the camera on the middle of the loaded level
-    // We used global variables from simulation_state.h
-    float centerX = (LevelNumCols * g_cellSize) / 2.0f;
-    float centerY = (LevelNumRows * g_cellSize) / 2.0f;
+    // Map size as read through the switchback API
+    float centerX = (BoardCols * g_cellSize) / 2.0f;
+    float centerY = (BoardRows * g_cellSize) / 2.0f;
     g_camera.setCenter(centerX, centerY);
 
+    // Packs all tile and train sprites into one texture
+    if (!buildSpriteAtlas()) {
+        printf("Warning: could not create sprite atlas texture\n");
+    }
+
     return true;
 }
 
@@ -74,9 +368,13 @@ bool initializeApp() {
 // simulation updates, and rendering. The loop continues while the window is open.
 // It processes SFML events (window close, keyboard input, mouse input), updates
 // the simulation at a fixed interval (2 ticks per second) when not paused,
-// checks if the simulation is complete, and renders the current frame. Keyboard
-// controls: SPACE to pause/resume, PERIOD to step one tick, ESC to exit. The
-// loop exits when the window is closed or ESC is pressed.
+// checks if the simulation is complete, and renders the current frame only if
+// something changed (a tick, camera pan/zoom, a tile edit or a window event).
+// While paused with nothing to redraw it blocks in waitEvent. Keyboard
+// controls: SPACE to pause/resume, PERIOD to step one tick, COMMA to step
+// back one tick (the timeline bar at the bottom seeks too), ESC to exit. The
+// loop exits when the window is closed or ESC is pressed. In trace replay
+// UP/DOWN double/halve the playback speed and edits are ignored.
 // ----------------------------------------------------------------------------
 void runApp() {
     sf::Clock updateClock;
@@ -88,7 +386,19 @@ void runApp() {
         // 1. EVENT PROCESSING
         // ====================================================================
         sf::Event event;
-        while ((*g_window).pollEvent(event)) {
+        // Paused with nothing new to show: sleep in waitEvent instead of spinning
+        bool hasEvent;
+        if (g_isPaused && !g_needsRedraw) hasEvent = (*g_window).waitEvent(event);
+        else hasEvent = (*g_window).pollEvent(event);
+
+        for (; hasEvent; hasEvent = (*g_window).pollEvent(event)) {
+            // Everything except plain mouse moves and releases changes the picture
+            if (!(event.type == sf::Event::MouseMoved && !g_isDragging) &&
+                event.type != sf::Event::MouseButtonReleased &&
+                event.type != sf::Event::KeyReleased) {
+                g_needsRedraw = true;
+            }
+
             // Closes Window
             if (event.type == sf::Event::Closed) {
                 (*g_window).close();
@@ -97,10 +407,42 @@ void runApp() {
             else if (event.type == sf::Event::KeyPressed) {
                 if (event.key.code == sf::Keyboard::Escape) (*g_window).close();
                 if (event.key.code == sf::Keyboard::Space) g_isPaused = !g_isPaused;
+                // Heatmap: H cycles layer, W cycles window, P exports images
+                if (event.key.code == sf::Keyboard::H) {
+                    g_heatLayer++;
+                    if (g_heatLayer >= NUM_HEAT_LAYERS) g_heatLayer = -1;
+                }
+                if (event.key.code == sf::Keyboard::W) {
+                    g_heatWindowIndex = (g_heatWindowIndex + 1) % NUM_HEAT_WINDOWS;
+                    sbSetHeatWindow(g_heatWindows[g_heatWindowIndex]);
+                }
+                if (event.key.code == sf::Keyboard::P) exportHeatmapImages();
+                // Trace replay speed
+                if (g_isTraceReplay && event.key.code == sf::Keyboard::Up && g_replaySpeed < REPLAY_MAX_SPEED) {
+                    g_replaySpeed *= 2.0f;
+                }
+                if (g_isTraceReplay && event.key.code == sf::Keyboard::Down && g_replaySpeed > 0.25f) {
+                    g_replaySpeed /= 2.0f;
+                }
+                // Emergency halt around the cell under the mouse (journaled)
+                if (event.key.code == sf::Keyboard::E && !g_isTraceReplay) {
+                    sf::Vector2i pixelPos = sf::Mouse::getPosition(*g_window);
+                    sf::Vector2f worldPos = (*g_window).mapPixelToCoords(pixelPos, g_camera);
+                    int c = (int)(worldPos.x / g_cellSize);
+                    int r = (int)(worldPos.y / g_cellSize);
+                    if (r >= 0 && r < BoardRows && c >= 0 && c < BoardCols) {
+                        if (event.key.shift) applyHaltRadiusInput(r, c, HALT_CIRCLE_RADIUS, HALT_TICKS);
+                        else applyHaltRectInput(r - 1, c - 1, r + 1, c + 1, HALT_TICKS);
+                    }
+                }
                 if (event.key.code == sf::Keyboard::Period) {
-                    simulateOneTick();
+                    stepSimulation();
                     timeSinceLastTick = 0.0f; // Reset timer so we don't double step
                 }
+                // Step back one tick (restores a checkpoint and catches up)
+                if (event.key.code == sf::Keyboard::Comma && getShownTick() > 0) {
+                    seekTimeline(getShownTick() - 1);
+                }
             }
             // Mouse Wheel (Zoom)
             else if (event.type == sf::Event::MouseWheelScrolled) {
@@ -115,9 +457,16 @@ void runApp() {
                     g_lastMouseX = event.mouseButton.x;
                     g_lastMouseY = event.mouseButton.y;
                 }
-                // Handle Left or Right click
-                else if (event.mouseButton.button == sf::Mouse::Left || 
-                         event.mouseButton.button == sf::Mouse::Right) {
+                // Left click on the timeline = seek (and keep seeking while dragged)
+                else if (event.mouseButton.button == sf::Mouse::Left &&
+                         isOnScrubber(event.mouseButton.x, event.mouseButton.y)) {
+                    g_isScrubbing = true;
+                    seekTimeline(getScrubberTick(event.mouseButton.x));
+                }
+                // Handle Left or Right click (a recorded trace cannot be edited)
+                else if (!g_isTraceReplay &&
+                         (event.mouseButton.button == sf::Mouse::Left ||
+                          event.mouseButton.button == sf::Mouse::Right)) {
                     
                     // Gets Screen Pixels
                     sf::Vector2i pixelPos = sf::Mouse::getPosition(*g_window);
@@ -128,12 +477,12 @@ void runApp() {
                     int r = (int)(worldPos.y / g_cellSize);
 
                     // Performs Action
-                   if(r >=0 && r < LevelNumRows && c >= 0 && c < LevelNumCols)  {
+                   if(r >=0 && r < BoardRows && c >= 0 && c < BoardCols)  {
                     if (event.mouseButton.button == sf::Mouse::Left) {
-                        toggleSafetyTile(r, c); // Uses r and c
+                        applyInput(JOURNAL_SAFETY_TILE, r, c); // Uses r and c (journaled)
                     } 
                     else if (event.mouseButton.button == sf::Mouse::Right) {
-                        toggleSwitchState(); // Changes switches
+                        applyInput(JOURNAL_SWITCH, r, c); // Changes switches (journaled)
                     } 
                 }
             }
@@ -143,9 +492,15 @@ void runApp() {
                 if (event.mouseButton.button == sf::Mouse::Middle) {
                     g_isDragging = false;
                 }
+                if (event.mouseButton.button == sf::Mouse::Left) {
+                    g_isScrubbing = false;
+                }
             }
             // Mouse Movement (Panning)
             else if (event.type == sf::Event::MouseMoved) {
+                if (g_isScrubbing) {
+                    seekTimeline(getScrubberTick(event.mouseMove.x));
+                }
                 if (g_isDragging) {
                     int dx = event.mouseMove.x - g_lastMouseX;
                     int dy = event.mouseMove.y - g_lastMouseY;
@@ -163,101 +518,143 @@ void runApp() {
         // ====================================================================
         // 2. SIMULATION UPDATE
         // ====================================================================
-        if (!g_isPaused) {
+        if (!g_isPaused && g_isTraceReplay) {
+            // Jumps straight to the tick that is due, however fast the playback
+            g_replayPosition += updateClock.restart().asSeconds() * g_replaySpeed;
+            if ((int)g_replayPosition != g_replayTick) {
+                showTraceTick((int)g_replayPosition);
+                if (g_replayTick >= getScrubberEnd()) g_isPaused = true;
+            }
+        } else if (!g_isPaused) {
             timeSinceLastTick += updateClock.restart().asSeconds();
             if (timeSinceLastTick >= TICK_RATE) {
-                simulateOneTick();
+                stepSimulation();
                 timeSinceLastTick = 0.0f;
+                g_needsRedraw = true;
             }
         } else {
             updateClock.restart(); // Doesn't accumulate time while paused
         }
 
         // ====================================================================
-        // 3. RENDERING
+        // 3. RENDERING (only when something changed)
         // ====================================================================
+        if (!g_needsRedraw) {
+            // Running but between ticks: idle until the next tick is due,
+            // waking at least 60 times a second to stay responsive to input
+            if (!g_isPaused) {
+                float wait = TICK_RATE - timeSinceLastTick;
+                if (wait > 1.0f / 60.0f) wait = 1.0f / 60.0f;
+                if (wait > 0.0f) sf::sleep(sf::seconds(wait));
+            }
+            continue;
+        }
+        g_needsRedraw = false;
+        g_framesDrawn++;
+
         (*g_window).clear(sf::Color(20, 20, 20)); // Dark Grey Background
         (*g_window).setView(g_camera);
 
-        // Loop through the grid
-        for (int r = 0; r < LevelNumRows; ++r) {
-            for (int c = 0; c < LevelNumCols; ++c) {
-                // Access global grid array
-                char tile = TheGrid[r][c];
-                
-                // Calculates position
-                float x = c * g_cellSize;
-                float y = r * g_cellSize;
-
-                // Creates Rectangle for Tile
-                sf::RectangleShape shape(sf::Vector2f(g_cellSize - 2.0f, g_cellSize - 2.0f));
-                shape.setPosition(x + 1.0f, y + 1.0f);
-
-                // Determines Color
-                sf::Color color = sf::Color(50, 50, 50); // Default Ground
-                
-                if (tile == '-') color = sf::Color(100, 100, 100);      // Horizontal Track
-                else if (tile == '|') color = sf::Color(100, 100, 100); // Vertical Track
-                else if (tile == '+') color = sf::Color(120, 120, 120); // Intersection
-                else if (tile == '/' || tile == '\\') color = sf::Color(100, 100, 100); // Curves
-                else if (tile == 'S') color = sf::Color::Cyan;          // Spawn Point
-                else if (tile == 'D') color = sf::Color::Magenta;       // Destination
-                else if (tile == '=') color = sf::Color::Blue;          // Safety Tile
-                else if (tile >= 'A' && tile <= 'Z') {
-                    color = sf::Color(255, 200, 0); // Switches are Yellow
+        // Builds the whole frame into one vertex array
+        g_batch.clear();
+        readBoard(g_sim);
+
+        // Ground layer under every cell of the allocated chunks (chunks
+        // with nothing on them are left as background)
+        for (int k = 0; k < BoardChunkCount; ++k) {
+            for (int r = BoardChunkRow0[k]; r < BoardChunkRow1[k]; ++r) {
+                for (int c = BoardChunkCol0[k]; c < BoardChunkCol1[k]; ++c) {
+                    char tile = getBoardTile(r, c);
+                    int sprite = getBoardSprite(r, c);
+                    sf::Color ground = sf::Color(50, 50, 50);
+                    // Tiles without a loaded sprite keep their old flat colour
+                    if (sprite >= 0 && !g_spriteLoaded[sprite]) ground = getTileColor(tile);
+                    appendSpriteQuad(c * g_cellSize + 1.0f, r * g_cellSize + 1.0f,
+                                     g_cellSize - 2.0f, SPR_BLANK, 0, false, ground);
+                }
+            }
+        }
+
+        // Track, station and switch sprites
+        for (int k = 0; k < BoardChunkCount; ++k) {
+            for (int r = BoardChunkRow0[k]; r < BoardChunkRow1[k]; ++r) {
+                for (int c = BoardChunkCol0[k]; c < BoardChunkCol1[k]; ++c) {
+                    char tile = getBoardTile(r, c);
+                    int sprite = getBoardSprite(r, c);
+                    if (sprite < 0 || !g_spriteLoaded[sprite]) continue;
+                    appendSpriteQuad(c * g_cellSize, r * g_cellSize, g_cellSize,
+                                     sprite, 0, tile == '\\', sf::Color::White);
+                }
+            }
+        }
+
+        // Heatmap overlay, scaled to the hottest cell of the selected window
+        if (g_heatLayer >= 0) {
+            int maxHeat = readHeatLayer(g_heatLayer);
+            for (int k = 0; k < BoardChunkCount && maxHeat > 0; ++k) {
+                for (int r = BoardChunkRow0[k]; r < BoardChunkRow1[k]; ++r) {
+                    for (int c = BoardChunkCol0[k]; c < BoardChunkCol1[k]; ++c) {
+                        int v = g_heatValues[r * BoardCols + c];
+                        if (v == 0) continue;
+                        sf::Uint8 alpha = (sf::Uint8)(60 + 170 * v / maxHeat);
+                        sf::Color heat = (g_heatLayer == SB_HEAT_HOLD) ? sf::Color(255, 40, 0, alpha)
+                                                                    : sf::Color(0, 160, 255, alpha);
+                        appendSpriteQuad(c * g_cellSize, r * g_cellSize, g_cellSize, SPR_BLANK, 0, false, heat);
+                    }
                 }
+            }
+        }
+
+        // Emergency halt zones
+        for (int r = 0; r < BoardRows; ++r) {
+            for (int c = 0; c < BoardCols; ++c) {
+                if (!BoardHalted[r * BoardCols + c]) continue;
+                appendSpriteQuad(c * g_cellSize, r * g_cellSize, g_cellSize, SPR_BLANK, 0, false,
+                                 sf::Color(255, 0, 0, 70));
+            }
+        }
+
+        // Trains (colours come from the level's schedule in both modes)
+        if (g_isTraceReplay) {
+            for (int k = 0; k < g_replayCount; k++) {
+                if (g_replayState[k] != 1 || g_replayTrain[k] >= BoardTrainCount) continue;
+                appendTrainQuads(g_replayCol[k], g_replayRow[k], g_replayDir[k],
+                                 BoardTrainColor[g_replayTrain[k]]);
+            }
+        } else {
+            for (int i = 0; i < BoardTrainCount; i++) {
+                // Only draws Active trains (State == 1)
+                if (BoardTrainState[i] != SB_TRAIN_ACTIVE) continue;
+                appendTrainQuads(BoardTrainCol[i], BoardTrainRow[i], BoardTrainDir[i], BoardTrainColor[i]);
+            }
+        }
+
+        // Single draw call for every tile and train
+        (*g_window).draw(g_batch, sf::RenderStates(&g_atlas));
 
-                shape.setFillColor(color);
-                (*g_window).draw(shape);
+        // Switch letters and names (text is not part of the atlas)
+        if (g_font.getInfo().family != "") {
+            for (int k = 0; k < BoardChunkCount; ++k) {
+                for (int r = BoardChunkRow0[k]; r < BoardChunkRow1[k]; ++r) {
+                    for (int c = BoardChunkCol0[k]; c < BoardChunkCol1[k]; ++c) {
+                        int idx = BoardSwitchAt[r * BoardCols + c];
+                        char name[SWITCH_NAME_LENGTH];
+                        if (idx < 0 || sbGetSwitchName(g_sim, idx, name, sizeof(name)) != 0) continue;
 
-                // Draw Text (Overlay chars like 'A', 'S', 'D')
-                if ((tile >= 'A' && tile <= 'Z') || tile == 'S' || tile == 'D') {
-                    if (g_font.getInfo().family != "") {
                         sf::Text text;
                         text.setFont(g_font);
-                        
-                        // Create C-string manually
-                        char strBuffer[2];
-                        strBuffer[0] = tile;
-                        strBuffer[1] = '\0';
-                        text.setString(strBuffer);
-
-                        text.setCharacterSize(20);
-                        text.setFillColor(sf::Color::Black);
-                        
-                        // Center text
-                        sf::FloatRect bounds = text.getLocalBounds();
-                        text.setPosition(
-                            x + (g_cellSize - bounds.width) / 2.0f,
-                            y + (g_cellSize - bounds.height) / 3.0f
-                        );
+                        text.setString(name);
+
+                        text.setCharacterSize(14);
+                        text.setFillColor(sf::Color::White);
+                        text.setPosition(c * g_cellSize + 2.0f, r * g_cellSize);
                         (*g_window).draw(text);
                     }
                 }
             }
         }
-        for (int i = 0; i < TotalScheduledTrains; i++) {
-            // Only draws Active trains (State == 1)
-            if (TrainState[i] == 1) {
-                int r = TrainCurrentRow[i];
-                int c = TrainCurrentCol[i];
-                
-                float x = c * g_cellSize;
-                float y = r * g_cellSize;
-
-                sf::CircleShape trainShape(g_cellSize * 0.4f);
-                trainShape.setPosition(x + g_cellSize * 0.1f, y + g_cellSize * 0.1f);
-                
-                // Color based on config
-                int colorCode = TrainColorCode[i];
-                if (colorCode == 0) trainShape.setFillColor(sf::Color::Red);
-                else if (colorCode == 1) trainShape.setFillColor(sf::Color::Green);
-                else if (colorCode == 2) trainShape.setFillColor(sf::Color::Blue);
-                else trainShape.setFillColor(sf::Color::White);
-
-                (*g_window).draw(trainShape);
-            }
-        }
+
+        drawScrubber();
 
         (*g_window).display();
     }
@@ -272,8 +669,21 @@ void runApp() {
 // proper resource cleanup.
 // ----------------------------------------------------------------------------
 void cleanupApp() {
+    // Frame pacing report: how many frames were drawn and how much CPU the
+    // app used, to check that an idle (paused) window stays near 0%
+    float wallSeconds = g_runClock.getElapsedTime().asSeconds();
+    float cpuSeconds = (float)(std::clock() - g_cpuStart) / CLOCKS_PER_SEC;
+    if (wallSeconds > 0.0f) {
+        printf("Frames drawn: %d in %.1f s (%.1f fps), CPU %.2f s (%.1f%% of one core)\n",
+               g_framesDrawn, wallSeconds, g_framesDrawn / wallSeconds,
+               cpuSeconds, 100.0f * cpuSeconds / wallSeconds);
+    }
+
     if (g_window) {
         delete g_window; // Cleans the previous simulation 
         g_window = nullptr;
     }
+    free(g_heatValues);
+    g_heatValues = nullptr;
+    freeBoard();
 }
@@ -10,9 +10,13 @@
 // ----------------------------------------------------------------------------
 // INITIALIZATION
 // ----------------------------------------------------------------------------
-// Initialize the SFML window and resources
+// Initialize the SFML window and resources to show switchback handle sim
 // Returns true on success, false on failure
-bool initializeApp();
+bool initializeApp(int sim);
+
+// Show a recorded trace.csv instead of simulating (the level only provides
+// the map and train colours). Returns false if the trace cannot be indexed.
+bool openTraceReplay(const char* tracePath);
 
 // ----------------------------------------------------------------------------
 // MAIN RUN LOOP
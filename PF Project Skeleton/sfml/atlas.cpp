@@ -0,0 +1,135 @@
+#include "atlas.h"
+#include "../core/simulation_state.h"
+#include <cstdio>
+
+// ============================================================================
+// ATLAS.CPP - Packed sprite atlas
+// ============================================================================
+
+#define NUM_SHEETS 5      // Sprites/1.png .. Sprites/5.png
+
+// Source region of each sprite: sheet number and pixel rectangle on that sheet
+static const int g_spriteSheet[NUM_ATLAS_SPRITES] = { 0, 5, 5, 5, 5, 3, 3, 3, 4, 4, 2 };
+static const int g_spriteSrcX[NUM_ATLAS_SPRITES] = { 0, 50, 452, 60, 378, 62, 565, 805, 60, 570, 560 };
+static const int g_spriteSrcY[NUM_ATLAS_SPRITES] = { 0, 62, 62, 305, 660, 98, 98, 98, 310, 310, 580 };
+static const int g_spriteSrcW[NUM_ATLAS_SPRITES] = { 0, 325, 132, 290, 268, 168, 170, 165, 360, 360, 370 };
+static const int g_spriteSrcH[NUM_ATLAS_SPRITES] = { 0, 140, 240, 300, 320, 172, 172, 172, 330, 330, 240 };
+
+// ----------------------------------------------------------------------------
+// BUILD SPRITE ATLAS
+// ----------------------------------------------------------------------------
+// Loads the sprite sheets and packs each sprite region into its own slot of a
+// single atlas image. Regions are box-filtered down to ATLAS_SLOT pixels with
+// their aspect ratio kept, and the light paper background of the sheets is
+// turned transparent. Slot 0 is solid white so plain coloured quads can share
+// the same texture. Missing sheets only leave their slots empty.
+// ----------------------------------------------------------------------------
+void buildAtlasImage(sf::Image& atlas, bool spriteLoaded[NUM_ATLAS_SPRITES]) {
+    sf::Image sheets[NUM_SHEETS + 1];
+    bool sheetLoaded[NUM_SHEETS + 1];
+    sheetLoaded[0] = false;
+    for (int s = 1; s <= NUM_SHEETS; s++) {
+        char path[50];
+        sprintf(path, "Sprites/%d.png", s);
+        sheetLoaded[s] = sheets[s].loadFromFile(path);
+        if (!sheetLoaded[s]) {
+            printf("Warning: could not load %s, using flat colours\n", path);
+        }
+    }
+
+    int atlasRows = (NUM_ATLAS_SPRITES + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS;
+    atlas.create(ATLAS_COLUMNS * ATLAS_SLOT, atlasRows * ATLAS_SLOT, sf::Color::Transparent);
+
+    for (int id = 0; id < NUM_ATLAS_SPRITES; id++) {
+        int slotX = (id % ATLAS_COLUMNS) * ATLAS_SLOT;
+        int slotY = (id / ATLAS_COLUMNS) * ATLAS_SLOT;
+
+        if (id == SPR_BLANK) {
+            for (int y = 0; y < ATLAS_SLOT; y++)
+                for (int x = 0; x < ATLAS_SLOT; x++)
+                    atlas.setPixel(slotX + x, slotY + y, sf::Color::White);
+            spriteLoaded[id] = true;
+            continue;
+        }
+
+        int sheet = g_spriteSheet[id];
+        spriteLoaded[id] = sheetLoaded[sheet];
+        if (!sheetLoaded[sheet]) continue;
+
+        // Fit the region into the slot, centred, keeping its aspect ratio
+        int srcW = g_spriteSrcW[id];
+        int srcH = g_spriteSrcH[id];
+        int longest = (srcW > srcH) ? srcW : srcH;
+        int dstW = srcW * ATLAS_SLOT / longest;
+        int dstH = srcH * ATLAS_SLOT / longest;
+        int padX = (ATLAS_SLOT - dstW) / 2;
+        int padY = (ATLAS_SLOT - dstH) / 2;
+        sf::Vector2u sheetSize = sheets[sheet].getSize();
+
+        for (int y = 0; y < dstH; y++) {
+            for (int x = 0; x < dstW; x++) {
+                // Source block covered by this destination pixel
+                int x0 = g_spriteSrcX[id] + x * longest / ATLAS_SLOT;
+                int x1 = g_spriteSrcX[id] + (x + 1) * longest / ATLAS_SLOT;
+                int y0 = g_spriteSrcY[id] + y * longest / ATLAS_SLOT;
+                int y1 = g_spriteSrcY[id] + (y + 1) * longest / ATLAS_SLOT;
+
+                int sumR = 0, sumG = 0, sumB = 0, inked = 0, total = 0;
+                for (int sy = y0; sy < y1 && sy < (int)sheetSize.y; sy++) {
+                    for (int sx = x0; sx < x1 && sx < (int)sheetSize.x; sx++) {
+                        sf::Color p = sheets[sheet].getPixel(sx, sy);
+                        total++;
+                        int lo = p.r < p.g ? (p.r < p.b ? p.r : p.b) : (p.g < p.b ? p.g : p.b);
+                        int hi = p.r > p.g ? (p.r > p.b ? p.r : p.b) : (p.g > p.b ? p.g : p.b);
+                        // Light, unsaturated pixels are the grid paper behind the art
+                        if (lo > 200 && hi - lo < 24) continue;
+                        sumR += p.r; sumG += p.g; sumB += p.b;
+                        inked++;
+                    }
+                }
+                if (inked == 0) continue;
+                sf::Color out(sumR / inked, sumG / inked, sumB / inked, 255 * inked / total);
+                atlas.setPixel(slotX + padX + x, slotY + padY + y, out);
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// TILE SPRITE SELECTION
+// ----------------------------------------------------------------------------
+// Returns the atlas sprite for a map tile, or -1 for empty ground.
+// switchState is the switch's state (0/1) on a switch cell, -1 elsewhere.
+// ----------------------------------------------------------------------------
+int getTileSprite(char tile, int switchState) {
+    if (tile == '-') return SPR_TRACK_H;
+    if (tile == '|') return SPR_TRACK_V;
+    if (tile == '/' || tile == '\\') return SPR_CURVE;
+    if (tile == '+') return SPR_CROSSING;
+    if (tile == 'S') return SPR_SPAWN;
+    if (tile == 'D') return SPR_DEST;
+    if (tile == '=') return SPR_SAFETY;
+    if (switchState >= 0) return (switchState == 0) ? SPR_SWITCH_STRAIGHT : SPR_SWITCH_TURN;
+    return -1;
+}
+
+// Flat colour used when a tile's sprite is not available
+sf::Color getTileColor(char tile) {
+    if (tile == '-') return sf::Color(100, 100, 100);      // Horizontal Track
+    if (tile == '|') return sf::Color(100, 100, 100);      // Vertical Track
+    if (tile == '+') return sf::Color(120, 120, 120);      // Intersection
+    if (tile == '/' || tile == '\\') return sf::Color(100, 100, 100); // Curves
+    if (tile == 'S') return sf::Color::Cyan;               // Spawn Point
+    if (tile == 'D') return sf::Color::Magenta;            // Destination
+    if (tile == '=') return sf::Color::Blue;               // Safety Tile
+    if ((tile >= 'A' && tile <= 'Z') || tile == SWITCH_NAMED_TILE) return sf::Color(255, 200, 0); // Switches are Yellow
+    return sf::Color(50, 50, 50);                          // Default Ground
+}
+
+// Colour badge drawn under each train
+sf::Color getTrainColor(int colorCode) {
+    if (colorCode == 0) return sf::Color::Red;
+    if (colorCode == 1) return sf::Color::Green;
+    if (colorCode == 2) return sf::Color::Blue;
+    return sf::Color::White;
+}
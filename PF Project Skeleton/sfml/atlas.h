@@ -0,0 +1,50 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <SFML/Graphics.hpp>
+
+// ============================================================================
+// ATLAS.H - Packed sprite atlas shared by the window and the frame exporter
+// ============================================================================
+// Every tile and train sprite is cut out of the sheets in Sprites/ and packed
+// into one image at startup. Building the image needs no window or OpenGL
+// context, so the headless exporter can use it too.
+// ============================================================================
+#define ATLAS_SLOT 64     // Pixel size of one packed sprite
+#define ATLAS_COLUMNS 4   // Slots per atlas row
+
+// Sprite ids (slot index inside the atlas)
+#define SPR_BLANK 0            // Solid white, tinted per vertex
+#define SPR_TRACK_H 1
+#define SPR_TRACK_V 2
+#define SPR_CURVE 3            // Drawn as '/', mirrored for '\'
+#define SPR_CROSSING 4
+#define SPR_SPAWN 5
+#define SPR_DEST 6
+#define SPR_SAFETY 7
+#define SPR_SWITCH_STRAIGHT 8
+#define SPR_SWITCH_TURN 9
+#define SPR_TRAIN 10           // Faces RIGHT, rotated by direction
+#define NUM_ATLAS_SPRITES 11
+
+// ----------------------------------------------------------------------------
+// BUILDING
+// ----------------------------------------------------------------------------
+// Load the sheets and pack every sprite into 'atlas'. spriteLoaded[id] tells
+// whether the sheet of that sprite was found.
+void buildAtlasImage(sf::Image& atlas, bool spriteLoaded[NUM_ATLAS_SPRITES]);
+
+// ----------------------------------------------------------------------------
+// TILE LOOKUP
+// ----------------------------------------------------------------------------
+// Atlas sprite for a map tile, or -1 for empty ground. switchState is the
+// state (0/1) of the switch on the cell, or -1 if it is not a switch.
+int getTileSprite(char tile, int switchState);
+
+// Flat colour used when a tile's sprite is not available.
+sf::Color getTileColor(char tile);
+
+// Colour badge drawn under each train.
+sf::Color getTrainColor(int colorCode);
+
+#endif
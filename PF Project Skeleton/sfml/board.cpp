@@ -0,0 +1,167 @@
+#include "board.h"
+#include "atlas.h"
+#include "../core/switchback.h"
+#include <cstdio>
+#include <cstdlib>
+
+// ============================================================================
+// BOARD.CPP - What the window and frame export draw (NO CLASSES)
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// BOARD STATE
+// ----------------------------------------------------------------------------
+int BoardRows = 0;
+int BoardCols = 0;
+char* BoardCells = nullptr;
+
+int BoardChunkCount = 0;
+int* BoardChunkRow0 = nullptr;
+int* BoardChunkCol0 = nullptr;
+int* BoardChunkRow1 = nullptr;
+int* BoardChunkCol1 = nullptr;
+static int g_chunkSlots = 0;
+
+int* BoardSwitchAt = nullptr;
+int BoardSwitchCount = 0;
+int* BoardSwitchState = nullptr;
+
+int BoardTrainCount = 0;
+int* BoardTrainRow = nullptr;
+int* BoardTrainCol = nullptr;
+int* BoardTrainDir = nullptr;
+int* BoardTrainState = nullptr;
+int* BoardTrainColor = nullptr;
+
+char* BoardHalted = nullptr;
+
+// ----------------------------------------------------------------------------
+// Reads the allocated chunks, growing the chunk tables if the map gained
+// chunks since the last read.
+// ----------------------------------------------------------------------------
+static void readChunks(int sim) {
+    int count = sbGetChunks(sim, BoardChunkRow0, BoardChunkCol0, BoardChunkRow1, BoardChunkCol1, g_chunkSlots);
+    if (count > g_chunkSlots) {
+        int* r0 = (int*)realloc(BoardChunkRow0, sizeof(int) * count);
+        if (r0) BoardChunkRow0 = r0;
+        int* c0 = (int*)realloc(BoardChunkCol0, sizeof(int) * count);
+        if (c0) BoardChunkCol0 = c0;
+        int* r1 = (int*)realloc(BoardChunkRow1, sizeof(int) * count);
+        if (r1) BoardChunkRow1 = r1;
+        int* c1 = (int*)realloc(BoardChunkCol1, sizeof(int) * count);
+        if (c1) BoardChunkCol1 = c1;
+        if (r0 && c0 && r1 && c1) g_chunkSlots = count;
+        sbGetChunks(sim, BoardChunkRow0, BoardChunkCol0, BoardChunkRow1, BoardChunkCol1, g_chunkSlots);
+    }
+    BoardChunkCount = (count < g_chunkSlots) ? count : g_chunkSlots;
+}
+
+// ----------------------------------------------------------------------------
+// SETUP
+// ----------------------------------------------------------------------------
+// The switch layout never changes during a run, so it is read once here.
+// ----------------------------------------------------------------------------
+bool loadBoard(int sim) {
+    freeBoard();
+    sbGetMapSize(sim, &BoardRows, &BoardCols);
+    BoardSwitchCount = sbGetSwitches(sim, nullptr, nullptr, nullptr, 0);
+    BoardTrainCount = sbGetTrains(sim, nullptr, nullptr, nullptr, nullptr, 0);
+    if (BoardRows < 0 || BoardSwitchCount < 0 || BoardTrainCount < 0) return false;
+
+    int cells = BoardRows * BoardCols;
+    BoardCells = (char*)malloc(cells + 1);
+    BoardHalted = (char*)malloc(cells + 1);
+    BoardSwitchAt = (int*)malloc(sizeof(int) * (cells + 1));
+    BoardSwitchState = (int*)malloc(sizeof(int) * (BoardSwitchCount + 1));
+    BoardTrainRow = (int*)malloc(sizeof(int) * (BoardTrainCount + 1));
+    BoardTrainCol = (int*)malloc(sizeof(int) * (BoardTrainCount + 1));
+    BoardTrainDir = (int*)malloc(sizeof(int) * (BoardTrainCount + 1));
+    BoardTrainState = (int*)malloc(sizeof(int) * (BoardTrainCount + 1));
+    BoardTrainColor = (int*)malloc(sizeof(int) * (BoardTrainCount + 1));
+    if (!BoardCells || !BoardHalted || !BoardSwitchAt || !BoardSwitchState || !BoardTrainRow ||
+        !BoardTrainCol || !BoardTrainDir || !BoardTrainState || !BoardTrainColor) {
+        freeBoard();
+        return false;
+    }
+
+    for (int r = 0; r < BoardRows; r++) {
+        for (int c = 0; c < BoardCols; c++) BoardSwitchAt[r * BoardCols + c] = sbGetSwitchAt(sim, r, c);
+    }
+    sbGetTrainColors(sim, BoardTrainColor, BoardTrainCount);
+    readBoard(sim);
+    return true;
+}
+
+void freeBoard() {
+    free(BoardCells);
+    free(BoardHalted);
+    free(BoardSwitchAt);
+    free(BoardSwitchState);
+    free(BoardTrainRow);
+    free(BoardTrainCol);
+    free(BoardTrainDir);
+    free(BoardTrainState);
+    free(BoardTrainColor);
+    free(BoardChunkRow0);
+    free(BoardChunkCol0);
+    free(BoardChunkRow1);
+    free(BoardChunkCol1);
+    BoardCells = nullptr;
+    BoardHalted = nullptr;
+    BoardSwitchAt = nullptr;
+    BoardSwitchState = nullptr;
+    BoardTrainRow = nullptr;
+    BoardTrainCol = nullptr;
+    BoardTrainDir = nullptr;
+    BoardTrainState = nullptr;
+    BoardTrainColor = nullptr;
+    BoardChunkRow0 = nullptr;
+    BoardChunkCol0 = nullptr;
+    BoardChunkRow1 = nullptr;
+    BoardChunkCol1 = nullptr;
+    g_chunkSlots = 0;
+    BoardChunkCount = 0;
+}
+
+// ----------------------------------------------------------------------------
+// UPDATE
+// ----------------------------------------------------------------------------
+void readBoard(int sim) {
+    int cells = BoardRows * BoardCols;
+    sbGetMap(sim, BoardCells, cells);
+    sbGetHaltMap(sim, BoardHalted, cells);
+    sbGetSwitches(sim, BoardSwitchState, nullptr, nullptr, BoardSwitchCount);
+    sbGetTrains(sim, BoardTrainRow, BoardTrainCol, BoardTrainDir, BoardTrainState, BoardTrainCount);
+    readChunks(sim);
+}
+
+// ----------------------------------------------------------------------------
+// QUERIES
+// ----------------------------------------------------------------------------
+char getBoardTile(int r, int c) {
+    return BoardCells[r * BoardCols + c];
+}
+
+int getBoardSprite(int r, int c) {
+    int idx = BoardSwitchAt[r * BoardCols + c];
+    return getTileSprite(getBoardTile(r, c), idx >= 0 ? BoardSwitchState[idx] : -1);
+}
+
+// ----------------------------------------------------------------------------
+// REPORTS
+// ----------------------------------------------------------------------------
+void printCycleReport(int sim) {
+    if (sbGetCycleLength(sim) <= 0) return;
+    printf("Livelock: the state after tick %d repeats every %d ticks.\n",
+           sbGetCycleStart(sim), sbGetCycleLength(sim));
+    int count = sbGetTrains(sim, nullptr, nullptr, nullptr, nullptr, 0);
+    int* states = (int*)malloc(sizeof(int) * (count + 1));
+    if (!states) return;
+    sbGetTrains(sim, nullptr, nullptr, nullptr, states, count);
+    printf("Trapped trains:");
+    for (int i = 0; i < count; i++) {
+        if (states[i] == SB_TRAIN_ACTIVE) printf(" %d", i);
+    }
+    printf("\n");
+    free(states);
+}
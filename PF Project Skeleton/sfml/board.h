@@ -0,0 +1,71 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+// ============================================================================
+// BOARD.H - What the window and frame export draw (NO CLASSES)
+// ============================================================================
+// A copy of the board read through the switchback API (core/switchback.h):
+// map tiles, switch states, trains and halt zones. readBoard refreshes it
+// before a frame is drawn, so drawing code never touches core state.
+// ============================================================================
+
+// Map size and tiles (BoardCells[r * BoardCols + c])
+extern int BoardRows;
+extern int BoardCols;
+extern char* BoardCells;
+
+// Allocated chunks: cells [BoardChunkRow0[k], BoardChunkRow1[k]) x
+// [BoardChunkCol0[k], BoardChunkCol1[k]); others are empty ground
+extern int BoardChunkCount;
+extern int* BoardChunkRow0;
+extern int* BoardChunkCol0;
+extern int* BoardChunkRow1;
+extern int* BoardChunkCol1;
+
+// Switch index of each cell (-1 = not a switch) and switch states
+extern int* BoardSwitchAt;
+extern int BoardSwitchCount;
+extern int* BoardSwitchState;
+
+// Trains, indexed by train id (SB_TRAIN_* states)
+extern int BoardTrainCount;
+extern int* BoardTrainRow;
+extern int* BoardTrainCol;
+extern int* BoardTrainDir;
+extern int* BoardTrainState;
+extern int* BoardTrainColor;
+
+// 1 on cells inside an emergency halt zone
+extern char* BoardHalted;
+
+// ----------------------------------------------------------------------------
+// SETUP
+// ----------------------------------------------------------------------------
+// Size the board for sim's level and read it. Returns false without memory.
+bool loadBoard(int sim);
+
+// Free the board's buffers.
+void freeBoard();
+
+// ----------------------------------------------------------------------------
+// UPDATE
+// ----------------------------------------------------------------------------
+// Read sim's current tiles, switches, trains and halt zones.
+void readBoard(int sim);
+
+// ----------------------------------------------------------------------------
+// QUERIES
+// ----------------------------------------------------------------------------
+// Atlas sprite for cell (r, c), or -1 for empty ground.
+int getBoardSprite(int r, int c);
+
+// Tile at (r, c).
+char getBoardTile(int r, int c);
+
+// ----------------------------------------------------------------------------
+// REPORTS
+// ----------------------------------------------------------------------------
+// Print sim's livelock cycle and the trains trapped in it (nothing if none).
+void printCycleReport(int sim);
+
+#endif
@@ -0,0 +1,302 @@
+#include "frames.h"
+#include "atlas.h"
+#include "board.h"
+#include "../core/simulation_state.h"
+#include "../core/switchback.h"
+#include "../core/journal.h"
+#include <SFML/Graphics.hpp>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+// ============================================================================
+// FRAMES.CPP - Headless frame export (NO WINDOW)
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// EXPORT STATE
+// ----------------------------------------------------------------------------
+#define EXPORT_BUFFERS 32   // Frames that can wait for encoding at once
+#define MAX_EXPORT_WORKERS 64
+
+static sf::Image g_exportAtlas;
+static bool g_exportSpriteLoaded[NUM_ATLAS_SPRITES];
+static int g_frameWidth = 0;
+static int g_frameHeight = 0;
+static int g_cellPx = 16;
+static int g_frameFormat = FRAME_FORMAT_PPM;
+static char g_outDir[256];
+
+// RGBA frame buffers and the frame number each one holds
+static unsigned char* g_frameBuffers[EXPORT_BUFFERS];
+static int g_bufferFrame[EXPORT_BUFFERS];
+
+// Buffers rendered and waiting for a worker (FIFO), and buffers free to render into
+static int g_readyQueue[EXPORT_BUFFERS];
+static int g_readyHead = 0;
+static int g_readyCount = 0;
+static int g_freeStack[EXPORT_BUFFERS];
+static int g_freeCount = 0;
+static bool g_exportFinished = false;
+static int g_framesFailed = 0;
+
+static std::mutex g_exportMutex;
+static std::condition_variable g_readyCond;  // Signalled when a frame is queued
+static std::condition_variable g_freeCond;   // Signalled when a buffer is freed
+
+// ----------------------------------------------------------------------------
+// SOFTWARE RASTERIZER
+// ----------------------------------------------------------------------------
+// Fills a size x size square with a solid colour.
+// ----------------------------------------------------------------------------
+static void fillSquare(unsigned char* frame, int x0, int y0, int size, sf::Color color) {
+    for (int y = y0; y < y0 + size; y++) {
+        if (y < 0 || y >= g_frameHeight) continue;
+        for (int x = x0; x < x0 + size; x++) {
+            if (x < 0 || x >= g_frameWidth) continue;
+            unsigned char* p = frame + 4 * (y * g_frameWidth + x);
+            p[0] = color.r; p[1] = color.g; p[2] = color.b; p[3] = 255;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Draws an atlas sprite into a size x size square with alpha blending.
+// ----------------------------------------------------------------------------
+// The sprite is rotated clockwise by quarterTurns and optionally mirrored,
+// matching the texture-corner rotation used by the window renderer.
+// ----------------------------------------------------------------------------
+static void blitSprite(unsigned char* frame, int x0, int y0, int size, int sprite,
+                       int quarterTurns, bool mirror) {
+    const unsigned char* atlas = g_exportAtlas.getPixelsPtr();
+    int atlasWidth = (int)g_exportAtlas.getSize().x;
+    int slotX = (sprite % ATLAS_COLUMNS) * ATLAS_SLOT;
+    int slotY = (sprite / ATLAS_COLUMNS) * ATLAS_SLOT;
+
+    for (int dy = 0; dy < size; dy++) {
+        int y = y0 + dy;
+        if (y < 0 || y >= g_frameHeight) continue;
+        for (int dx = 0; dx < size; dx++) {
+            int x = x0 + dx;
+            if (x < 0 || x >= g_frameWidth) continue;
+
+            // Destination pixel -> slot pixel (undo the rotation, then the mirror)
+            int u = dx * ATLAS_SLOT / size;
+            int v = dy * ATLAS_SLOT / size;
+            for (int k = 0; k < quarterTurns; k++) {
+                int t = u;
+                u = v;
+                v = ATLAS_SLOT - 1 - t;
+            }
+            if (mirror) u = ATLAS_SLOT - 1 - u;
+
+            const unsigned char* s = atlas + 4 * ((slotY + v) * atlasWidth + slotX + u);
+            int alpha = s[3];
+            if (alpha == 0) continue;
+            unsigned char* p = frame + 4 * (y * g_frameWidth + x);
+            for (int ch = 0; ch < 3; ch++) {
+                p[ch] = (unsigned char)((s[ch] * alpha + p[ch] * (255 - alpha)) / 255);
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Renders the board (as last read by readBoard) into an RGBA frame.
+// ----------------------------------------------------------------------------
+// Same layers as the window: ground, tile sprites, then trains.
+// ----------------------------------------------------------------------------
+static void renderFrame(unsigned char* frame) {
+    memset(frame, 20, (size_t)g_frameWidth * g_frameHeight * 4); // Dark Grey Background
+
+    // Only allocated chunks are drawn; empty ones stay background
+    for (int k = 0; k < BoardChunkCount; k++) {
+        for (int r = BoardChunkRow0[k]; r < BoardChunkRow1[k]; r++) {
+            for (int c = BoardChunkCol0[k]; c < BoardChunkCol1[k]; c++) {
+                char tile = getBoardTile(r, c);
+                int sprite = getBoardSprite(r, c);
+                int x = c * g_cellPx;
+                int y = r * g_cellPx;
+
+                if (sprite >= 0 && !g_exportSpriteLoaded[sprite]) {
+                    fillSquare(frame, x + 1, y + 1, g_cellPx - 2, getTileColor(tile));
+                } else {
+                    fillSquare(frame, x + 1, y + 1, g_cellPx - 2, sf::Color(50, 50, 50));
+                    if (sprite >= 0) blitSprite(frame, x, y, g_cellPx, sprite, 0, tile == '\\');
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < BoardTrainCount; i++) {
+        if (BoardTrainState[i] != SB_TRAIN_ACTIVE) continue;
+        int x = BoardTrainCol[i] * g_cellPx;
+        int y = BoardTrainRow[i] * g_cellPx;
+        int inset = g_cellPx / 10;
+        fillSquare(frame, x + inset, y + inset, g_cellPx - 2 * inset, getTrainColor(BoardTrainColor[i]));
+        if (g_exportSpriteLoaded[SPR_TRAIN]) {
+            int quarterTurns = (BoardTrainDir[i] - DIR_RIGHT + 4) % 4;
+            blitSprite(frame, x, y, g_cellPx, SPR_TRAIN, quarterTurns, false);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// ENCODING
+// ----------------------------------------------------------------------------
+// Writes one RGBA frame as a binary PPM (P6). Returns true on success.
+// ----------------------------------------------------------------------------
+static bool writePPM(const char* path, const unsigned char* frame) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    fprintf(f, "P6\n%d %d\n255\n", g_frameWidth, g_frameHeight);
+
+    unsigned char* row = new unsigned char[g_frameWidth * 3];
+    for (int y = 0; y < g_frameHeight; y++) {
+        const unsigned char* src = frame + 4 * y * g_frameWidth;
+        for (int x = 0; x < g_frameWidth; x++) {
+            row[3 * x] = src[4 * x];
+            row[3 * x + 1] = src[4 * x + 1];
+            row[3 * x + 2] = src[4 * x + 2];
+        }
+        fwrite(row, 1, g_frameWidth * 3, f);
+    }
+    delete[] row;
+    return fclose(f) == 0;
+}
+
+// ----------------------------------------------------------------------------
+// Encoder thread: takes rendered frames off the queue until export ends.
+// ----------------------------------------------------------------------------
+static void encoderWorker() {
+    while (true) {
+        int buffer;
+        {
+            std::unique_lock<std::mutex> lock(g_exportMutex);
+            while (g_readyCount == 0 && !g_exportFinished) g_readyCond.wait(lock);
+            if (g_readyCount == 0) return; // Finished and drained
+            buffer = g_readyQueue[g_readyHead];
+            g_readyHead = (g_readyHead + 1) % EXPORT_BUFFERS;
+            g_readyCount--;
+        }
+
+        char path[320];
+        bool ok;
+        if (g_frameFormat == FRAME_FORMAT_PNG) {
+            snprintf(path, sizeof(path), "%s/frame_%06d.png", g_outDir, g_bufferFrame[buffer]);
+            sf::Image image;
+            image.create(g_frameWidth, g_frameHeight, g_frameBuffers[buffer]);
+            ok = image.saveToFile(path);
+        } else {
+            snprintf(path, sizeof(path), "%s/frame_%06d.ppm", g_outDir, g_bufferFrame[buffer]);
+            ok = writePPM(path, g_frameBuffers[buffer]);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(g_exportMutex);
+            if (!ok) g_framesFailed++;
+            g_freeStack[g_freeCount++] = buffer;
+        }
+        g_freeCond.notify_one();
+    }
+}
+
+// ----------------------------------------------------------------------------
+// RUN FRAME EXPORT
+// ----------------------------------------------------------------------------
+// The main thread simulates and rasterizes; encoder threads write the files.
+// At most EXPORT_BUFFERS frames are in flight, so memory stays bounded.
+// ----------------------------------------------------------------------------
+bool runFrameExport(int sim, const char* outDir, int maxTicks, int format, int workers, int cellSize) {
+    mkdir(outDir, 0755); // Fine if it already exists
+    snprintf(g_outDir, sizeof(g_outDir), "%s", outDir);
+
+    char probe[320];
+    snprintf(probe, sizeof(probe), "%s/.write_test", g_outDir);
+    FILE* test = fopen(probe, "w");
+    if (!test) {
+        printf("Error: cannot write to %s\n", outDir);
+        return false;
+    }
+    fclose(test);
+    remove(probe);
+
+    if (workers <= 0) workers = (int)std::thread::hardware_concurrency();
+    if (workers <= 0) workers = 2;
+    if (workers > MAX_EXPORT_WORKERS) workers = MAX_EXPORT_WORKERS;
+
+    if (!loadBoard(sim)) {
+        printf("Error: out of memory\n");
+        return false;
+    }
+    g_frameFormat = format;
+    g_cellPx = (cellSize > 2) ? cellSize : 16;
+    g_frameWidth = BoardCols * g_cellPx;
+    g_frameHeight = BoardRows * g_cellPx;
+    buildAtlasImage(g_exportAtlas, g_exportSpriteLoaded);
+
+    g_readyHead = 0;
+    g_readyCount = 0;
+    g_freeCount = 0;
+    g_exportFinished = false;
+    g_framesFailed = 0;
+    for (int b = 0; b < EXPORT_BUFFERS; b++) {
+        g_frameBuffers[b] = new unsigned char[(size_t)g_frameWidth * g_frameHeight * 4];
+        g_freeStack[g_freeCount++] = b;
+    }
+
+    std::thread pool[MAX_EXPORT_WORKERS];
+    for (int w = 0; w < workers; w++) pool[w] = std::thread(encoderWorker);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int frame = 0;
+    while (true) {
+        int buffer;
+        {
+            std::unique_lock<std::mutex> lock(g_exportMutex);
+            while (g_freeCount == 0) g_freeCond.wait(lock);
+            buffer = g_freeStack[--g_freeCount];
+        }
+
+        readBoard(sim);
+        renderFrame(g_frameBuffers[buffer]);
+        g_bufferFrame[buffer] = frame;
+        {
+            std::lock_guard<std::mutex> lock(g_exportMutex);
+            g_readyQueue[(g_readyHead + g_readyCount) % EXPORT_BUFFERS] = buffer;
+            g_readyCount++;
+        }
+        g_readyCond.notify_one();
+        frame++;
+
+        if (sbGetTick(sim) >= maxTicks || sbIsComplete(sim)) break;
+        applyJournalInputs(); // No-op unless a journal is being replayed
+        sbStep(sim, 1);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_exportMutex);
+        g_exportFinished = true;
+    }
+    g_readyCond.notify_all();
+    for (int w = 0; w < workers; w++) pool[w].join();
+
+    for (int b = 0; b < EXPORT_BUFFERS; b++) {
+        delete[] g_frameBuffers[b];
+        g_frameBuffers[b] = nullptr;
+    }
+    freeBoard();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Exported %d frames (%dx%d) to %s in %.2f s (%.1f frames/s, %d encoder threads)\n",
+           frame, g_frameWidth, g_frameHeight, outDir, seconds,
+           seconds > 0.0 ? frame / seconds : 0.0, workers);
+    if (g_framesFailed > 0) {
+        printf("Warning: %d frames could not be written\n", g_framesFailed);
+    }
+    return g_framesFailed == 0;
+}
@@ -0,0 +1,26 @@
+#ifndef FRAMES_H
+#define FRAMES_H
+
+// ============================================================================
+// FRAMES.H - Headless frame export (NO WINDOW)
+// ============================================================================
+// Renders the board after every tick with a software rasterizer and writes
+// numbered images, without opening a window or needing a display. Image
+// encoding runs on a pool of worker threads so export is CPU bound.
+// ============================================================================
+
+// Image formats
+#define FRAME_FORMAT_PPM 0
+#define FRAME_FORMAT_PNG 1
+
+// ----------------------------------------------------------------------------
+// EXPORT
+// ----------------------------------------------------------------------------
+// Run simulation sim for up to maxTicks ticks (or until complete) and write
+// outDir/frame_000000.<ext>, one frame per tick starting with the initial
+// state. cellSize is the size of one grid cell in pixels; workers is the
+// number of encoder threads (0 = one per CPU core).
+// Returns false if the output directory cannot be written.
+bool runFrameExport(int sim, const char* outDir, int maxTicks, int format, int workers, int cellSize);
+
+#endif
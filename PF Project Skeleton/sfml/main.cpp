@@ -1,8 +1,15 @@
 #include "app.h"
-#include "../core/simulation_state.h"
-#include "../core/simulation.h"
+#include "board.h"
+#include "../core/switchback.h"
 #include "../core/io.h"
+#include "../core/journal.h"
+#include "../core/timeline.h"
+#include "../core/trace_index.h"
+#include "frames.h"
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
 using namespace std;
 // ============================================================================
 // MAIN.CPP - Entry point of the application (NO CLASSES)
@@ -18,50 +25,168 @@ using namespace std;
 // main application loop, cleans up resources, and prints final simulation
 // statistics. Returns 0 on success, 1 on error (e.g., failed to load level
 // file or initialize application).
+//
+// With --export-frames <dir> no window is opened: the level is simulated
+// headlessly and every tick is written as a numbered image into <dir>.
+//
+// Interactive sessions record every click into out/journal.txt and keep
+// checkpoints so the timeline bar can seek back and forth. With
+// --replay <journal> the level is re-run with those inputs at full speed and
+// no window, which reproduces the session's trace.csv exactly.
+//
+// With --replay-trace <trace.csv> nothing is simulated: the window plays a
+// recorded trace over the level's map, reading one tick at a time through
+// the trace index.
 // ----------------------------------------------------------------------------
 int main(int argc, char* argv[]) {
     // Handles Command Line Arguments
     if (argc < 2) {
-        cout << "Usage: ./switchback_rails <level_file_path>" << endl;
+        cout << "Usage: ./switchback_rails <level_file_path> [options]" << endl;
         cout << "Example: ./switchback_rails data/levels/easy_level.lvl" << endl;
+        cout << "Headless export options:" << endl;
+        cout << "  --export-frames <dir>  Write one image per tick, no window" << endl;
+        cout << "  --ticks <n>            Stop after n ticks (default 1000)" << endl;
+        cout << "  --format png|ppm       Image format (default png)" << endl;
+        cout << "  --workers <n>          Encoder threads (default: CPU cores)" << endl;
+        cout << "  --cell <px>            Cell size in pixels (default 16)" << endl;
+        cout << "  --replay <journal>     Re-run a recorded session, no window" << endl;
+        cout << "  --replay-trace <csv>   Play back a recorded trace.csv in the window" << endl;
+        cout << "  --hash-log             Write the per-tick state hash to out/hash.csv" << endl;
+        cout << "  --log-drop             Drop log rows instead of waiting when the writer lags" << endl;
+        cout << "  --log <levels>         Per-log level, e.g. trace=events,signals=off,hash=sampled:100" << endl;
+        cout << "  --threads <n>          Simulation threads on busy maps (default: CPU cores)" << endl;
+        cout << "Timeline options:" << endl;
+        cout << "  --checkpoint-every <n> Ticks between seek checkpoints (default 16)" << endl;
+        cout << "  --checkpoint-mb <n>    Memory for checkpoints in MB (default 64)" << endl;
         return 1;
     }
 
+    // Optional flags after the level path
+    const char* exportDir = nullptr;
+    int exportTicks = 1000;
+    int exportFormat = FRAME_FORMAT_PNG;
+    int exportWorkers = 0;
+    int exportCell = 16;
+    const char* replayPath = nullptr;
+    const char* replayTracePath = nullptr;
+    bool ticksGiven = false;
+    int checkpointEvery = TIMELINE_DEFAULT_INTERVAL;
+    long checkpointBudget = TIMELINE_DEFAULT_BUDGET;
+    for (int a = 2; a < argc; a++) {
+        if (strcmp(argv[a], "--export-frames") == 0 && a + 1 < argc) exportDir = argv[++a];
+        else if (strcmp(argv[a], "--ticks") == 0 && a + 1 < argc) {
+            exportTicks = atoi(argv[++a]);
+            ticksGiven = true;
+        }
+        else if (strcmp(argv[a], "--replay") == 0 && a + 1 < argc) replayPath = argv[++a];
+        else if (strcmp(argv[a], "--replay-trace") == 0 && a + 1 < argc) replayTracePath = argv[++a];
+        else if (strcmp(argv[a], "--hash-log") == 0) sbSetHashLog(1);
+        else if (strcmp(argv[a], "--log-drop") == 0) sbSetLogDrop(1);
+        else if (strcmp(argv[a], "--log") == 0 && a + 1 < argc) {
+            if (sbSetLogLevels(argv[++a]) != 0) return 1;
+        }
+        else if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc) sbSetThreads(atoi(argv[++a]));
+        else if (strcmp(argv[a], "--workers") == 0 && a + 1 < argc) exportWorkers = atoi(argv[++a]);
+        else if (strcmp(argv[a], "--cell") == 0 && a + 1 < argc) exportCell = atoi(argv[++a]);
+        else if (strcmp(argv[a], "--checkpoint-every") == 0 && a + 1 < argc) checkpointEvery = atoi(argv[++a]);
+        else if (strcmp(argv[a], "--checkpoint-mb") == 0 && a + 1 < argc) {
+            checkpointBudget = atol(argv[++a]) * 1024L * 1024L;
+        }
+        else if (strcmp(argv[a], "--format") == 0 && a + 1 < argc) {
+            a++;
+            exportFormat = (strcmp(argv[a], "ppm") == 0) ? FRAME_FORMAT_PPM : FRAME_FORMAT_PNG;
+        }
+        else {
+            cout << "Unknown option: " << argv[a] << endl;
+            return 1;
+        }
+    }
+
     // Loads the Level File
     // argv[1] contains the path string (e.g. easy level)
+    // The window reads the simulation through the switchback API (board.h)
+    // A trace replay only reads out/, so loading must not clear the logs
+    if (replayTracePath) sbSetLogging(0);
+
     cout << "Loading level: " << argv[1] << "..." << endl;
-    if (!loadLevelFile(argv[1])) {
+    int sim = sbCreateFromFile(argv[1]);
+    if (sim < 0) {
         cout << "Error: Failed to load level file." << endl;
         return 1;
     }
-    
-    // Initializes Simulation Logic
-    initializeSimulation(); // Sets up any runtime counters (in simulation.cpp)
+
+    // Replay: load the recorded inputs (also used by frame export)
+    if (replayPath && !loadJournal(replayPath)) return 1;
+
+    // Headless export: no window, so it also works without a display
+    if (exportDir) {
+        bool ok = runFrameExport(sim, exportDir, exportTicks, exportFormat, exportWorkers, exportCell);
+        printCycleReport(sim);
+        writeMetrics();
+        return ok ? 0 : 1;
+    }
+
+    if (replayPath) {
+        clock_t start = clock();
+        runJournalReplay(ticksGiven ? exportTicks : 1000000);
+        double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+        cout << "Replayed " << sbGetTick(sim) << " ticks in " << seconds << " s" << endl;
+        printCycleReport(sim);
+        writeMetrics();
+        return 0;
+    }
 
     // Initializes SFML Application
-    if (!initializeApp()) {
+    if (!initializeApp(sim)) {
         cout << "Error: Failed to initialize application window." << endl;
         return 1;
     }
 
+    if (replayTracePath) {
+        if (!openTraceReplay(replayTracePath)) return 1;
+        cout << "Replaying " << replayTracePath << ": " << getIndexedTicks() << " ticks" << endl;
+        cout << " SPACE / . / , : Play-pause / step / step back" << endl;
+        cout << " UP / DOWN     : Double / halve playback speed" << endl;
+        cout << " Timeline bar  : Click/drag to seek" << endl;
+        runApp();
+        cleanupApp();
+        closeTraceIndex();
+        sbDestroy(sim);
+        return 0;
+    }
+
     // Prints Controls
     cout << "========================================" << endl;
     cout << "       SWITCHBACK RAILS CONTROL         " << endl;
     cout << "========================================" << endl;
     cout << " SPACE        : Pause/Resume" << endl;
     cout << " . (Period)   : Step forward one tick" << endl;
+    cout << " , (Comma)    : Step back one tick" << endl;
+    cout << " Timeline bar : Click/drag to seek" << endl;
     cout << " Left-Click   : Toggle Safety Tile (=)" << endl;
     cout << " Right-Click  : Toggle Switch State" << endl;
     cout << " Middle-Drag  : Pan Camera" << endl;
     cout << " Mouse Wheel  : Zoom In/Out" << endl;
+    cout << " H            : Heatmap (off/holds/flips)" << endl;
+    cout << " W            : Heatmap window (all/50/200/1000)" << endl;
+    cout << " P            : Export heatmaps to out/" << endl;
+    cout << " E / Shift+E  : Emergency halt (3x3 / circle) at mouse" << endl;
     cout << " ESC          : Exit and Save" << endl;
     cout << "========================================" << endl;
 
+    // Records operator inputs so the session can be replayed
+    startJournal("out/journal.txt", argv[1]);
+
+    // Checkpoints for seeking back (inputs come from the journal)
+    if (!initializeTimeline(checkpointEvery, checkpointBudget)) return 1;
+
     // Runs the Application Loop
     runApp();
 
     // Cleans up Resources
     cleanupApp();
+    closeJournal();
+    sbDestroy(sim);
     
     // Prints Final Statistics 
     cout << "Simulation ended." << endl;
@@ -0,0 +1,200 @@
+#include "../core/switchback.h"
+#include "../core/thread_pool.h"
+#include "../core/log_writer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// ============================================================================
+// THREAD_TEST.CPP - Same run on any number of threads
+// ============================================================================
+// Runs one busy level with every tick loop forced onto the thread pool
+// (setPoolMinItems(1)) on 1, 2, 4 and 8 threads, and checks that the state
+// hash of every tick and the trace, switch and signal logs are the same as
+// a plain single-threaded run. Stealing is off in the forced runs, so every
+// worker runs its share of every loop even on a machine with one core. The
+// logs are written in a scratch directory.
+//
+// Usage: ./thread_test   (exit status 0 = pass)
+// ============================================================================
+
+#define TEST_ROWS 48
+#define TEST_COLS 48
+#define TEST_TRAINS 100
+#define TEST_TICKS 300
+#define TEST_LEVEL_BYTES 16384
+#define TEST_LOG_BYTES (4 << 20)
+
+static const char* TestLogs[3] = { "out/trace.csv", "out/switches.csv", "out/signals.csv" };
+
+char LevelText[TEST_LEVEL_BYTES];
+
+// Reference run (one thread, built-in loop sizes)
+unsigned long long RefHash[TEST_TICKS];
+char* RefLog[3];
+
+unsigned long long RunHash[TEST_TICKS];
+char* RunLog[3];
+
+// ----------------------------------------------------------------------------
+// TEST LEVEL
+// ----------------------------------------------------------------------------
+// A mesh of crossings with letter and named switches every 6 cells, a few
+// destinations, and trains spawning all over it during the first 50 ticks.
+// ----------------------------------------------------------------------------
+static unsigned int TestRandom = 12345;
+
+static int nextRandom(int range) {
+    TestRandom = TestRandom * 1103515245u + 12345u;
+    return (int)((TestRandom >> 16) % (unsigned int)range);
+}
+
+static int buildTestLevel() {
+    char map[TEST_ROWS][TEST_COLS + 1];
+    for (int r = 0; r < TEST_ROWS; r++) {
+        for (int c = 0; c < TEST_COLS; c++) map[r][c] = '+';
+        map[r][TEST_COLS] = '\0';
+    }
+    const char* letters = "ABCEFGHIJKLMNOPQ";
+    int named = 0;
+    for (int r = 3; r < TEST_ROWS; r += 6) {
+        for (int c = 3; c < TEST_COLS; c += 6) {
+            if ((r + c) % 4 == 0) map[r][c] = '@';
+            else map[r][c] = letters[(r / 6 * 8 + c / 6) % 16];
+        }
+    }
+    for (int k = 0; k < 6; k++) map[nextRandom(TEST_ROWS)][nextRandom(TEST_COLS)] = 'D';
+
+    int len = snprintf(LevelText, sizeof(LevelText),
+                       "NAME:\nThread test\nROWS:\n%d\nCOLS:\n%d\nSEED:\n7\nWEATHER:\nRAIN\nMAP:\n",
+                       TEST_ROWS, TEST_COLS);
+    for (int r = 0; r < TEST_ROWS; r++) len += snprintf(LevelText + len, sizeof(LevelText) - len, "%s\n", map[r]);
+
+    len += snprintf(LevelText + len, sizeof(LevelText) - len, "\nSWITCHES:\n");
+    for (int k = 0; k < 16; k++) {
+        len += snprintf(LevelText + len, sizeof(LevelText) - len, "%c %s 0 %d %d %d %d L R\n", letters[k],
+                        k % 3 ? "PER_DIR" : "GLOBAL", 1 + k % 3, 2, 1 + k % 2, 3);
+    }
+    for (int r = 3; r < TEST_ROWS; r += 6) {
+        for (int c = 3; c < TEST_COLS; c += 6) {
+            if (map[r][c] != '@') continue;
+            len += snprintf(LevelText + len, sizeof(LevelText) - len, "N%d AT %d %d PER_DIR 1 1 2 1 2 L R\n",
+                            named++, c + 1, r + 1);
+        }
+    }
+
+    len += snprintf(LevelText + len, sizeof(LevelText) - len, "\nTRAINS:\n");
+    for (int i = 0; i < TEST_TRAINS; i++) {
+        int r, c;
+        do {
+            r = nextRandom(TEST_ROWS);
+            c = nextRandom(TEST_COLS);
+        } while (map[r][c] != '+');
+        len += snprintf(LevelText + len, sizeof(LevelText) - len, "%d %d %d %d %d\n",
+                        i / 2, c + 1, r + 1, nextRandom(4), i % 5);
+    }
+    return len;
+}
+
+// ----------------------------------------------------------------------------
+// ONE RUN
+// ----------------------------------------------------------------------------
+// Reads a whole log file into a new buffer (NULL if it cannot be read).
+static char* readLog(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+    char* text = (char*)malloc(TEST_LOG_BYTES);
+    int length = (int)fread(text, 1, TEST_LOG_BYTES - 1, file);
+    text[length] = '\0';
+    fclose(file);
+    return text;
+}
+
+static bool runLevel(int threads, int minItems, unsigned long long* hashes, char** logs) {
+    setPoolThreads(threads);
+    setPoolMinItems(minItems);
+    setPoolStealing(minItems == 0);
+    int sim = sbCreateFromBuffer(LevelText, (int)strlen(LevelText));
+    if (sim < 0) return false;
+    for (int t = 0; t < TEST_TICKS; t++) {
+        sbStep(sim, 1);
+        hashes[t] = sbGetStateHash(sim);
+    }
+    sbDestroy(sim);
+    flushLogWriter();
+    for (int s = 0; s < 3; s++) {
+        logs[s] = readLog(TestLogs[s]);
+        if (!logs[s]) return false;
+    }
+    return true;
+}
+
+static int countLines(const char* text) {
+    int lines = 0;
+    for (; *text; text++) lines += *text == '\n';
+    return lines;
+}
+
+int main() {
+    // Logs go to <scratch>/out/, not over the project's out/
+    char scratch[] = "/tmp/thread_test_XXXXXX";
+    if (!mkdtemp(scratch) || chdir(scratch) != 0 || mkdir("out", 0755) != 0) {
+        printf("Error: cannot create a scratch directory\n");
+        return 1;
+    }
+
+    buildTestLevel();
+    sbSetLogging(1);
+    if (!runLevel(1, 0, RefHash, RefLog)) {
+        printf("Error: reference run failed\n");
+        return 1;
+    }
+    int traceRows = countLines(RefLog[0]) - 1;
+    int flips = countLines(RefLog[1]) - 1;
+    printf("Reference: %d ticks, %d trace rows, %d switch flips\n", TEST_TICKS, traceRows, flips);
+
+    int failures = 0;
+    if (traceRows < TEST_TICKS || flips == 0) {
+        printf("FAIL: the test level does not keep trains running\n");
+        failures++;
+    }
+
+    const int threadCounts[4] = { 1, 2, 4, 8 };
+    for (int k = 0; k < 4; k++) {
+        int threads = threadCounts[k];
+        if (!runLevel(threads, 1, RunHash, RunLog)) {
+            printf("FAIL: %d threads: run failed\n", threads);
+            failures++;
+            continue;
+        }
+        int firstBad = -1;
+        for (int t = 0; t < TEST_TICKS && firstBad < 0; t++) {
+            if (RunHash[t] != RefHash[t]) firstBad = t;
+        }
+        if (firstBad >= 0) {
+            printf("FAIL: %d threads: state hash differs from tick %d\n", threads, firstBad + 1);
+            failures++;
+        }
+        for (int s = 0; s < 3; s++) {
+            if (strcmp(RunLog[s], RefLog[s]) != 0) {
+                printf("FAIL: %d threads: %s differs\n", threads, TestLogs[s]);
+                failures++;
+            }
+            free(RunLog[s]);
+        }
+        if (firstBad < 0) printf("%d threads: %d hashes checked\n", threads, TEST_TICKS);
+    }
+
+    for (int s = 0; s < 3; s++) {
+        unlink(TestLogs[s]);
+        free(RefLog[s]);
+    }
+    unlink("out/hash.csv");
+    rmdir("out");
+    if (chdir("/") == 0) rmdir(scratch);
+
+    printf(failures ? "FAILED (%d)\n" : "PASSED\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,107 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// ============================================================================
+// HASHDIFF.CPP - Compare two hash.csv files
+// ============================================================================
+// Reports the first tick at which two runs (written with --hash-log) differ.
+// Both files are read whole and compared with memcmp, so only the line with
+// the first differing byte is ever parsed.
+//
+// Usage: ./hashdiff <a/hash.csv> <b/hash.csv>
+// Exit code: 0 = identical, 1 = runs diverge, 2 = error
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Reads a whole file into a malloc'd buffer. Returns NULL on failure.
+// ----------------------------------------------------------------------------
+char* readWholeFile(const char* filename, long* size) {
+    FILE* f = fopen(filename, "rb");
+    if (!f) {
+        printf("Error: Could not open %s\n", filename);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    char* data = (char*)malloc(*size + 1);
+    if (data && fread(data, 1, *size, f) != (size_t)*size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    if (!data) {
+        printf("Error: Could not read %s\n", filename);
+        return NULL;
+    }
+    data[*size] = '\0';
+    return data;
+}
+
+// ----------------------------------------------------------------------------
+// Prints the "tick,hash" line that starts at offset (or "end of file").
+// ----------------------------------------------------------------------------
+void printLine(const char* label, const char* data, long size, long offset) {
+    if (offset >= size) {
+        printf("  %s: end of file\n", label);
+        return;
+    }
+    const char* end = strchr(data + offset, '\n');
+    int length = end ? (int)(end - (data + offset)) : (int)(size - offset);
+    printf("  %s: %.*s\n", label, length, data + offset);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        printf("Usage: ./hashdiff <a/hash.csv> <b/hash.csv>\n");
+        return 2;
+    }
+
+    long sizeA, sizeB;
+    char* a = readWholeFile(argv[1], &sizeA);
+    if (!a) return 2;
+    char* b = readWholeFile(argv[2], &sizeB);
+    if (!b) {
+        free(a);
+        return 2;
+    }
+
+    long common = sizeA < sizeB ? sizeA : sizeB;
+    int result = 0;
+    if (sizeA == sizeB && memcmp(a, b, common) == 0) {
+        int lines = 0;
+        for (long i = 0; i < sizeA; i++) {
+            if (a[i] == '\n') lines++;
+        }
+        printf("Identical: %d ticks\n", lines > 0 ? lines - 1 : 0);
+    } else {
+        // Find the first differing byte a chunk at a time
+        long pos = 0;
+        const long CHUNK = 4096;
+        while (pos + CHUNK <= common && memcmp(a + pos, b + pos, CHUNK) == 0) pos += CHUNK;
+        while (pos < common && a[pos] == b[pos]) pos++;
+
+        // Back up to the start of that line
+        long lineStart = pos;
+        while (lineStart > 0 && a[lineStart - 1] != '\n') lineStart--;
+
+        int tick = -1;
+        if (lineStart < sizeA) tick = atoi(a + lineStart);
+        else if (lineStart < sizeB) tick = atoi(b + lineStart);
+
+        if (lineStart >= sizeA || lineStart >= sizeB) {
+            printf("Runs match until one ends; first extra tick: %d\n", tick);
+        } else {
+            printf("First divergent tick: %d\n", tick);
+        }
+        printLine(argv[1], a, sizeA, lineStart);
+        printLine(argv[2], b, sizeB, lineStart);
+        result = 1;
+    }
+
+    free(a);
+    free(b);
+    return result;
+}
@@ -0,0 +1,257 @@
+#include "../core/io.h"
+#include "../core/simulation.h"
+#include "../core/simulation_state.h"
+#include "../core/rng.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// ============================================================================
+// OPTIMIZER.CPP - Switch configuration search
+// ============================================================================
+// Searches the initial switch states and K-values of a level for the setup
+// that delivers the most trains in the fewest ticks, then writes it out as a
+// new .lvl file.
+//
+// The level is parsed once. Every candidate is run in a fork()ed child, which
+// starts from a copy of the freshly loaded state, applies its switch settings,
+// simulates and sends the result back through a pipe. Up to --jobs children
+// run at the same time.
+//
+// Usage: ./optimizer <in.lvl> <out.lvl> [--iterations N] [--jobs N]
+//                    [--ticks N] [--seed S]
+// ============================================================================
+
+#define MAX_JOBS 64
+#define MIN_K 1
+#define MAX_K 9
+
+// ----------------------------------------------------------------------------
+// CANDIDATE STORAGE
+// ----------------------------------------------------------------------------
+// One candidate = initial state + 4 K-values for every switch.
+// ----------------------------------------------------------------------------
+int BestState[MAX_SWITCHES];
+int BestK[MAX_SWITCHES][4];
+int BestArrived, BestCrashed, BestTicks;
+
+int CandState[MAX_JOBS][MAX_SWITCHES];
+int CandK[MAX_JOBS][MAX_SWITCHES][4];
+int CandArrived[MAX_JOBS], CandCrashed[MAX_JOBS], CandTicks[MAX_JOBS];
+
+int UsedSwitches[MAX_SWITCHES];
+int NumUsedSwitches = 0;
+
+// ----------------------------------------------------------------------------
+// SCORE COMPARISON
+// ----------------------------------------------------------------------------
+// More arrivals first, then fewer crashes, then fewer ticks.
+// ----------------------------------------------------------------------------
+bool isBetterResult(int arrivedA, int crashedA, int ticksA,
+                    int arrivedB, int crashedB, int ticksB) {
+    if (arrivedA != arrivedB) return arrivedA > arrivedB;
+    if (crashedA != crashedB) return crashedA < crashedB;
+    return ticksA < ticksB;
+}
+
+// ----------------------------------------------------------------------------
+// RUN ONE CANDIDATE (child process)
+// ----------------------------------------------------------------------------
+// Applies the candidate to the inherited post-load state and simulates.
+// ----------------------------------------------------------------------------
+void runCandidate(int slot, int maxTicks, int* result) {
+    for (int i = 0; i < SwitchCount; i++) {
+        if (!SwitchExists[i]) continue;
+        SwitchCurrentState[i] = CandState[slot][i];
+        for (int k = 0; k < 4; k++) SwitchFlipThresholds[i][k] = CandK[slot][i][k];
+    }
+
+    initializeSimulation();
+    while (CurrentTick < maxTicks && !isSimulationComplete()) {
+        simulateOneTick();
+    }
+
+    result[0] = 0;
+    result[1] = 0;
+    for (int i = 0; i < TotalScheduledTrains; i++) {
+        if (TrainState[i] == 2) result[0]++;
+        else if (TrainState[i] == 3) result[1]++;
+    }
+    result[2] = CurrentTick;
+}
+
+// ----------------------------------------------------------------------------
+// EVALUATE CANDIDATES IN PARALLEL
+// ----------------------------------------------------------------------------
+// Forks one child per candidate and collects the results.
+// ----------------------------------------------------------------------------
+bool evaluateCandidates(int count, int maxTicks) {
+    pid_t pids[MAX_JOBS];
+    int fds[MAX_JOBS];
+
+    for (int j = 0; j < count; j++) {
+        int p[2];
+        if (pipe(p) != 0) {
+            perror("pipe");
+            return false;
+        }
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return false;
+        }
+        if (pid == 0) {
+            close(p[0]);
+            int result[3];
+            runCandidate(j, maxTicks, result);
+            ssize_t written = write(p[1], result, sizeof(result));
+            _exit(written == (ssize_t)sizeof(result) ? 0 : 1);
+        }
+        close(p[1]);
+        pids[j] = pid;
+        fds[j] = p[0];
+    }
+
+    bool ok = true;
+    for (int j = 0; j < count; j++) {
+        int result[3];
+        ssize_t got = read(fds[j], result, sizeof(result));
+        close(fds[j]);
+        waitpid(pids[j], NULL, 0);
+        if (got != (ssize_t)sizeof(result)) {
+            printf("Error: candidate %d did not report a result\n", j);
+            ok = false;
+            continue;
+        }
+        CandArrived[j] = result[0];
+        CandCrashed[j] = result[1];
+        CandTicks[j] = result[2];
+    }
+    return ok;
+}
+
+// ----------------------------------------------------------------------------
+// MUTATE
+// ----------------------------------------------------------------------------
+// Copies the best configuration into a slot and changes 1-3 values in it.
+// Draws are keyed by (seed, round, slot, draw number), so a round gives the
+// same mutants whatever order the slots are filled in.
+// ----------------------------------------------------------------------------
+int mutationDraw(int seed, int round, int slot, int& draw, int n) {
+    return rngBelow(seed, round, slot * 64 + draw++, RNG_STREAM_OPTIMIZER, n);
+}
+
+void mutateCandidate(int slot, int seed, int round) {
+    memcpy(CandState[slot], BestState, sizeof(BestState));
+    memcpy(CandK[slot], BestK, sizeof(BestK));
+
+    int draw = 0;
+    int changes = 1 + mutationDraw(seed, round, slot, draw, 3);
+    for (int n = 0; n < changes; n++) {
+        int sw = UsedSwitches[mutationDraw(seed, round, slot, draw, NumUsedSwitches)];
+        int gene = mutationDraw(seed, round, slot, draw, 5); // 0 = initial state, 1-4 = K per direction
+        if (gene == 0) {
+            CandState[slot][sw] = 1 - CandState[slot][sw];
+        } else {
+            int k = CandK[slot][sw][gene - 1] + (mutationDraw(seed, round, slot, draw, 2) ? 1 : -1);
+            if (k < MIN_K) k = MIN_K;
+            if (k > MAX_K) k = MAX_K;
+            CandK[slot][sw][gene - 1] = k;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        printf("Usage: ./optimizer <in.lvl> <out.lvl> [--iterations N] [--jobs N] [--ticks N] [--seed S]\n");
+        return 1;
+    }
+
+    int iterations = 50;
+    int jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int maxTicks = 500;
+    int seed = 1;
+    for (int a = 3; a < argc; a++) {
+        if (a + 1 < argc && strcmp(argv[a], "--iterations") == 0) iterations = atoi(argv[++a]);
+        else if (a + 1 < argc && strcmp(argv[a], "--jobs") == 0) jobs = atoi(argv[++a]);
+        else if (a + 1 < argc && strcmp(argv[a], "--ticks") == 0) maxTicks = atoi(argv[++a]);
+        else if (a + 1 < argc && strcmp(argv[a], "--seed") == 0) seed = atoi(argv[++a]);
+        else {
+            printf("Error: unknown option %s\n", argv[a]);
+            return 1;
+        }
+    }
+    if (jobs < 1) jobs = 1;
+    if (jobs > MAX_JOBS) jobs = MAX_JOBS;
+
+    setLoggingEnabled(false);
+    if (!loadLevelFile(argv[1])) {
+        printf("Error: Failed to load level file.\n");
+        return 1;
+    }
+
+    for (int i = 0; i < SwitchCount; i++) {
+        if (!SwitchExists[i]) continue;
+        UsedSwitches[NumUsedSwitches++] = i;
+        BestState[i] = SwitchCurrentState[i];
+        for (int k = 0; k < 4; k++) BestK[i][k] = SwitchFlipThresholds[i][k];
+    }
+
+    // Baseline: the configuration as written in the level
+    memcpy(CandState[0], BestState, sizeof(BestState));
+    memcpy(CandK[0], BestK, sizeof(BestK));
+    if (!evaluateCandidates(1, maxTicks)) return 1;
+    BestArrived = CandArrived[0];
+    BestCrashed = CandCrashed[0];
+    BestTicks = CandTicks[0];
+    printf("Baseline: %d arrived, %d crashed, %d ticks\n", BestArrived, BestCrashed, BestTicks);
+
+    if (NumUsedSwitches == 0) {
+        printf("Level has no switches, nothing to optimize.\n");
+        iterations = 0;
+    }
+
+    // (1 + jobs) local search: keep the best, try `jobs` mutants per round.
+    // Ties are accepted so the search can move across flat regions.
+    for (int it = 0; it < iterations; it++) {
+        for (int j = 0; j < jobs; j++) mutateCandidate(j, seed, it);
+        if (!evaluateCandidates(jobs, maxTicks)) return 1;
+
+        int pick = -1;
+        for (int j = 0; j < jobs; j++) {
+            bool beatsBest = !isBetterResult(BestArrived, BestCrashed, BestTicks,
+                                             CandArrived[j], CandCrashed[j], CandTicks[j]);
+            if (!beatsBest) continue;
+            if (pick < 0 || isBetterResult(CandArrived[j], CandCrashed[j], CandTicks[j],
+                                           CandArrived[pick], CandCrashed[pick], CandTicks[pick])) {
+                pick = j;
+            }
+        }
+        if (pick < 0) continue;
+
+        if (isBetterResult(CandArrived[pick], CandCrashed[pick], CandTicks[pick],
+                           BestArrived, BestCrashed, BestTicks)) {
+            printf("Round %d: %d arrived, %d crashed, %d ticks\n", it + 1,
+                   CandArrived[pick], CandCrashed[pick], CandTicks[pick]);
+        }
+        memcpy(BestState, CandState[pick], sizeof(BestState));
+        memcpy(BestK, CandK[pick], sizeof(BestK));
+        BestArrived = CandArrived[pick];
+        BestCrashed = CandCrashed[pick];
+        BestTicks = CandTicks[pick];
+    }
+
+    for (int i = 0; i < SwitchCount; i++) {
+        if (!SwitchExists[i]) continue;
+        SwitchCurrentState[i] = BestState[i];
+        for (int k = 0; k < 4; k++) SwitchFlipThresholds[i][k] = BestK[i][k];
+    }
+    if (!saveLevelFile(argv[2])) return 1;
+
+    printf("Best: %d arrived, %d crashed, %d ticks\n", BestArrived, BestCrashed, BestTicks);
+    printf("Saved to %s\n", argv[2]);
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "../core/trace_index.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+
+// ============================================================================
+// TRACEIDX.CPP - Query a trace.csv through its index
+// ============================================================================
+// The index (<trace>.idx) is built on first use, and again whenever the trace
+// has changed since. Queries print the matching trace.csv rows.
+//
+// Usage: ./traceidx <trace.csv> build
+//        ./traceidx <trace.csv> info
+//        ./traceidx <trace.csv> train <id> [<from> <to>]
+//        ./traceidx <trace.csv> tick <t>
+//        ./traceidx <trace.csv> cell <x> <y> [<from> <to>]
+// Exit code: 0 = ok, 1 = error
+// ============================================================================
+
+void printUsage() {
+    printf("Usage: ./traceidx <trace.csv> build\n");
+    printf("       ./traceidx <trace.csv> info\n");
+    printf("       ./traceidx <trace.csv> train <id> [<from> <to>]   one train's rows\n");
+    printf("       ./traceidx <trace.csv> tick <t>                  all trains at a tick\n");
+    printf("       ./traceidx <trace.csv> cell <x> <y> [<from> <to>] visits to a cell\n");
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        printUsage();
+        return 1;
+    }
+    const char* tracePath = argv[1];
+    const char* command = argv[2];
+    char indexPath[1024];
+    snprintf(indexPath, sizeof(indexPath), "%s.idx", tracePath);
+
+    // Arguments after the command
+    int values[4] = { 0, 0, 0, 0 };
+    int count = argc - 3;
+    if (count > 4) count = 4;
+    for (int a = 0; a < count; a++) values[a] = atoi(argv[3 + a]);
+
+    bool build = strcmp(command, "build") == 0;
+    if (build && !buildTraceIndex(tracePath, indexPath)) return 1;
+    if (!loadTraceIndex(tracePath, indexPath)) {
+        printf("Error: Could not open index %s\n", indexPath);
+        return 1;
+    }
+
+    if (build || strcmp(command, "info") == 0) {
+        printf("Index: %s\n", indexPath);
+        printf("Rows: %ld\n", getIndexedRows());
+        printf("Ticks: %d\n", getIndexedTicks());
+        printf("Trains: %d\n", getIndexedTrains());
+        printf("Runs: %ld\n", getIndexedRuns());
+    } else if (strcmp(command, "train") == 0 && (count == 1 || count == 3)) {
+        int from = (count == 3) ? values[1] : 0;
+        int to = (count == 3) ? values[2] : INT_MAX;
+        queryTraceTrain(values[0], from, to, stdout);
+    } else if (strcmp(command, "tick") == 0 && count == 1) {
+        queryTraceTick(values[0], stdout);
+    } else if (strcmp(command, "cell") == 0 && (count == 2 || count == 4)) {
+        int from = (count == 4) ? values[2] : 0;
+        int to = (count == 4) ? values[3] : INT_MAX;
+        queryTraceCell(values[0], values[1], from, to, stdout);
+    } else {
+        printUsage();
+        closeTraceIndex();
+        return 1;
+    }
+
+    closeTraceIndex();
+    return 0;
+}
@@ -14,13 +14,14 @@
 static sf::RenderWindow* g_window = nullptr;
 static sf::Font g_font;
 
-// Sprite data - simple arrays
-static sf::Texture g_textures[5];
-static sf::Sprite g_sprites[5];
+// Sprite data - all sheets packed side by side into one atlas texture
+static sf::Texture g_atlas;
+static sf::VertexArray g_batch(sf::Quads);
 static bool g_loaded[5];
 static const int NUM_SPRITES = 5;
 static const int NUM_ROWS = 3;
 static const int NUM_COLS = NUM_SPRITES;
+static const int ATLAS_CELL = 256; // Each 1024px sheet is reduced to this size
 
 // Grid rendering parameters
 static const float SPRITE_SIZE = 40.0f;
@@ -41,22 +42,33 @@ bool initializeApp() {
     
     g_window->setFramerateLimit(60);
     
-    // Load sprites and scale to 40x40px
+    // Load sprites and pack them into one atlas (one cell per sheet)
+    sf::Image atlas;
+    atlas.create(ATLAS_CELL * NUM_SPRITES, ATLAS_CELL, sf::Color::Transparent);
     for (int i = 0; i < NUM_SPRITES; i++) {
         char path[50];
         sprintf(path, "Sprites/%d.png", i + 1);
         
-        if (g_textures[i].loadFromFile(path)) {
-            g_sprites[i].setTexture(g_textures[i]);
-            
-            // Get texture size and calculate scale to make it 40x40px
-            sf::Vector2u texSize = g_textures[i].getSize();
-            float scaleX = SPRITE_SIZE / texSize.x;
-            float scaleY = SPRITE_SIZE / texSize.y;
-            g_sprites[i].setScale(scaleX, scaleY);
-            
-            // Set origin to center for rotations
-            g_sprites[i].setOrigin(texSize.x / 2.0f, texSize.y / 2.0f);
+        sf::Image sheet;
+        if (sheet.loadFromFile(path)) {
+            // Box-filter the sheet down to ATLAS_CELL x ATLAS_CELL
+            sf::Vector2u texSize = sheet.getSize();
+            for (int y = 0; y < ATLAS_CELL; y++) {
+                for (int x = 0; x < ATLAS_CELL; x++) {
+                    unsigned x0 = x * texSize.x / ATLAS_CELL, x1 = (x + 1) * texSize.x / ATLAS_CELL;
+                    unsigned y0 = y * texSize.y / ATLAS_CELL, y1 = (y + 1) * texSize.y / ATLAS_CELL;
+                    unsigned r = 0, g = 0, b = 0, a = 0, n = 0;
+                    for (unsigned sy = y0; sy < y1; sy++) {
+                        for (unsigned sx = x0; sx < x1; sx++) {
+                            sf::Color p = sheet.getPixel(sx, sy);
+                            r += p.r; g += p.g; b += p.b; a += p.a; n++;
+                        }
+                    }
+                    if (n > 0) {
+                        atlas.setPixel(i * ATLAS_CELL + x, y, sf::Color(r / n, g / n, b / n, a / n));
+                    }
+                }
+            }
             g_loaded[i] = true;
         } else {
             std::cerr << "Failed to load: " << path << std::endl;
@@ -64,9 +76,36 @@ bool initializeApp() {
         }
     }
     
+    if (!g_atlas.loadFromImage(atlas)) {
+        return false;
+    }
+    g_atlas.setSmooth(true);
+    
     return true;
 }
 
+// ----------------------------------------------------------------------------
+// BATCHING
+// ----------------------------------------------------------------------------
+// Appends one sprite to the batch as a quad. The sprite is centred on (x, y),
+// scaled and rotated on the CPU, and textured from its cell of the atlas.
+// ----------------------------------------------------------------------------
+void appendSprite(int index, float x, float y, float scale, float rotation) {
+    sf::Transform transform;
+    transform.translate(x, y);
+    transform.rotate(rotation);
+    transform.scale(scale, scale);
+
+    float half = SPRITE_SIZE / 2.0f;
+    float u = (float)(index * ATLAS_CELL);
+    float cell = (float)ATLAS_CELL;
+
+    g_batch.append(sf::Vertex(transform.transformPoint(-half, -half), sf::Vector2f(u, 0.0f)));
+    g_batch.append(sf::Vertex(transform.transformPoint(half, -half), sf::Vector2f(u + cell, 0.0f)));
+    g_batch.append(sf::Vertex(transform.transformPoint(half, half), sf::Vector2f(u + cell, cell)));
+    g_batch.append(sf::Vertex(transform.transformPoint(-half, half), sf::Vector2f(u, cell)));
+}
+
 // ----------------------------------------------------------------------------
 // RENDER FUNCTIONS FOR EACH TRANSFORMATION TYPE
 // ----------------------------------------------------------------------------
@@ -76,16 +115,7 @@ void renderRow0_Original(int row) {
         if (g_loaded[col]) {
             float x = g_offsetX + SPRITE_SIZE/2 + col * g_spacingX;
             float y = g_offsetY + SPRITE_SIZE/2 + row * g_spacingY;
-            g_sprites[col].setPosition(x, y);
-            g_sprites[col].setRotation(0);
-            
-            // Reset to base scale (40x40px)
-            sf::Vector2u texSize = g_textures[col].getSize();
-            float baseScaleX = SPRITE_SIZE / texSize.x;
-            float baseScaleY = SPRITE_SIZE / texSize.y;
-            g_sprites[col].setScale(baseScaleX, baseScaleY);
-            g_sprites[col].setColor(sf::Color::White);
-            g_window->draw(g_sprites[col]);
+            appendSprite(col, x, y, 1.0f, 0.0f);
         }
     }
 }
@@ -96,16 +126,7 @@ void renderRow1_Zoom(int row) {
         if (g_loaded[col]) {
             float x = g_offsetX + SPRITE_SIZE/2 + col * g_spacingX;
             float y = g_offsetY + SPRITE_SIZE/2 + row * g_spacingY;
-            g_sprites[col].setPosition(x, y);
-            g_sprites[col].setRotation(0);
-            
-            // Apply 2x zoom
-            sf::Vector2u texSize = g_textures[col].getSize();
-            float baseScaleX = SPRITE_SIZE / texSize.x;
-            float baseScaleY = SPRITE_SIZE / texSize.y;
-            g_sprites[col].setScale(baseScaleX * 2.0f, baseScaleY * 2.0f);
-            g_sprites[col].setColor(sf::Color::White);
-            g_window->draw(g_sprites[col]);
+            appendSprite(col, x, y, 2.0f, 0.0f);
         }
     }
 }
@@ -116,16 +137,7 @@ void renderRow2_Rotation(int row) {
         if (g_loaded[col]) {
             float x = g_offsetX + SPRITE_SIZE/2 + col * g_spacingX;
             float y = g_offsetY + SPRITE_SIZE/2 + row * g_spacingY;
-            g_sprites[col].setPosition(x, y);
-            g_sprites[col].setRotation(45.0f);
-            
-            // Reset to base scale (40x40px)
-            sf::Vector2u texSize = g_textures[col].getSize();
-            float baseScaleX = SPRITE_SIZE / texSize.x;
-            float baseScaleY = SPRITE_SIZE / texSize.y;
-            g_sprites[col].setScale(baseScaleX, baseScaleY);
-            g_sprites[col].setColor(sf::Color::White);
-            g_window->draw(g_sprites[col]);
+            appendSprite(col, x, y, 1.0f, 45.0f);
         }
     }
 }
@@ -150,11 +162,15 @@ void runApp() {
         // Clear window
         g_window->clear(sf::Color(30, 30, 40));
         
-        // Render 3 rows with different transformations
+        // Render 3 rows with different transformations into one batch
+        g_batch.clear();
         renderRow0_Original(0);
         renderRow1_Zoom(1);
         renderRow2_Rotation(2);
         
+        // Single draw call for all sprites
+        g_window->draw(g_batch, sf::RenderStates(&g_atlas));
+        
         // Display
         g_window->display();
     }